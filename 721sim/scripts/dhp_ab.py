@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+#
+# A/B evaluation of Dynamic Hammock Predication.
+#
+# Runs a baseline and a predicated (--dhp) configuration of the simulator
+# concurrently, as two separate processes, from the same checkpoint (-c) or
+# skip point (-s). Each run gets its own working directory, since the
+# simulator writes its stats/phase logs to the current directory.
+#
+# The phase logs of the two runs are aligned by retired-instruction count
+# (commit_count, which excludes CMOVs and deactivated instructions), and the
+# harness reports per-phase and total:
+#   - speedup           = baseline cycles / predicated cycles
+#   - misp. reduction   = 1 - predicated mispredictions / baseline mispredictions
+#                         (predicated mispredictions include hammock recoveries
+#                         after predicate mispredictions, pp_recovery_count)
+#   - fetch overhead    = predicated fetched instructions / baseline fetched instructions - 1
+#
+# Example:
+#   dhp_ab.py --sim ./721sim --dhp ../benchmarks/hmmer/hmmer_dhp.txt -s 1000000 -e 10000000 \
+#             --phase 1000000 --out ab_hmmer -- pk hmmer.riscv <args>
+#
+
+import argparse
+import glob
+import os
+import re
+import subprocess
+import sys
+
+
+def parse_args():
+    p = argparse.ArgumentParser(description="Run baseline and DHP configurations side-by-side and compare them.")
+    p.add_argument("--sim", required=True, help="path to the simulator binary")
+    p.add_argument("--dhp", required=True, help="hammock table for the predicated run")
+    p.add_argument("-c", dest="chkpt", default=None, help="start both runs from this .gz checkpoint")
+    p.add_argument("-s", dest="skip", default=None, help="fast skip this many instructions in both runs")
+    p.add_argument("-e", dest="stop", default=None, help="end both runs after this many committed instructions")
+    p.add_argument("--phase", default=None, help="phase interval, in committed instructions")
+    p.add_argument("--opts", default="", help="simulator options common to both runs")
+    p.add_argument("--dhp-opts", default="", help="additional simulator options for the predicated run only, e.g. --ppred=12,8,8")
+    p.add_argument("--out", default="dhp_ab", help="output directory (baseline/ and dhp/ subdirectories are created)")
+    p.add_argument("target", nargs=argparse.REMAINDER, help="-- <target program> [target options]")
+    args = p.parse_args()
+    if args.target and args.target[0] == "--":
+        args.target = args.target[1:]
+    if not args.target:
+        p.error("missing target program")
+    return args
+
+
+def absolute_if_exists(path):
+    return os.path.abspath(path) if os.path.exists(path) else path
+
+
+def sim_command(args, predicated):
+    cmd = [os.path.abspath(args.sim)]
+    cmd += args.opts.split()
+    if args.chkpt:
+        cmd.append("-c" + os.path.abspath(args.chkpt))
+    elif args.skip:
+        cmd.append("-s" + args.skip)
+    if args.stop:
+        cmd.append("-e" + args.stop)
+    if args.phase:
+        cmd.append("--phase=" + args.phase)
+    if predicated:
+        cmd.append("--dhp=" + os.path.abspath(args.dhp))
+        cmd += args.dhp_opts.split()
+    cmd += [absolute_if_exists(t) for t in args.target]
+    return cmd
+
+
+def latest(rundir, prefix):
+    logs = sorted(glob.glob(os.path.join(rundir, prefix + ".*.log")), key=os.path.getmtime)
+    if not logs:
+        sys.exit("error: no %s log in %s" % (prefix, rundir))
+    return logs[-1]
+
+
+# Returns a list of {counter: value} dictionaries, one per phase.
+def parse_phase_log(path):
+    phases = []
+    current = None
+    with open(path) as f:
+        for line in f:
+            if line.startswith("-------- Phase Counters"):
+                current = {}
+                phases.append(current)
+            elif line.startswith("-------- Phase Rates"):
+                current = None
+            elif current is not None:
+                m = re.match(r"\s*(\w+)\s*:\s*(\d+)", line)
+                if m:
+                    current[m.group(1)] = int(m.group(2))
+    return phases
+
+
+# Returns the {counter: value} dictionary of the [stats] section.
+def parse_stats_log(path):
+    stats = {}
+    section = None
+    with open(path) as f:
+        for line in f:
+            if line.startswith("["):
+                section = line.strip()
+            elif section == "[stats]":
+                m = re.match(r"\s*(\w+)\s*:\s*(\d+)", line)
+                if m:
+                    stats[m.group(1)] = int(m.group(2))
+    return stats
+
+
+# Align phases by cumulative commit_count. Phases that end at the same
+# retired-instruction count are paired; a phase boundary present in only one
+# run is merged into the next common boundary.
+def align(base, dhp):
+    aligned = []
+    i = j = 0
+    b_acc, d_acc = {}, {}
+    b_commit = d_commit = 0
+
+    def add(acc, phase):
+        for k, v in phase.items():
+            acc[k] = acc.get(k, 0) + v
+
+    while i < len(base) and j < len(dhp):
+        if b_commit <= d_commit:
+            add(b_acc, base[i])
+            b_commit += base[i].get("commit_count", 0)
+            i += 1
+        else:
+            add(d_acc, dhp[j])
+            d_commit += dhp[j].get("commit_count", 0)
+            j += 1
+        if b_commit == d_commit and b_acc and d_acc:
+            aligned.append((b_commit, b_acc, d_acc))
+            b_acc, d_acc = {}, {}
+    return aligned
+
+
+def ratio(n, d):
+    return (float(n) / float(d)) if d else 0.0
+
+
+def report_line(label, b, d):
+    speedup = ratio(b.get("cycle_count", 0), d.get("cycle_count", 0))
+    b_misp = b.get("mispredict_count", 0)
+    d_misp = d.get("mispredict_count", 0) + d.get("pp_recovery_count", 0)
+    misp_red = 100.0 * (1.0 - ratio(d_misp, b_misp)) if b_misp else 0.0
+    overhead = 100.0 * (ratio(d.get("fetched_inst_count", 0), b.get("fetched_inst_count", 0)) - 1.0)
+    print("%-14s %12d %12d %8.3f %10d %10d %8.2f%% %8.2f%%" %
+          (label, b.get("cycle_count", 0), d.get("cycle_count", 0), speedup, b_misp, d_misp, misp_red, overhead))
+
+
+def main():
+    args = parse_args()
+
+    runs = {}
+    for name, predicated in (("baseline", False), ("dhp", True)):
+        rundir = os.path.join(args.out, name)
+        os.makedirs(rundir, exist_ok=True)
+        cmd = sim_command(args, predicated)
+        out = open(os.path.join(rundir, "sim.out"), "w")
+        print("[%s] %s" % (name, " ".join(cmd)))
+        runs[name] = (rundir, subprocess.Popen(cmd, cwd=rundir, stdout=out, stderr=subprocess.STDOUT), out)
+
+    for name, (rundir, proc, out) in runs.items():
+        proc.wait()
+        out.close()
+        if proc.returncode not in (0, 1):
+            print("warning: %s run exited with code %d (see %s)" % (name, proc.returncode, os.path.join(rundir, "sim.out")))
+
+    base_dir, dhp_dir = runs["baseline"][0], runs["dhp"][0]
+    aligned = align(parse_phase_log(latest(base_dir, "phase")), parse_phase_log(latest(dhp_dir, "phase")))
+    base_total = parse_stats_log(latest(base_dir, "stats"))
+    dhp_total = parse_stats_log(latest(dhp_dir, "stats"))
+
+    print("")
+    print("%-14s %12s %12s %8s %10s %10s %9s %9s" %
+          ("retired", "base_cycles", "dhp_cycles", "speedup", "base_misp", "dhp_misp", "misp_red", "fetch_ovh"))
+    for commit, b, d in aligned:
+        report_line(str(commit), b, d)
+    report_line("total", base_total, dhp_total)
+
+    if base_total.get("commit_count", 0) != dhp_total.get("commit_count", 0):
+        print("warning: runs retired different instruction counts (%d vs. %d); totals are not directly comparable" %
+              (base_total.get("commit_count", 0), dhp_total.get("commit_count", 0)))
+
+
+if __name__ == "__main__":
+    main()
@@ -19,21 +19,31 @@
 #include "pipeline.h"
 #include "stats.h"
 #include "parameters.h"
+#include "prefetch.h"
+#include "dram.h"
+#include "coherence.h"
 
 CacheClass::CacheClass(int sets, int assoc, int _lineSize,
                        int _hitLatency, int _missLatency,
                        int _numMHSR, int _numMissSrvPorts,  int _missSrvLatency,
+                       repl_policy_e _repl,
                        pipeline_t* _proc, const char* _identifier, 
                        CacheClass* _nextLevel, int histLen)
 	: proc(_proc),
-    array(sets, assoc),  // Allocate cache array.
+    array(sets, assoc, _repl),  // Allocate cache array.
     nextLevel(_nextLevel),
+    prefetcher(NULL),
+    memory(NULL),
+    directory(NULL),
+    core(0),
     lineSize(_lineSize),
     hitLatency(_hitLatency),
     missLatency(_missLatency),
 	  numMHSR(_numMHSR),
 	  numMissSrvPorts(_numMissSrvPorts),
-	  missSrvLatency(_missSrvLatency)
+	  missSrvLatency(_missSrvLatency),
+	  numWBB(0),
+	  wbbAvail(NULL)
 	  /*------------------------------------------------------------------------*\
 	   | Constructor.  Allocates data structures and initializes D-cache state.
 	   |
@@ -50,6 +60,7 @@ CacheClass::CacheClass(int sets, int assoc, int _lineSize,
 	   |                  cycle (number of ports to the backing store.)
 	   |  missSrvLatency     The number of cycles before a miss service port can be
 	   |                  reused (port pipeline latency).
+	   |  repl           The replacement policy.
 	  \*------------------------------------------------------------------------*/
 {
 	int i;
@@ -67,17 +78,39 @@ CacheClass::CacheClass(int sets, int assoc, int _lineSize,
 		mhsr[i].busy = false;
 	}
 
+	/* All MHSRs are free. */
+	mhsrFree = new uint64_t[(numMHSR + 63) / 64];
+	for (i=0; i<((numMHSR + 63) / 64); i++) {
+		mhsrFree[i] = 0;
+	}
+	for (i=0; i<numMHSR; i++) {
+		mhsrFree[i >> 6] |= ((uint64_t)1 << (i & 63));
+	}
+	numFreeMHSR = numMHSR;
+	earlyHeap = new int[numMHSR];
+	earlyPos = new int[numMHSR];
+	for (i=0; i<numMHSR; i++) {
+		earlyPos[i] = -1;
+	}
+	numEarly = 0;
+
 	/* Allocate miss service ports. */
 	missPortAvail = new cycle_t[numMissSrvPorts];
 	assert(missPortAvail);
+	portHeap = new int[numMissSrvPorts];
+	portPos = new int[numMissSrvPorts];
 	for (i=0; i<numMissSrvPorts; i++) {
 		missPortAvail[i]=0;
+		portHeap[i] = i;
+		portPos[i] = i;
 	}
 
   this->stats = proc->get_stats();
 
   assert(stats);
 
+  accessLatency = new LogHistogramClass();
+
 #if 0
   stats->register_counter((identifier+"_load_count").c_str()        ,identifier.c_str());
   stats->register_counter((identifier+"_store_count").c_str()       ,identifier.c_str());
@@ -112,15 +145,22 @@ CacheClass::~CacheClass()
  | Destructor.  Frees memory used by D-cache.
 \*------------------------------------------------------------------------*/
 {
+	delete accessLatency;
 	delete [] mhsr;
+	delete [] mhsrFree;
+	delete [] earlyHeap;
+	delete [] earlyPos;
 	delete [] missPortAvail;
+	delete [] portHeap;
+	delete [] portPos;
+	delete [] wbbAvail;
 
 }
 
 cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
                              cycle_t curCycle, reg_t addr,
                              bool isStore, bool* isHit,
-                             bool probe, bool commit)
+                             bool probe, bool commit, reg_t pc)
 /*------------------------------------------------------------------------*\
  | Access the data cache.  Determines how many cycles access will take.
  |
@@ -134,6 +174,9 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
  |  addr              The address of the word being accessed.
  |  isStore           Indicates whether the access is a store (true) or
  |                     load (false).
+ |  pc                The PC of the load or store, for training the
+ |                     prefetcher. 0 if the access is not a demand access
+ |                     (e.g., a writeback), which does not train it.
  |
  | Returns the cycle when the access will complete.  Returns -1 if the
  |  access can not be handled, due to limited miss handleing status
@@ -141,25 +184,32 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 \*------------------------------------------------------------------------*/
 {
 	bool hit;
+	bool miss;
+	bool pfHit = false;
 	reg_t lineAddr;
 	reg_t oldAddr;
 	CacheLineClass* line;
-	CacheLineClass* newLine;
 	int busyMHSR;
 	int newMHSR;
-	int newPort;
-	cycle_t portAvail;
 	cycle_t lineInArray;
+	cycle_t upgradeCycle = 0;
+	coh_result_t coh;
 
 //	assert (curCycle >= lastCycle);
 //	lastCycle = curCycle;
 
+	// With a directory, memory is shared by the cores: lines are not
+	// tagged with the thread.
+	if (directory)
+		Tid = 0;
+
 	// ER 11/16/02
 	//lineAddr = addr >> lineSize;
 	assert((Tid < 4) && (lineSize >= 2));
 	lineAddr = ((addr >> lineSize) | (Tid << 30));
 
 	line = array.lookup(lineAddr, NULL, &hit, &oldAddr, false);
+	miss = !hit;
 
 	if (probe) {
 		(*isHit) = hit;
@@ -180,6 +230,25 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 			line->dirty = true;
 		}
 
+		// A store to a shared line must get it exclusive first (upgrade).
+		if (directory && isStore && !line->exclusive) {
+			line->exclusive = true;
+			coh = directory->request(core, lineAddr, true);
+			upgradeCycle = curCycle + coh.latency;
+			inc_counter_str((identifier+"_coh_upgrade_count").c_str());
+			if (coh.invalidations)
+				inc_counter_str((identifier+"_coh_inv_count").c_str());
+		}
+
+		// Check if this is the first reference to a prefetched line.
+		if (commit && line->prefetched) {
+			line->prefetched = false;
+			pfHit = true;
+			inc_counter_str((identifier+"_pf_useful_count").c_str());
+			if ((line->mhsr != -1) && (mhsr[line->mhsr].resolved > curCycle))
+				inc_counter_str((identifier+"_pf_late_count").c_str());
+		}
+
 		// Check if line is currently being loaded (is busy).
 		busyMHSR = line->mhsr;
 		if (busyMHSR != -1) {
@@ -190,6 +259,8 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 			if (mhsr[busyMHSR].resolved <= curCycle) {
 				lineInArray = curCycle;
 				line->mhsr = -1;
+				FreeMHSR(busyMHSR);
+				RemoveEarlyMHSR(busyMHSR);
 				mhsr[busyMHSR].resolved = 0;
         		mhsr[busyMHSR].busy = false;
 			}
@@ -226,66 +297,152 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
       inc_counter_str((identifier+"_load_miss_count").c_str());
     }
 
-		// Allocate MHSR to handle cache miss.
-    // Return error value if no free MHSR
-    // is found. The previous level will
-    // retry later.
-		newMHSR = FindFreeMHSR(curCycle);
-		if (newMHSR == -1) {
-		   if (isHit != NULL)
-		      (*isHit) = false;
+		// The line may still be in flight after it has been replaced, if
+		//  it is accessed at an earlier cycle than the replacement (the
+		//  next level is accessed at future cycles). Merge with its MHSR.
+		std::unordered_map<reg_t,int>::iterator it = inflight.find(lineAddr);
+		if ((it != inflight.end()) && (mhsr[it->second].resolved > (int64_t)curCycle)) {
+			inc_counter_str((identifier+"_mhsr_merge_count").c_str());
+			lineInArray = mhsr[it->second].resolved;
+			if ((lineInArray - curCycle) < hitLatency) {
+				lineInArray = curCycle + hitLatency;
+			}
+		}
+		else {
+			// Allocate MHSR to handle cache miss.
+			// Return error value if no free MHSR
+			// is found. The previous level will
+			// retry later.
+			newMHSR = FindFreeMHSR(curCycle);
+			if (newMHSR == -1) {
+			   if (isHit != NULL)
+			      (*isHit) = false;
+
+			   return(-1);
+			}
+			//if (newMHSR == -1) return(-1);
+			//if (newMHSR == -1) {
+			//	assert(0);
+			//}
 
-		   return(-1);
+			inc_counter_str((identifier+"_demand_miss_count").c_str());
+			lineInArray = Fill(Tid, curCycle, addr, lineAddr, newMHSR, isStore, commit, false, pc);
 		}
-		//if (newMHSR == -1) return(-1);
-		//if (newMHSR == -1) {
-		//	assert(0);
-		//}
-
-		// Find the miss port to use for handling the miss.
-		newPort = FindNextPort(curCycle, &portAvail);
-
-		// Allocate a new cache line structure.
-		if (commit) {
-			// Allocate a new cache line structure.
-			newLine = new CacheLineClass;
-			assert(newLine);
-			newLine -> mhsr = newMHSR;
-			newLine -> dirty = isStore;
-
-			// Replace the old line in the cache.
-			line = array.lookup(lineAddr, newLine, &hit, &oldAddr, true);
+	}
+
+	if (upgradeCycle > lineInArray) {
+		lineInArray = upgradeCycle;
+	}
+
+	if (isHit!=NULL) {
+		(*isHit) = (lineInArray == curCycle);
+	}
+
+	// Train the prefetcher on demand accesses, and issue its prefetches.
+	if (prefetcher && commit && (pc != 0)) {
+		uint64_t pfLines[PF_MAX_DEGREE];
+		unsigned int n = prefetcher->train(pc, addr, miss, pfHit, pfLines);
+		for (unsigned int i = 0; i < n; i++)
+			Prefetch(Tid, curCycle, pfLines[i], pc);
+	}
+
+  //LOG(proc->lsu_log,proc->cycle,uint64_t(0),uint64_t(0),"Executed %s which %s resolve cycle %" PRIcycle "",isStore?"store":"load",isHit?"hit":"miss",(lineInArray+hitLatency));
+
+	if (!isStore) {
+		accessLatency->Increment(lineInArray + hitLatency - curCycle);
+	}
+
+	return(lineInArray + hitLatency);
+}
+
+cycle_t CacheClass::Fill(unsigned int Tid, cycle_t curCycle, reg_t addr, reg_t lineAddr,
+                         int newMHSR, bool isStore, bool commit, bool prefetch, reg_t pc)
+/*------------------------------------------------------------------------*\
+ | Load the line "lineAddr" (containing "addr") into the cache after a
+ |  demand miss or for a prefetch, using MHSR "newMHSR".
+ |
+ | Returns the cycle when the line will be in the array.
+\*------------------------------------------------------------------------*/
+{
+	bool hit;
+	reg_t oldAddr;
+	CacheLineClass* line = NULL;
+	CacheLineClass newLine;
+	int busyMHSR;
+	int newPort;
+	cycle_t portAvail;
+	cycle_t lineInArray;
+	cycle_t reqCycle;
+	coh_result_t coh = {false, false, 0, 0};
+	std::unordered_map<reg_t,int>::iterator it;
+
+	// Find the miss port to use for handling the miss.
+	newPort = FindNextPort(curCycle, &portAvail);
+
+	if (commit) {
+		// Get the line from the other cores' L1s, if they hold it.
+		if (directory) {
+			coh = directory->request(core, lineAddr, isStore);
+			if (coh.c2c)
+				inc_counter_str((identifier+"_coh_c2c_count").c_str());
+			if (coh.invalidations)
+				inc_counter_str((identifier+"_coh_inv_count").c_str());
 		}
 
-		// Compute the time to load the new line from the next memory level.
+		// Set up the new cache line's state.
+		newLine.mhsr = newMHSR;
+		newLine.dirty = isStore;
+		newLine.prefetched = prefetch;
+		newLine.exclusive = coh.exclusive;
+
+		// Replace the old line in the cache.
+		// "line" is now a copy of the old line's state, if it was valid.
+		line = array.lookup(lineAddr, &newLine, &hit, &oldAddr, true);
+	}
+
+	// Compute the time to load the new line from the next memory level.
     // Added curCycle: RBRC 04/04/2015
-		lineInArray = (portAvail < curCycle) ? curCycle : portAvail;
-		//lineInArray = portAvail;
+	lineInArray = (portAvail < curCycle) ? curCycle : portAvail;
+	//lineInArray = portAvail;
 
-		// Must wait for hit latency cycles before beginning line load.
-		if ((lineInArray-curCycle) < hitLatency) {
-			lineInArray = curCycle + hitLatency;
-		}
+	// Must wait for hit latency cycles before beginning line load.
+	if ((lineInArray-curCycle) < hitLatency) {
+		lineInArray = curCycle + hitLatency;
+	}
 
-		// See if line being replaced is itself still being loaded.
-		if (commit && (line !=NULL)) {
-			busyMHSR = line->mhsr;
-			if (busyMHSR != -1) {
-				// Line being replaced is being loaded.  Must wait until this
-				//  line has been loaded to replace it.
-				//  NOTE: There is a slight simulation approximation made here.
-				//        The miss port is being tied up for the entire time,
-				//        but will not actually be used until later.
-				if (mhsr[busyMHSR].resolved > lineInArray) {
-					lineInArray = mhsr[busyMHSR].resolved;
-				}
+	// See if line being replaced is itself still being loaded.
+	if (commit && (line !=NULL)) {
+		if (line->prefetched)
+			inc_counter_str((identifier+"_pf_useless_count").c_str());
+
+		if (directory)
+			directory->evict(core, oldAddr);
+
+		busyMHSR = line->mhsr;
+		if (busyMHSR != -1) {
+			// Line being replaced is being loaded.  Must wait until this
+			//  line has been loaded to replace it.
+			//  NOTE: There is a slight simulation approximation made here.
+			//        The miss port is being tied up for the entire time,
+			//        but will not actually be used until later.
+			if (mhsr[busyMHSR].resolved > lineInArray) {
+				lineInArray = mhsr[busyMHSR].resolved;
 			}
+		}
 
-			// See if line is dirty.  Line must be written back, if dirty.
-			if (line->dirty) {
+		// See if line is dirty.  Line must be written back, if dirty.
+		if (line->dirty && (numWBB > 0)) {
+        inc_counter_str((identifier+"_read_access_count").c_str());
+        lineInArray = Writeback(Tid, curCycle, lineInArray, newPort, ((oldAddr ^ ((reg_t)Tid << 30)) << lineSize));
+		}
+		else if (line->dirty) {
         inc_counter_str((identifier+"_read_access_count").c_str());
         if(nextLevel == NULL){
-				  lineInArray = lineInArray + missLatency;
+          // The victim goes to its own bank and row, not the new line's.
+          if (memory)
+            lineInArray = memory->access(lineInArray, ((oldAddr ^ ((reg_t)Tid << 30)) << lineSize), true);
+          else
+			    lineInArray = lineInArray + missLatency;
         } else {
           // lineInArray is when the next level access will start.
           // The next level does its calculation assuming lineinArray
@@ -294,25 +451,29 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
           // Must wait for writeBack to be acknowledged, which happens
           // after accessing the next level. It is assumed that writeback
           // uses a seprate port to next level than the allocate port.
-				  lineInArray = nextLevel->Access(Tid,lineInArray,addr,true,&hit);
+			  lineInArray = nextLevel->Access(Tid,lineInArray,addr,true,&hit);
           assert(lineInArray > curCycle);
         }
-			}
 		}
+	}
 
-		// Allocate miss port.
-		missPortAvail[newPort] = lineInArray + missSrvLatency;
+	// Allocate miss port.
+	SetPortAvail(newPort, lineInArray + missSrvLatency);
 
-		// Add miss latency to access time.
+	// Add miss latency to access time.
+	reqCycle = lineInArray;
     if(nextLevel == NULL){
-  		lineInArray = lineInArray + missLatency;
+      if (memory)
+        lineInArray = memory->access(lineInArray, addr, false);
+      else
+  		  lineInArray = lineInArray + missLatency;
     } else {
       // lineInArray is when the next level access will start.
       // The next level does its calculation assuming lineinArray
       // as it's access cycle and returns when the line becomes 
       // available for access.
       // This is always a read from the next level as this is a WBWA cache model. 
-  		lineInArray = nextLevel->Access(Tid,lineInArray,addr,false,&hit);
+  		lineInArray = nextLevel->Access(Tid,lineInArray,addr,false,&hit,false,true,pc);
       // Cannot miss in MHSR in the next level if the next level has
       // as many or more MHSRs as this level. A miss in this level can
       // be a hit or a miss in the next level. There can be numMHSR outstanding 
@@ -321,81 +482,378 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
       assert(lineInArray > curCycle);
     }
 
-		// Free old cache line, allocate miss port and MHSR.
-		// NOTE: Slight simulation approximation error here.
-		//       MHSR is being allocated this cycle, but in reality, can not
-		//       be allocated until hitLat cycles later, when miss is
-		//       known.
-		if (commit && line) {
-			delete line;
-		}
-		mhsr[newMHSR].resolved = lineInArray;
-		mhsr[newMHSR].busy = true;
-		mhsr[newMHSR].lineAddress = lineAddr;
-    inc_counter_str((identifier+"_write_access_count").c_str());
+	// Coherence: the directory is looked up in parallel with the next level.
+	// Another core's L1 may supply the line instead, or other copies may
+	// have to be invalidated first.
+	if (coh.c2c) {
+		lineInArray = reqCycle + coh.latency;
 	}
-
-	if (isHit!=NULL) {
-		(*isHit) = (lineInArray == curCycle);
+	else if (directory && (lineInArray < (reqCycle + coh.latency))) {
+		lineInArray = reqCycle + coh.latency;
 	}
 
-  //LOG(proc->lsu_log,proc->cycle,uint64_t(0),uint64_t(0),"Executed %s which %s resolve cycle %" PRIcycle "",isStore?"store":"load",isHit?"hit":"miss",(lineInArray+hitLatency));
+	// Allocate miss port and MHSR.
+	// NOTE: Slight simulation approximation error here.
+	//       MHSR is being allocated this cycle, but in reality, can not
+	//       be allocated until hitLat cycles later, when miss is
+	//       known.
+	it = inflight.find(mhsr[newMHSR].lineAddress);
+	if ((it != inflight.end()) && (it->second == newMHSR))
+		inflight.erase(it);
+	mhsr[newMHSR].resolved = lineInArray;
+	mhsr[newMHSR].busy = true;
+	mhsr[newMHSR].lineAddress = lineAddr;
+	assert(mhsrFree[newMHSR >> 6] & ((uint64_t)1 << (newMHSR & 63)));
+	mhsrFree[newMHSR >> 6] &= ~((uint64_t)1 << (newMHSR & 63));
+	numFreeMHSR--;
+	mhsrDone.push(std::make_pair(lineInArray, newMHSR));
+	inflight[lineAddr] = newMHSR;
+	inc_counter_str((identifier+"_write_access_count").c_str());
+	return(lineInArray);
+}
 
-	return(lineInArray + hitLatency);
+void CacheClass::RecordReadHit(){
+	inc_counter_str((identifier+"_load_count").c_str());
+	inc_counter_str((identifier+"_load_hit_count").c_str());
+	inc_counter_str((identifier+"_read_access_count").c_str());
+	accessLatency->Increment(hitLatency);
+}
+
+void CacheClass::dump_latency(FILE* fp){
+	fprintf(fp, "%s read latency (cycles):\n", identifier.c_str());
+	accessLatency->Print(fp);
 }
 
 void CacheClass::set_nextLevel(CacheClass* nLevel){
 	nextLevel = nLevel;
 }
 
+void CacheClass::set_prefetcher(prefetcher_t* pf){
+	prefetcher = pf;
+	if (prefetcher)
+		register_prefetch_counters();
+}
+
+void CacheClass::set_memory(dram_t* mem){
+	memory = mem;
+}
+
+void CacheClass::set_directory(directory_t* dir, unsigned int core){
+	directory = dir;
+	this->core = core;
+	directory->attach(core, this);
+	stats->register_counter((identifier+"_coh_c2c_count").c_str()        ,identifier.c_str());
+	stats->register_counter((identifier+"_coh_upgrade_count").c_str()    ,identifier.c_str());
+	stats->register_counter((identifier+"_coh_inv_count").c_str()        ,identifier.c_str());
+	stats->register_counter((identifier+"_coh_invalidated_count").c_str(),identifier.c_str());
+	stats->register_counter((identifier+"_coh_downgrade_count").c_str()  ,identifier.c_str());
+}
+
+void CacheClass::Invalidate(reg_t lineAddr){
+	std::unordered_map<reg_t,int>::iterator it;
+
+	if (array.invalidate(lineAddr))
+		inc_counter_str((identifier+"_coh_invalidated_count").c_str());
+
+	// A fill in progress no longer brings the line in.
+	it = inflight.find(lineAddr);
+	if (it != inflight.end())
+		inflight.erase(it);
+}
+
+void CacheClass::Downgrade(reg_t lineAddr){
+	CacheLineClass* line = array.probe(lineAddr);
+
+	if (line) {
+		line->exclusive = false;
+		line->dirty = false;
+		inc_counter_str((identifier+"_coh_downgrade_count").c_str());
+	}
+}
+
+void CacheClass::set_writeback_buffer(int entries){
+	assert(entries >= 0);
+	delete [] wbbAvail;
+	numWBB = entries;
+	wbbAvail = NULL;
+	if (numWBB > 0) {
+		wbbAvail = new cycle_t[numWBB];
+		for (int i = 0; i < numWBB; i++)
+			wbbAvail[i] = 0;
+		stats->register_counter((identifier+"_writeback_count").c_str()   ,identifier.c_str());
+		stats->register_counter((identifier+"_wbb_full_count").c_str()    ,identifier.c_str());
+	}
+}
+
+cycle_t CacheClass::Writeback(unsigned int Tid, cycle_t curCycle, cycle_t lineInArray, int fillPort, reg_t victimAddr)
+/*------------------------------------------------------------------------*\
+ | Move a dirty victim into the write-back buffer, to be written to the
+ |  next level in the background. The fill only has to wait if the buffer
+ |  is full, until its oldest writeback has been acknowledged.
+ |
+ | The writeback takes a miss port, after the fill's port "fillPort", and
+ |  goes to the next level as a separate store.
+ |
+ | Returns the cycle when the new line can start loading.
+\*------------------------------------------------------------------------*/
+{
+	bool hit;
+	int entry;
+	int wbPort;
+	cycle_t portAvail;
+	cycle_t wbStart;
+
+	// Get the buffer entry freed first.
+	entry = 0;
+	for (int i = 1; i < numWBB; i++) {
+		if (wbbAvail[i] < wbbAvail[entry])
+			entry = i;
+	}
+	if (wbbAvail[entry] > lineInArray) {
+		inc_counter_str((identifier+"_wbb_full_count").c_str());
+		lineInArray = wbbAvail[entry];
+	}
+
+	// Reserve the fill's port, so that the writeback can not take it.
+	SetPortAvail(fillPort, lineInArray + missSrvLatency);
+	wbPort = FindNextPort(lineInArray, &portAvail);
+	wbStart = (portAvail < lineInArray) ? lineInArray : portAvail;
+	SetPortAvail(wbPort, wbStart + missSrvLatency);
+
+	if (nextLevel == NULL) {
+		if (memory)
+			wbbAvail[entry] = memory->access(wbStart, victimAddr, true);
+		else
+			wbbAvail[entry] = wbStart + missLatency;
+	}
+	else {
+		wbbAvail[entry] = nextLevel->Access(Tid, wbStart, victimAddr, true, &hit);
+		assert(wbbAvail[entry] > curCycle);
+	}
+
+	inc_counter_str((identifier+"_writeback_count").c_str());
+	return(lineInArray);
+}
+
+void CacheClass::register_prefetch_counters(){
+	stats->register_counter((identifier+"_demand_miss_count").c_str(),identifier.c_str());
+	stats->register_counter((identifier+"_pf_issued_count").c_str()  ,identifier.c_str());
+	stats->register_counter((identifier+"_pf_dropped_count").c_str() ,identifier.c_str());
+	stats->register_counter((identifier+"_pf_useful_count").c_str()  ,identifier.c_str());
+	stats->register_counter((identifier+"_pf_late_count").c_str()    ,identifier.c_str());
+	stats->register_counter((identifier+"_pf_useless_count").c_str() ,identifier.c_str());
+}
+
+bool CacheClass::Prefetch(unsigned int Tid, cycle_t curCycle, reg_t line, reg_t pc)
+/*------------------------------------------------------------------------*\
+ | Prefetch the line "line" (address >> lineSize), unless it is already
+ |  in the cache or being loaded. Returns true if the prefetch was issued.
+ |
+ | A prefetch only gets an MHSR if more than half of this cache's MHSRs,
+ |  and of the next level's, are free. The rest are left for demand misses,
+ |  which assume that the next level has a free MHSR for them.
+\*------------------------------------------------------------------------*/
+{
+	reg_t lineAddr;
+	int newMHSR;
+	std::unordered_map<reg_t,int>::iterator it;
+
+	// Probe, rather than look up, the line: a prefetch that is dropped or redundant leaves the
+	//  replacement state and miss count as they were.
+	lineAddr = (line | (Tid << 30));
+	it = inflight.find(lineAddr);
+	if (array.probe(lineAddr) || ((it != inflight.end()) && (mhsr[it->second].resolved > (int64_t)curCycle)))
+		return(false);
+
+	if ((CountFreeMHSRs(curCycle) <= (numMHSR/2)) ||
+	    (nextLevel && (nextLevel->CountFreeMHSRs(curCycle) <= (nextLevel->numMHSR/2)))) {
+		inc_counter_str((identifier+"_pf_dropped_count").c_str());
+		return(false);
+	}
+
+	newMHSR = FindFreeMHSR(curCycle);
+	assert(newMHSR != -1);
+	Fill(Tid, curCycle, (line << lineSize), lineAddr, newMHSR, false, true, true, pc);
+	inc_counter_str((identifier+"_pf_issued_count").c_str());
+	return(true);
+}
+
+void CacheClass::FreeMHSR(int i)
+/*------------------------------------------------------------------------*\
+ | Mark MHSR "i" free. The MHSR keeps its state (busy, resolved,
+ |  lineAddress), and its line stays in flight, until it is reused: see
+ |  FindFreeMHSR and Fill.
+\*------------------------------------------------------------------------*/
+{
+	if (mhsrFree[i >> 6] & ((uint64_t)1 << (i & 63)))
+		return;
+	mhsrFree[i >> 6] |= ((uint64_t)1 << (i & 63));
+	numFreeMHSR++;
+}
+
+void CacheClass::RetireMHSRs(cycle_t curCycle)
+/*------------------------------------------------------------------------*\
+ | Free the MHSRs whose misses completed before "curCycle".
+\*------------------------------------------------------------------------*/
+{
+	while (!mhsrDone.empty() && (mhsrDone.top().first < curCycle)) {
+		int i = mhsrDone.top().second;
+		// Skip stale entries: the MHSR was freed early, and maybe reused (even
+		//  for a miss that completes at the same cycle, in which case it has
+		//  two entries).
+		if (mhsr[i].busy && (mhsr[i].resolved == (int64_t)mhsrDone.top().first) && (earlyPos[i] == -1)) {
+			FreeMHSR(i);
+			PlaceEarlyMHSR(numEarly++, i);
+		}
+		mhsrDone.pop();
+	}
+}
+
+void CacheClass::PlaceEarlyMHSR(int pos, int i)
+/*------------------------------------------------------------------------*
+ | Put MHSR "i" at position "pos" of earlyHeap, and move it up or down to
+ |  its place.
+\*------------------------------------------------------------------------*/
+{
+	int parent;
+	int child;
+
+	while ((pos > 0) && (mhsr[earlyHeap[(parent = ((pos - 1) / 2))]].resolved < mhsr[i].resolved)) {
+		earlyHeap[pos] = earlyHeap[parent];
+		earlyPos[earlyHeap[pos]] = pos;
+		pos = parent;
+	}
+	while ((child = (2*pos + 1)) < numEarly) {
+		// Pick the larger child.
+		if (((child + 1) < numEarly) &&
+		    (mhsr[earlyHeap[child+1]].resolved > mhsr[earlyHeap[child]].resolved))
+			child++;
+
+		if (mhsr[earlyHeap[child]].resolved <= mhsr[i].resolved)
+			break;
+
+		earlyHeap[pos] = earlyHeap[child];
+		earlyPos[earlyHeap[pos]] = pos;
+		pos = child;
+	}
+	earlyHeap[pos] = i;
+	earlyPos[i] = pos;
+}
+
+void CacheClass::RemoveEarlyMHSR(int i)
+/*------------------------------------------------------------------------*
+ | Take MHSR "i" out of earlyHeap, if it is in it: it is no longer busy.
+\*------------------------------------------------------------------------*/
+{
+	int pos = earlyPos[i];
+
+	if (pos == -1)
+		return;
+	earlyPos[i] = -1;
+	numEarly--;
+	if (pos < numEarly)
+		PlaceEarlyMHSR(pos, earlyHeap[numEarly]);
+}
+
+int CacheClass::CountEarlyMHSRs(int pos, cycle_t curCycle)
+/*------------------------------------------------------------------------*
+ | The number of MHSRs in the subheap of earlyHeap at "pos" that complete at
+ |  or after "curCycle". Only those are visited.
+\*------------------------------------------------------------------------*/
+{
+	if ((pos >= numEarly) || (mhsr[earlyHeap[pos]].resolved < curCycle))
+		return(0);
+	return(1 + CountEarlyMHSRs((2*pos + 1), curCycle) + CountEarlyMHSRs((2*pos + 2), curCycle));
+}
+
+int CacheClass::CountFreeMHSRs(cycle_t curCycle)
+{
+	RetireMHSRs(curCycle);
+
+	// Not counting the MHSRs freed at a later cycle than "curCycle" that
+	//  are still busy at "curCycle".
+	return(numFreeMHSR - CountEarlyMHSRs(0, curCycle));
+}
+
 int CacheClass::FindFreeMHSR(cycle_t curCycle)
 {
 	int i;
+	int w;
+	uint64_t bits;
 	CacheLineClass* line;
 	bool hit;
 	reg_t oldAddr;
 
-	for (i=0; i<numMHSR; i++) {
-		if (!mhsr[i].busy) {
-    //if (mhsr[i].resolved ==-1){
-			return(i);
+	RetireMHSRs(curCycle);
+
+	// The lowest-numbered free MHSR. One freed at a later cycle than
+	//  "curCycle" may still be busy at "curCycle": skip it.
+	i = -1;
+	for (w=0; (w<((numMHSR + 63) / 64)) && (i == -1); w++) {
+		for (bits = mhsrFree[w]; bits; bits &= (bits - 1)) {
+			i = ((w << 6) + __builtin_ctzll(bits));
+			if (!mhsr[i].busy || (mhsr[i].resolved < curCycle))
+				break;
+			i = -1;
 		}
-		if (mhsr[i].resolved < curCycle) {
-			// MHSR is finished.  Free it.
-			line = array.lookup(mhsr[i].lineAddress, NULL, &hit, &oldAddr, false);
-			if (hit) {
-				if (line->mhsr == i) {
-					line->mhsr = -1;
-				}
+	}
+	if (i == -1) {
+		// No MHSRs available.
+		return(-1);
+	}
+
+	if (mhsr[i].busy) {
+		// MHSR is finished.  Free it.
+		line = array.lookup(mhsr[i].lineAddress, NULL, &hit, &oldAddr, false);
+		if (hit) {
+			if (line->mhsr == i) {
+				line->mhsr = -1;
 			}
-			mhsr[i].resolved = 0;
-			mhsr[i].busy = false;
-			return(i);
 		}
+		RemoveEarlyMHSR(i);
+		mhsr[i].resolved = 0;
+		mhsr[i].busy = false;
 	}
-
-	// No MHSRs available.
-	return(-1);
+	return(i);
 }
 
 int CacheClass::FindNextPort(cycle_t curCycle, cycle_t* portAvail)
 {
-	int i;
-	int soonestPort;
-	cycle_t soonestCycle;
-
-	soonestPort = 0;
-	soonestCycle = missPortAvail[0];
+	// The port available soonest (the lowest-numbered one among ties).
+	*portAvail = missPortAvail[portHeap[0]];
+	return(portHeap[0]);
+}
 
-	for (i=1; i < numMissSrvPorts; i++) {
-		if (soonestCycle > missPortAvail[i]) {
-			soonestCycle = missPortAvail[i];
-			soonestPort = i;
-		}
+void CacheClass::SetPortAvail(int port, cycle_t cycle)
+/*------------------------------------------------------------------------*\
+ | Make miss port "port" busy until "cycle". A port is only ever taken for
+ |  a later cycle than it is available, so it can only move down the heap.
+\*------------------------------------------------------------------------*/
+{
+	int pos;
+	int child;
+
+	assert(cycle >= missPortAvail[port]);
+	missPortAvail[port] = cycle;
+
+	pos = portPos[port];
+	while ((child = (2*pos + 1)) < numMissSrvPorts) {
+		// Pick the smaller child.
+		if (((child + 1) < numMissSrvPorts) &&
+		    ((missPortAvail[portHeap[child+1]] < missPortAvail[portHeap[child]]) ||
+		     ((missPortAvail[portHeap[child+1]] == missPortAvail[portHeap[child]]) && (portHeap[child+1] < portHeap[child]))))
+			child++;
+
+		if ((missPortAvail[portHeap[child]] > cycle) ||
+		    ((missPortAvail[portHeap[child]] == cycle) && (portHeap[child] > port)))
+			break;
+
+		portHeap[pos] = portHeap[child];
+		portPos[portHeap[pos]] = pos;
+		pos = child;
 	}
-
-	*portAvail = soonestCycle;
-	return(soonestPort);
+	portHeap[pos] = port;
+	portPos[port] = pos;
 }
 
 
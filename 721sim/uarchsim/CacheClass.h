@@ -18,9 +18,10 @@
  |  Number of outstanding misses
  |  Number of ports to backing store
  |  Backing store port reuse latency
+ |  Replacement policy (see repl_policy.h)
+ |  Write-back buffer entries (see set_writeback_buffer)
  |
  | Fixed cache parameters:
- |  Replacement policy (LRU)
  |  Write policy (Write Back)
  |  Number of cache ports (unlimited)
 \*--------------------------------------------------------------------------*/
@@ -28,6 +29,9 @@
 #include "cache.h"
 #include "histogram.h"
 #include <string.h>
+#include <queue>
+#include <vector>
+#include <unordered_map>
 
 /*--------------------------------------------------------------------------*\
  | Miss Handleing Status Register provides multiple outstanding reads and
@@ -48,6 +52,8 @@ public:
 	int mhsr;   /* Index of MHSR that is loading this line.        */
 	bool mhsrValid; /* -1 indicates that the line is not being loaded. */
 	bool dirty; /* Indicates the line is dirty.                    */
+	bool prefetched; /* Line was prefetched and not yet referenced. */
+	bool exclusive; /* Coherence: line is held in E or M (see coherence.h). */
 };
 
 typedef cache<CacheLineClass> CacheArray;
@@ -55,12 +61,16 @@ typedef cache<CacheLineClass> CacheArray;
 //Forward declaring class
 class pipeline_t;
 class stats_t;
+class prefetcher_t;
+class dram_t;
+class directory_t;
 
 class CacheClass {
 public:
 	CacheClass(int sets, int assoc, int _lineSize,
 	           int _hitLatency, int _missLatency,
 	           int _numMHSR, int _numMissSrvPorts, int _missSrvLatency,
+	           repl_policy_e _repl,
 	           pipeline_t* _proc, const char* _identifier,
              CacheClass* _nextLevel=NULL, int histLen = 50);
 	/*------------------------------------------------------------------------*\
@@ -81,6 +91,7 @@ public:
 	 |                  cycle (number of ports to the backing store.)
 	 |  missSrvLat     The number of cycles before a miss service port can be
 	 |                  reused (port pipeline latency).
+	 |  repl           The replacement policy.
 	\*------------------------------------------------------------------------*/
 
 	~CacheClass();
@@ -94,7 +105,8 @@ public:
 
 	cycle_t Access(unsigned int Tid /* ER 11/16/02 */,
 	               cycle_t curCycle, reg_t addr, bool isStore,
-	               bool* hit=NULL, bool probe=false, bool commit=true);
+	               bool* hit=NULL, bool probe=false, bool commit=true,
+	               reg_t pc=0);
 	/*------------------------------------------------------------------------*\
 	 | Access the data cache.  Determines how many cycles access will take.
 	 |
@@ -103,6 +115,7 @@ public:
 	 |  addr              The address of the word being accessed.
 	 |  isStore           Indicates whether the access is a store (true) or
 	 |                     load (false).
+	 |  pc                PC of a demand load or store (trains the prefetcher).
 	 |
 	 | Returns the cycle when the access will complete.  Returns -1 if the
 	 |  access can not be handled, due to limited miss handleing status
@@ -110,16 +123,64 @@ public:
 	\*------------------------------------------------------------------------*/
 
 	bool Probe(unsigned int Tid,cycle_t curCycle, reg_t addr1, unsigned int length);
-	HistogramClass* accessLatency;
+	LogHistogramClass* accessLatency;  /* Latency of the reads (loads, fills
+	                                    *  from the level above) handled.  */
+	void dump_latency(FILE* fp);
 	void set_nextLevel(CacheClass* nLevel);
+	void set_prefetcher(prefetcher_t* pf);
+	void register_prefetch_counters();
+	void set_memory(dram_t* mem);
+	void set_writeback_buffer(int entries);
+	void set_directory(directory_t* dir, unsigned int core);
+
+	void Invalidate(reg_t lineAddr);
+	void Downgrade(reg_t lineAddr);
+	/*------------------------------------------------------------------------*\
+	 | Coherence actions of the directory on this L1 D$: invalidate line
+	 |  "lineAddr" (address >> lineSize), or take away its exclusive state
+	 |  (M or E to S). A dirty line is written back on a downgrade.
+	\*------------------------------------------------------------------------*/
+
+	void RecordReadHit();
+	/*------------------------------------------------------------------------*\
+	 | Count a read hit without looking up the line. The caller knows that
+	 |  the line is the most recently used line of its set and is not being
+	 |  loaded, so the lookup would leave the cache unchanged (see the fetch
+	 |  line buffer in ic.h).
+	\*------------------------------------------------------------------------*/
+
+	bool Prefetch(unsigned int Tid, cycle_t curCycle, reg_t line, reg_t pc);
+	/*------------------------------------------------------------------------*\
+	 | Prefetch line "line" (address >> lineSize), if it is not already in
+	 |  the cache and enough MHSRs are free. "pc" trains the next level's
+	 |  prefetcher (0: none).
+	 |
+	 | Returns true if the prefetch was issued.
+	\*------------------------------------------------------------------------*/
 private:
 
   pipeline_t* proc;
 	int FindFreeMHSR(cycle_t curCycle);
 	int FindNextPort(cycle_t curCycle, cycle_t* portAvail);
+	int CountFreeMHSRs(cycle_t curCycle);
+	void RetireMHSRs(cycle_t curCycle);
+	void FreeMHSR(int i);
+	void PlaceEarlyMHSR(int pos, int i);
+	void RemoveEarlyMHSR(int i);
+	int CountEarlyMHSRs(int pos, cycle_t curCycle);
+	void SetPortAvail(int port, cycle_t cycle);
+	cycle_t Fill(unsigned int Tid, cycle_t curCycle, reg_t addr, reg_t lineAddr,
+	             int newMHSR, bool isStore, bool commit, bool prefetch, reg_t pc);
+	cycle_t Writeback(unsigned int Tid, cycle_t curCycle, cycle_t lineInArray, int fillPort, reg_t victimAddr);
 
 	CacheArray  array;          /* The D-Cache array.                           */
   CacheClass* nextLevel; 
+  prefetcher_t* prefetcher;  /* Data prefetcher (NULL if none).               */
+  dram_t*     memory;        /* DRAM behind a last-level cache (NULL: fixed
+                              *  missLatency).                               */
+  directory_t* directory;    /* Coherence directory of a private L1 D$ in
+                              *  front of a shared L2 (NULL if none).        */
+  unsigned int core;         /* This cache's core, for the directory.        */
   std::string identifier;
 	int         lineSize;        /* D-Cache line size.  Must be a power of 2.    */
 //	cycle_t     lastCycle;         /* curCycle of last access.                     */
@@ -130,8 +191,32 @@ private:
                               *  backs as well.                              */
 	int         numMHSR;         /* The number of MHSRs.                         */
 	MHSRClass*  mhsr;           /* The miss handling status registers.          */
+	uint64_t*   mhsrFree;       /* Bitmap of free MHSRs (bit i: MHSR i).        */
+	int         numFreeMHSR;    /* Number of bits set in mhsrFree.              */
+	std::priority_queue<std::pair<cycle_t,int>,
+	                    std::vector<std::pair<cycle_t,int> >,
+	                    std::greater<std::pair<cycle_t,int> > > mhsrDone;
+	                            /* Allocated MHSRs, by completion cycle.
+                              *  Entries of MHSRs freed early are stale.     */
+	int*        earlyHeap;      /* Free MHSRs that are still busy, as a
+                              *  max-heap on resolved. Accesses may come at
+                              *  earlier cycles than the one they were freed
+                              *  at: those that complete at or after the
+                              *  access's cycle are not free for it.         */
+	int*        earlyPos;       /* Position of each MHSR in earlyHeap (-1: not
+                              *  in it).                                     */
+	int         numEarly;       /* Number of MHSRs in earlyHeap.                */
+	std::unordered_map<reg_t,int> inflight;
+	                            /* Lines being loaded: line address -> MHSR.   */
+	int*        portHeap;       /* Miss ports, as a min-heap on
+                              *  (missPortAvail, port number).               */
+	int*        portPos;        /* Position of each miss port in portHeap.      */
 	int         numMissSrvPorts;       /* Number of miss ports available.              */
 	cycle_t     missSrvLatency;    /* Pipeline reuse latency for miss ports.       */
+	int         numWBB;            /* Write-back buffer entries (0: none; the
+                              *  fill waits for the writeback).              */
+	cycle_t*    wbbAvail;          /* Cycle each write-back buffer entry will be
+                              *  free (its writeback acknowledged).          */
 
   stats_t* stats;
 
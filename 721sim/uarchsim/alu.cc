@@ -48,9 +48,30 @@ void pipeline_t::agen(unsigned int index) {
 
 
 void pipeline_t::alu(unsigned int index) {
+	unsigned int f = 0;
+
+	//Macro-op fusion: first execute the absorbed instruction, using the source operands that this instruction read
+	//on its behalf. Its result replaces this instruction's operand that read it; the other operand is x0 (see pipeline_t::fuse()).
+	if(PAY.buf[index].fused) {
+		f = MOD((index + PAYLOAD_BUFFER_SIZE - 2), PAYLOAD_BUFFER_SIZE);
+		assert(PAY.buf[f].absorbed);
+		PAY.buf[f].A_value.dw = PAY.buf[index].A_value.dw;
+		PAY.buf[f].B_value.dw = PAY.buf[index].B_value.dw;
+		alu(f);
+		PAY.buf[index].A_value.dw = PAY.buf[index].fused_A ? PAY.buf[f].C_value.dw : 0;
+		PAY.buf[index].B_value.dw = PAY.buf[index].fused_A ? 0 : PAY.buf[f].C_value.dw;
+	}
+
 	//Do the MUXing for CMOV Instruction.
 	if(PAY.buf[index].instruction_type == CMOV) {
+		if(PAY.buf[index].pp_valid) { //Predicted predicate. Verified by predicate_replay() when the hammock resolves.
+			PAY.buf[index].C_value.dw = PAY.buf[index].pp_predicate ? PAY.buf[index].B_value.dw : PAY.buf[index].A_value.dw;
+			PAY.buf[index].pp_executed = true;
+			return;
+		}
 		PAY.buf[index].C_value.dw = (PAY.buf[index].D_value.dw == 1) ? PAY.buf[index].B_value.dw : PAY.buf[index].A_value.dw; //Predicate set--> Take B value.
+		if(PAY.buf[index].mp_join) //Multipath join: resolve the continuation of the path that the fork actually took.
+			PAY.buf[index].c_next_pc = (PAY.buf[index].D_value.dw == 1) ? PAY.buf[index].mp_taken_pc : PAY.buf[index].mp_not_taken_pc;
 		return;
 	}
 
@@ -63,4 +84,9 @@ void pipeline_t::alu(unsigned int index) {
   if(PAY.buf[index].branch && PAY.buf[index].branch_type == HAMMOCK) {
 	  PAY.buf[index].C_value.dw = (PAY.buf[index].c_next_pc != INCREMENT_PC(PAY.buf[index].pc)) ? 1 : 0; //Next PC is not the computed PC-->Taken Path-->Set Predicate.
   }
+
+  //Fused compare-and-branch: the branch also writes the compare's result.
+  if(PAY.buf[index].fused && (insn.opcode() == OP_BRANCH)) {
+	  PAY.buf[index].C_value.dw = PAY.buf[f].C_value.dw;
+  }
 }
@@ -0,0 +1,104 @@
+#ifndef BRANCH_MASK_H
+#define BRANCH_MASK_H
+
+#include <inttypes.h>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Fixed-width branch mask: one bit per branch checkpoint.
+//
+// The width is fixed at compile time by BRANCH_MASK_BITS (default 64, set
+// with the BRANCH_MASK_BITS cmake cache variable), which caps the number of
+// branch checkpoints (--cp). The mask is an array of 64-bit words, and all
+// loops are over a compile-time number of words. With the default width
+// there is a single word and every operation compiles to the same code as a
+// plain uint64_t.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef BRANCH_MASK_BITS
+#define BRANCH_MASK_BITS 64
+#endif
+
+template <unsigned int N>
+class fixed_mask_t {
+private:
+	static const unsigned int WORDS = ((N + 63) / 64);
+	uint64_t w[WORDS];
+
+public:
+	fixed_mask_t() {
+		reset();
+	}
+
+	// Clear all bits.
+	inline void reset() {
+		for (unsigned int i = 0; i < WORDS; i++)
+			w[i] = 0;
+	}
+
+	inline void set(unsigned int bit) {
+		w[bit >> 6] |= (((uint64_t)1) << (bit & 63));
+	}
+
+	inline void clear(unsigned int bit) {
+		w[bit >> 6] &= ~(((uint64_t)1) << (bit & 63));
+	}
+
+	inline bool test(unsigned int bit) const {
+		return((w[bit >> 6] & (((uint64_t)1) << (bit & 63))) != 0);
+	}
+
+	// Returns true if any bit is set.
+	inline bool any() const {
+		uint64_t x = 0;
+		for (unsigned int i = 0; i < WORDS; i++)
+			x |= w[i];
+		return(x != 0);
+	}
+
+	// Number of set bits.
+	inline unsigned int count() const {
+		unsigned int n = 0;
+		for (unsigned int i = 0; i < WORDS; i++)
+			n += __builtin_popcountll(w[i]);
+		return(n);
+	}
+
+	// Position of the lowest clear bit below "limit", or "limit" if there is none.
+	inline unsigned int first_zero(unsigned int limit) const {
+		for (unsigned int i = 0; i < WORDS; i++) {
+			if (~w[i]) {
+				unsigned int bit = ((i << 6) + __builtin_ctzll(~w[i]));
+				return((bit < limit) ? bit : limit);
+			}
+		}
+		return(limit);
+	}
+
+	// Position of the lowest set bit at or above "from", or N if there is none.
+	// Iterate over the set bits with: for (b = m.next_one(0); b < N; b = m.next_one(b+1))
+	inline unsigned int next_one(unsigned int from) const {
+		for (unsigned int i = (from >> 6); i < WORDS; i++) {
+			uint64_t x = w[i];
+			if (i == (from >> 6))
+				x &= (~((uint64_t)0) << (from & 63));
+			if (x)
+				return((i << 6) + __builtin_ctzll(x));
+		}
+		return(N);
+	}
+
+	// The 64-bit word holding bits [64*i, 64*i+63], e.g., for logging.
+	inline uint64_t word(unsigned int i) const {
+		return(w[i]);
+	}
+
+	inline unsigned int words() const {
+		return(WORDS);
+	}
+};
+
+typedef fixed_mask_t<BRANCH_MASK_BITS> branch_mask_t;
+
+#endif //BRANCH_MASK_H
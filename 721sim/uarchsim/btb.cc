@@ -52,7 +52,7 @@ bool hammock_table_t::search_hammock(uint64_t pc, hammock_entry& entry) {
 
 
 
-btb_t::btb_t(uint64_t num_entries, uint64_t banks, uint64_t assoc, uint64_t cond_branch_per_cycle) {
+btb_t::btb_t(uint64_t num_entries, uint64_t banks, uint64_t assoc, repl_policy_e policy, uint64_t cond_branch_per_cycle, uint64_t mp_depth) {
    this->banks = banks;
    this->sets = (num_entries/(banks*assoc));
    this->assoc = assoc;
@@ -70,18 +70,21 @@ btb_t::btb_t(uint64_t num_entries, uint64_t banks, uint64_t assoc, uint64_t cond
       btb[b] = new btb_entry_t *[sets];
       for (uint64_t s = 0; s < sets; s++) {
          btb[b][s] = new btb_entry_t[assoc];
-	 for (uint64_t way = 0; way < assoc; way++) {
+	 for (uint64_t way = 0; way < assoc; way++)
 	    btb[b][s][way].valid = false;
-	    btb[b][s][way].lru = way;
-	 }
       }
    }
+   repl = repl_policy_t::create(policy, (banks * sets), assoc);
    state = REGULAR;
    then_count = 0;
+
+   this->mp_depth = mp_depth;
+   mp_active = false;
 }
 
 
 btb_t::~btb_t() {
+   delete repl;
 }
 
 void btb_t::construct_hammock_table(std::string file) {
@@ -100,6 +103,53 @@ void btb_t::reset_state() {
    state = REGULAR;
    then_count = 0;
    cmov_instructions.clear();
+   mp_active = false;
+}
+
+// Multipath paths only hold instructions that can be deactivated and that write at most one register:
+// integer ALU operations. Any other instruction (control transfer, load, store, amo, system, fence,
+// FP computation) ends the path. Loads are excluded because a load down the wrong path may fault, and
+// a deactivated instruction must not raise an exception at retirement. For an instruction that can be
+// in a path, "log_reg" is set to the logical register it writes (0 if none).
+static bool mp_path_insn(insn_t insn, uint64_t &log_reg) {
+   switch (insn.opcode()) {
+      case OP_OP:
+      case OP_OP_32:
+      case OP_OP_IMM:
+      case OP_OP_IMM_32:
+      case OP_LUI:
+      case OP_AUIPC:
+         log_reg = insn.rd();
+         return(true);
+
+      default:
+         return(false);
+   }
+}
+
+// The current multipath path ends at "end_pc" (the PC of its first instruction that is not fetched).
+// After the not-taken path, fetch the taken path. After the taken path, inject the CMOVs: one per register
+// written by either path, or a single CMOV of x0 if neither path writes a register, so that there is
+// always a join.
+// Returns the PC of the next fetch bundle.
+uint64_t btb_t::mp_end_path(uint64_t end_pc) {
+   if (!mp_else) {
+      mp_not_taken_pc = end_pc;
+      mp_else = true;
+      mp_count = 0;
+      return(mp_target);
+   }
+   else {
+      mp_taken_pc = end_pc;
+      state = CMOV_Region;
+      for (uint64_t i = 1; i < 64; i++) {
+         if (mp_regs & (1ULL << i))
+            cmov_instructions.push_back(i);
+      }
+      if (cmov_instructions.empty())
+         cmov_instructions.push_back(0);
+      return(end_pc);
+   }
 }
 //
 // Inputs:
@@ -130,6 +180,9 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
    uint64_t num_cond_branch = 0;
    bool terminated = false;
    uint64_t pos = 0;
+   bool fork;
+   uint64_t log_reg;
+   uint64_t mp_next_pc = 0;	// Next fetch PC, if a multipath path ends at the first instruction of the bundle.
 
    // hammock_entry entry;
 
@@ -144,6 +197,8 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
 
       // Each instruction in the bundle carries with it, its full pc.
       bundle[pos].pc = (pc + (pos << 2));
+      bundle[pos].mp_fork = false;
+      bundle[pos].mp_join = false;
       //printf("PC - %llx\n", bundle[pos].pc);
      //HP-- printf("Current PC in BTB Lookup - %x State-%d\n", bundle[pos].pc, state);
       //If the current state is normal fetching
@@ -175,8 +230,8 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
                bundle[pos].region_type = NORMAL;
                bundle[pos].is_hammock = false;
 
-               // Update LRU.
-	            update_lru(btb_bank, set, way);
+               // Update replacement state.
+	            repl->hit((btb_bank * sets) + set, way);
 
                // (1) Determine the instruction's next_pc field (i.e., pc of the next instruction, which may be in the same bundle or at the start of the next bundle).
                // (2) Determine if this is the last instruction in the bundle.
@@ -191,9 +246,33 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
 	               // From this two-bit counter, set the taken flag, accordingly.
 	                  taken = ((cb_predictions & 3) >= 2);
 
+	               // Low confidence: the two-bit counter is in one of its two weak states.
+	                  fork = ((mp_depth > 0) && (((cb_predictions & 3) == 1) || ((cb_predictions & 3) == 2)));
+
 	               // Shift out the used-up 2-bit counter, to set up prediction of the next conditional branch.
 	                  cb_predictions = (cb_predictions >> 2);
 
+	               // Dynamic multipath: fork at a low-confidence branch, i.e., fetch both of its paths as a hammock.
+	               // The fork still occupies its slot in the conditional branch prediction bundle and its prediction
+	               // is still shifted into the BHRs: it selects the path whose continuation is fetched after the join.
+	                  if (fork) {
+	                     bundle[pos].next_pc = INCREMENT_PC(bundle[pos].pc);
+	                     bundle[pos].branch_type = HAMMOCK;
+	                     bundle[pos].is_hammock = true;
+	                     bundle[pos].mp_fork = true;
+	                     bundle[pos].mp_taken = taken;
+	                     terminated = true;
+
+	                     state = PREDICATED_REGION;
+	                     mp_active = true;
+	                     mp_else = false;
+	                     mp_taken = taken;
+	                     mp_target = btb[btb_bank][set][way].target;
+	                     mp_count = 0;
+	                     mp_regs = 0;
+	                     break;
+	                  }
+
 	               // (1) Determine the instruction's next_pc field.
 	                  bundle[pos].next_pc = (taken ?  btb[btb_bank][set][way].target : INCREMENT_PC(bundle[pos].pc));
 
@@ -286,6 +365,33 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
       } //End- Normal State
 
 
+      //Current State is in a path of a multipath fork.
+      else if ((state == PREDICATED_REGION) && mp_active) {
+         if (bundle[pos].exception || !mp_path_insn(bundle[pos].insn, log_reg)) {
+            // This instruction is not part of the path: the path ends just before it.
+            bundle[pos].valid = false;
+            mp_next_pc = mp_end_path(bundle[pos].pc);
+            if (pos > 0)
+               bundle[pos-1].next_pc = mp_next_pc;
+            terminated = true;
+         }
+         else {
+            bundle[pos].next_pc = INCREMENT_PC(bundle[pos].pc);
+            bundle[pos].branch = false;
+            bundle[pos].is_hammock = false;
+            bundle[pos].region_type = (mp_else ? ELSE : THEN);
+            if (log_reg)
+               mp_regs |= (1ULL << log_reg);
+
+            mp_count++;
+            if (mp_count == mp_depth) {
+               bundle[pos].next_pc = mp_end_path(bundle[pos].next_pc);
+               terminated = true;
+            }
+            pos++;
+         }
+      } //End - MULTIPATH REGION
+
       //Current State is in Then Region.
       else if (state == PREDICATED_REGION) {
          bundle[pos].next_pc = INCREMENT_PC(bundle[pos].pc);
@@ -333,7 +439,18 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
             bundle[pos].region_type = CMOV;
             bundle[pos].branch = false;
             bundle[pos].is_hammock = false;
-            bundle[pos].next_pc = entry.RPC;
+            if (mp_active) {
+               // The join: continue down the predicted path of the multipath fork.
+               bundle[pos].mp_join = true;
+               bundle[pos].mp_taken = mp_taken;
+               bundle[pos].mp_taken_pc = mp_taken_pc;
+               bundle[pos].mp_not_taken_pc = mp_not_taken_pc;
+               bundle[pos].next_pc = (mp_taken ? mp_taken_pc : mp_not_taken_pc);
+               mp_active = false;
+            }
+            else {
+               bundle[pos].next_pc = entry.RPC;
+            }
             terminated = true;
             state = REGULAR;
             //printf("In CMOV\n");
@@ -348,8 +465,10 @@ void btb_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_t
    // Finalize the "update" variable (which is needed by the Fetch Unit to speculatively update its predictors and pc).
    // Above, we recorded values for the push_ras/pop_ras related fields.
    // Now, record values for num_cb (number of conditional branches in the fetch bundle) and next_pc (predicted PC of the next fetch bundle).
-   assert(pos > 0);	// There must be at least one instruction in the fetch bundle.
-   update->next_pc = bundle[pos-1].next_pc;
+   // There must be at least one instruction in the fetch bundle, unless a multipath path ended at its first instruction.
+   // In that case the bundle is empty and only redirects fetch.
+   assert((pos > 0) || mp_active);
+   update->next_pc = ((pos > 0) ? bundle[pos-1].next_pc : mp_next_pc);
    update->num_cb = num_cond_branch;
    update->state = state;
    //printf("Bundle size- %d\n", pos-1);
@@ -392,13 +511,59 @@ void btb_t::update(uint64_t pc, uint64_t pos, insn_t insn) {
    // The entry's metadata:
    btb[btb_bank][set][way].valid = true;
    btb[btb_bank][set][way].tag = (btb_pc >> log2sets);
-   update_lru(btb_bank, set, way); // Update LRU.
+   // Update replacement state.
+   if (btb_hit)
+      repl->hit((btb_bank * sets) + set, way);
+   else
+      repl->fill((btb_bank * sets) + set, way);
 
    // The entry's payload:
    btb[btb_bank][set][way].branch_type = new_branch_type;
    btb[btb_bank][set][way].target = new_target;
 }
 
+// Predict the pc of the fetch bundle that follows the one at "pc", for fetch-directed instruction prefetching.
+// This is btb_t::lookup() without the hammock table, multipath, or any state updates (including replacement state).
+// Returns false if the bundle ends in an indirect branch or return: their targets are not predicted this far ahead.
+bool btb_t::peek(uint64_t pc, uint64_t cb_predictions, uint64_t &next_pc) {
+   uint64_t btb_bank;
+   uint64_t btb_pc;
+   uint64_t set;
+   uint64_t way;
+   uint64_t num_cond_branch = 0;
+
+   for (uint64_t pos = 0; pos < banks; pos++) {
+      convert(pc, pos, btb_bank, btb_pc);
+      if (search(btb_bank, btb_pc, set, way)) {
+         switch (btb[btb_bank][set][way].branch_type) {
+            case BTB_BRANCH:
+               num_cond_branch++;
+               if ((cb_predictions & 3) >= 2) {
+                  next_pc = btb[btb_bank][set][way].target;
+                  return(true);
+               }
+               cb_predictions = (cb_predictions >> 2);
+               if (num_cond_branch == cond_branch_per_cycle) {
+                  next_pc = (pc + ((pos + 1) << 2));
+                  return(true);
+               }
+               break;
+
+            case BTB_JUMP_DIRECT:
+            case BTB_CALL_DIRECT:
+               next_pc = btb[btb_bank][set][way].target;
+               return(true);
+
+            default:
+               return(false);
+         }
+      }
+   }
+
+   next_pc = (pc + (banks << 2));
+   return(true);
+}
+
 void btb_t::invalidate(uint64_t pc, uint64_t pos) {
    uint64_t btb_bank;
    uint64_t btb_pc;
@@ -413,14 +578,9 @@ void btb_t::invalidate(uint64_t pc, uint64_t pos) {
    bool btb_hit = search(btb_bank, btb_pc, set, way);
    assert(btb_hit);
    
-   // Invalidate the entry and make it the LRU way of the set.
+   // Invalidate the entry and make it the next victim of the set.
    btb[btb_bank][set][way].valid = false;
-   
-   for (uint64_t i = 0; i < assoc; i++) {
-      if (btb[btb_bank][set][i].lru > btb[btb_bank][set][way].lru)
-         btb[btb_bank][set][i].lru--;
-   }
-   btb[btb_bank][set][way].lru = assoc - 1;
+   repl->invalidate((btb_bank * sets) + set, way);
 }
 
 ////////////////////////////////////
@@ -449,7 +609,7 @@ void btb_t::convert(uint64_t pc, uint64_t pos, uint64_t &btb_bank, uint64_t &btb
 
 // This function searches for the specified branch, "btb_pc", in the specified bank, "btb_bank".
 // It returns true if found (hit) and false if not found (miss).
-// It outputs the "set" and "way" of either (a) the branch's entry (hit) or (b) the LRU entry (which can be used by the caller for replacement).
+// It outputs the "set" and "way" of either (a) the branch's entry (hit) or (b) the replacement policy's victim (which can be used by the caller for replacement).
 bool btb_t::search(uint64_t btb_bank, uint64_t btb_pc, uint64_t &set, uint64_t &way) {
    // Break up btb_pc into index and tag.
    uint64_t index = (btb_pc & (sets - 1));
@@ -458,36 +618,22 @@ bool btb_t::search(uint64_t btb_bank, uint64_t btb_pc, uint64_t &set, uint64_t &
    // Search the indexed set.
    bool hit = false;
    uint64_t hit_way = assoc; // out-of-bounds
-   uint64_t lru_way = assoc; // out-of-bounds
    for (uint64_t i = 0; i < assoc; i++) {
       if (btb[btb_bank][index][i].valid && (btb[btb_bank][index][i].tag == tag)) {
          hit = true;
 	 hit_way = i;
 	 break;
       }
-      else if (btb[btb_bank][index][i].lru == (assoc - 1)) {
-         lru_way = i;
-      }
    }
 
    // Outputs.
    set = index;
-   way = (hit ? hit_way : lru_way);
+   way = (hit ? hit_way : repl->victim((btb_bank * sets) + index));
    assert(way < assoc);
    return(hit);
 }
 
 
-void btb_t::update_lru(uint64_t btb_bank, uint64_t set, uint64_t way) {
-   // Make "way" most-recently-used.
-   for (uint64_t i = 0; i < assoc; i++) {
-      if (btb[btb_bank][set][i].lru < btb[btb_bank][set][way].lru)
-         btb[btb_bank][set][i].lru++;
-   }
-   btb[btb_bank][set][way].lru = 0;
-}
-
-
 btb_branch_type_e btb_t::decode(insn_t insn, uint64_t pc, uint64_t &target) {
    btb_branch_type_e branch_type;
    switch (insn.opcode()) {
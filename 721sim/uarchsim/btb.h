@@ -2,6 +2,7 @@
 #include <string>
 #include <fstream>
 #include <vector>
+#include "repl_policy.h"
 // typedef enum {
 // 	 FORK_THEN=0,
 // 	 FORK_ELSE=1, 
@@ -51,10 +52,9 @@ private:
 // A BTB entry.
 typedef
 struct {
-   // Metadata for hit/miss determination and replacement.
+   // Metadata for hit/miss determination.
    bool valid;
    uint64_t tag;
-   uint64_t lru;
 
    // Payload.
    btb_branch_type_e branch_type;
@@ -72,6 +72,9 @@ private:
 	uint64_t sets;
 	uint64_t assoc;
 
+	// Replacement state of all sets of all banks: set "set" of bank "btb_bank" is policy set (btb_bank*sets + set).
+	repl_policy_t *repl;
+
 	uint64_t log2banks; // number of pc bits that selects the bank
 	uint64_t log2sets;  // number of pc bits that selects the set within a bank
 
@@ -84,15 +87,15 @@ private:
 
 	void convert(uint64_t pc, uint64_t pos, uint64_t &btb_bank, uint64_t &btb_pc);
 	bool search(uint64_t btb_bank, uint64_t btb_pc, uint64_t &set, uint64_t &way);
-	void update_lru(uint64_t btb_bank, uint64_t set, uint64_t way);
 	
 
 public:
-	btb_t(uint64_t num_entries, uint64_t banks, uint64_t assoc, uint64_t cond_branch_per_cycle);
+	btb_t(uint64_t num_entries, uint64_t banks, uint64_t assoc, repl_policy_e policy, uint64_t cond_branch_per_cycle, uint64_t mp_depth);
 	~btb_t();
         void lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_target, uint64_t ras_predicted_target, fetch_bundle_t bundle[], spec_update_t *update);
 	void update(uint64_t pc, uint64_t pos, insn_t insn);
 	void invalidate(uint64_t pc, uint64_t pos);
+	bool peek(uint64_t pc, uint64_t cb_predictions, uint64_t &next_pc);
 	static btb_branch_type_e decode(insn_t insn, uint64_t pc, uint64_t &target);
 	//---ADDED CODE ----
 	hammock_table_t* hammock_table;
@@ -104,4 +107,20 @@ public:
 	std::vector <uint64_t> cmov_instructions;
 	void create_cmovs(hammock_entry);
 	void reset_state();
+
+	//---- Dynamic multipath execution ----
+	// A low-confidence conditional branch that is not in the hammock table forks: both of its paths are
+	// fetched, as THEN (not-taken path) and ELSE (taken path) regions, up to mp_depth instructions each
+	// or until an instruction that cannot be predicated. CMOVs then merge every register written by
+	// either path, and fetching continues down the predicted path (see btb_t::lookup()).
+	uint64_t mp_depth;		// Maximum number of instructions fetched down each path (0: multipath disabled).
+	bool mp_active;			// The current predicated region is a multipath fork.
+	bool mp_else;			// Fetching the taken path.
+	bool mp_taken;			// Predicted direction of the fork branch.
+	uint64_t mp_target;		// Taken target of the fork branch.
+	uint64_t mp_count;		// Number of instructions fetched down the current path.
+	uint64_t mp_regs;		// Logical registers (0-63) written by either path: one CMOV each.
+	uint64_t mp_taken_pc;		// PC after the last instruction of the taken path.
+	uint64_t mp_not_taken_pc;	// PC after the last instruction of the not-taken path.
+	uint64_t mp_end_path(uint64_t end_pc);
 };
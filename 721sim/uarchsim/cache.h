@@ -3,8 +3,13 @@
 #pragma interface
 #include <cstdio>
 #include <cassert>
+#include <cinttypes>
 #include "common.h"
 #include "decode.h"
+#include "repl_policy.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 
 #define	INVALID		-1
@@ -13,21 +18,47 @@
 ///////////////////////
 // STANDARD CACHE
 ///////////////////////
+//
+// The tag store is flat: the tags of all sets are in one contiguous array,
+// set by set, and so are the contents. A set is a run of "assoc" consecutive
+// elements of each array. Contents are held inline.
+// Replacing an entry copies the new contents into it, and the replaced
+// contents are returned as a copy.
+//
+// The tag compare of a lookup uses AVX2 (4 tags per compare) when the
+// simulator is compiled for a host that has it (cmake -DSIM_AVX2=ON, which
+// adds -mavx2), and a scalar loop otherwise.
+//
+// Replacement state is kept by a replacement policy (repl_policy.h), LRU by
+// default. A miss replaces an invalid way if the set has one, otherwise the
+// policy's victim.
+//
 template<class T>
 class cache {
 private:
-	// The cache is a 2-D array of entries, each entry
-	// is a tag + lru + pointer to object of type T.
-
-	typedef
-	struct {
-		reg_t tag;
-		unsigned int lru;
-		T* contents;
-	} entry;
-
-	entry**	C;
-
+	reg_t* tags;			// size*assoc tags
+	T* contents;			// size*assoc contents
+	T victim;			// the contents replaced by the last lookup with replacement
+	repl_policy_t* repl;		// replacement policy
+
+	// Way of the set starting at "set" whose tag is "id", or assoc if none.
+	inline unsigned int find(const reg_t* set, reg_t id) {
+		unsigned int i = 0;
+#if defined(__AVX2__)
+		__m256i key = _mm256_set1_epi64x((long long)id);
+		for (; (i + 4) <= assoc; i += 4) {
+			__m256i t = _mm256_loadu_si256((const __m256i*)(set + i));
+			int m = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(t, key)));
+			if (m)
+				return(i + __builtin_ctz(m));
+		}
+#endif
+		for (; i < assoc; i++) {
+			if (set[i] == id)
+				return(i);
+		}
+		return(assoc);
+	}
 
 public:
 	// size = number of entries deep
@@ -39,33 +70,26 @@ public:
 	unsigned int num_misses;
 
 	// constructor
-	cache(unsigned int size, unsigned int assoc) {
-		unsigned int i,j;
-
+	cache(unsigned int size, unsigned int assoc, repl_policy_e policy = REPL_LRU) {
 		// First ensure that 'size' is a power of 2.
 		assert( IsPow2(size) );
-
-		C = new entry *[size];
-		for (i = 0; i < size; i++) {
-			C[i] = new entry[assoc];
-			for (j = 0; j < assoc; j++) {
-				C[i][j].tag = INVALID;
-				C[i][j].lru = j;
-				C[i][j].contents = (T*)NULL;
-			}
-		}
+		assert((assoc > 0) && (assoc <= 65536));
 
 		this->size = size;
 		this->assoc = assoc;
 		this->num_misses = 0;
+
+		tags = new reg_t[size * assoc];
+		contents = new T[size * assoc];
+		repl = repl_policy_t::create(policy, size, assoc);
+		flush();
 	}
 
 	// destructor
 	~cache() {
-		//unsigned int i;
-		//for (i = 0; i < size; i++)
-		//   delete C[i];
-		//delete C;
+		delete [] tags;
+		delete [] contents;
+		delete repl;
 	}
 
 	//
@@ -74,32 +98,34 @@ public:
 	// Added by Quinn Jacobson, October 7, 1998.
 	//
 	void flush() {
-		unsigned int i,j;
-
-		for (i = 0; i < size; i++) {
-			for (j = 0; j < assoc; j++) {
-				C[i][j].tag = INVALID;
-				C[i][j].lru = j;
-				C[i][j].contents = (T*)NULL;
-			}
-		}
+		for (unsigned int i = 0; i < (size * assoc); i++)
+			tags[i] = INVALID;
+		repl->reset();
 	}
 
 
 	// Cache lookup and maintenance.
 	// Inputs:
 	//   (1) object id
-	//   (2) pointer to object's contents
+	//   (2) pointer to object's contents (copied into the cache if replaced)
 	//   (3) replace the entry on a cache miss
 	// Outputs:
 	//   (1) hit
 	//   (2) old object id (i.e. id that was replaced, if miss)
-	//   (3) return value: pointer to old object's contents
+	//   (3) return value: pointer to old object's contents, or NULL if the old entry is invalid.
+	//       On a hit, or a miss without replacement, this points into the cache.
+	//       On a miss with replacement, it points to a copy that is valid until the next lookup.
 	T* lookup(reg_t id, T* contents,
 	          bool* hit, reg_t* old_id,
 	          bool replace,
 	          bool use_raw_index = false,
 	          unsigned int raw_index = 0);
+
+	// Contents of the entry "id", or NULL if it is not cached. Does not update the replacement state.
+	T* probe(reg_t id);
+
+	// Invalidate the entry "id", if it is cached. Returns true if it was.
+	bool invalidate(reg_t id);
 };
 
 
@@ -109,83 +135,80 @@ T* cache<T>::lookup(reg_t id, T* contents,
                     bool replace,
                     bool use_raw_index, unsigned int raw_index) {
 	unsigned int index;
-	entry* set;
-	unsigned int i;
-	bool found;
+	unsigned int base;
+	reg_t* set;
 	unsigned int hit_way;
-	int replace_way;
+	unsigned int replace_way;
 	T* old_contents;
 
 	index = MOD((use_raw_index ? raw_index : id), size);
-	set = C[index];
-
-	i = 0;
-	found = false;
-	while (i < assoc && !found) {
-		if (set[i].tag == id) {
-			found = true;
-		}
-		else {
-			i += 1;
-		}
-	}
+	base = index * assoc;
+	set = &tags[base];
 
-	if (found) {
-		hit_way = i;
+	hit_way = find(set, id);
 
-		// Update LRU state.
-		for (i = 0; i < assoc; i++) {
-			if (set[i].lru < set[hit_way].lru) {
-				set[i].lru += 1;
-			}
-		}
-		set[hit_way].lru = 0;
+	if (hit_way < assoc) {
+		// Update replacement state.
+		repl->hit(index, hit_way);
 
 		// Set outputs of function.
 		*hit = true;
-		*old_id = set[hit_way].tag;
-		old_contents = set[hit_way].contents;
+		*old_id = set[hit_way];
+		old_contents = &this->contents[base + hit_way];
 	}
 	else {
 		// record the miss
 		num_misses += 1;
 
-		// Find replacement entry, and update LRU state.
-		replace_way = -1;
-		if (replace) {
-			for (i = 0; i < assoc; i++) {
-				if (set[i].lru == (assoc-1)) {	// least-recently used
-					replace_way = (int)i;
-					set[i].lru = 0;
-				}
-				else {
-					set[i].lru += 1;
-				}
-			}
-		}
-		else {
-			for (i = 0; i < assoc; i++) {
-				if (set[i].lru == (assoc-1)) {	// least-recently used
-					replace_way = (int)i;
-				}
-			}
+		// Find replacement entry: the highest invalid way, else the policy's victim.
+		// (With LRU, invalid ways are always the least recently used, highest first.)
+		for (replace_way = assoc; replace_way > 0; replace_way--) {
+			if (set[replace_way - 1] == (reg_t)INVALID)
+				break;
 		}
-		assert(replace_way != -1);
+		replace_way = ((replace_way > 0) ? (replace_way - 1) : repl->victim(index));
+		assert(replace_way < assoc);
 
 		// Set outputs of function.
 		*hit = false;
-		*old_id = set[replace_way].tag;
-		old_contents = set[replace_way].contents;
+		*old_id = set[replace_way];
+		old_contents = ((set[replace_way] == (reg_t)INVALID) ? (T*)NULL : &this->contents[base + replace_way]);
 
 		// Perform the actual replacement.
 		if (replace) {
-			set[replace_way].tag = id;
-			set[replace_way].contents = contents;
+			if (old_contents) {
+				victim = *old_contents;
+				old_contents = &victim;
+			}
+			set[replace_way] = id;
+			this->contents[base + replace_way] = *contents;
+			repl->fill(index, replace_way);
 		}
 	}
 
 	return(old_contents);
 }
 
+template<class T>
+T* cache<T>::probe(reg_t id) {
+	unsigned int base = (MOD(id, size) * assoc);
+	unsigned int way = find(&tags[base], id);
+
+	return((way < assoc) ? &contents[base + way] : (T*)NULL);
+}
+
+template<class T>
+bool cache<T>::invalidate(reg_t id) {
+	unsigned int index = MOD(id, size);
+	unsigned int base = (index * assoc);
+	unsigned int way = find(&tags[base], id);
+
+	if (way == assoc)
+		return(false);
+	tags[base + way] = INVALID;
+	repl->invalidate(index, way);
+	return(true);
+}
+
 
 #endif //CACHE_H
@@ -0,0 +1,79 @@
+#include <cinttypes>
+#include <cassert>
+#include "coherence.h"
+#include "CacheClass.h"
+
+directory_t::directory_t(cycle_t dir_latency, cycle_t c2c_latency, cycle_t inv_latency) {
+   this->dir_latency = dir_latency;
+   this->c2c_latency = c2c_latency;
+   this->inv_latency = inv_latency;
+}
+
+directory_t::~directory_t() {
+}
+
+void directory_t::attach(unsigned int core, CacheClass* dc) {
+   assert(core < COH_MAX_CORES);
+   if (l1.size() <= core)
+      l1.resize(core + 1, NULL);
+   l1[core] = dc;
+}
+
+coh_result_t directory_t::request(unsigned int core, reg_t line, bool write) {
+   coh_result_t r = {false, false, 0, dir_latency};
+   uint64_t me = ((uint64_t)1 << core);
+
+   assert((core < l1.size()) && l1[core]);
+
+   std::unordered_map<reg_t, dir_entry_t>::iterator it = lines.find(line);
+   if (it == lines.end()) {
+      dir_entry_t e = {0, -1};
+      it = lines.insert(std::make_pair(line, e)).first;
+   }
+   dir_entry_t &e = it->second;
+
+   if (!write) {
+      if ((e.owner >= 0) && (e.owner != (int)core)) {
+         // The owner supplies the line, and keeps it in S.
+         r.c2c = true;
+         l1[e.owner]->Downgrade(line);
+         e.owner = -1;
+      }
+      e.sharers |= me;
+      r.exclusive = (e.sharers == me);
+      if (r.exclusive)
+         e.owner = core;
+   }
+   else {
+      // Invalidate every other copy. An owner supplies the line first.
+      for (unsigned int c = 0; c < l1.size(); c++) {
+         if ((c != core) && (e.sharers & ((uint64_t)1 << c))) {
+            if (e.owner == (int)c)
+               r.c2c = true;
+            l1[c]->Invalidate(line);
+            r.invalidations++;
+         }
+      }
+      e.sharers = me;
+      e.owner = core;
+      r.exclusive = true;
+   }
+
+   if (r.c2c)
+      r.latency = c2c_latency;
+   if (r.invalidations && (r.latency < inv_latency))
+      r.latency = inv_latency;
+   return(r);
+}
+
+void directory_t::evict(unsigned int core, reg_t line) {
+   std::unordered_map<reg_t, dir_entry_t>::iterator it = lines.find(line);
+   if (it == lines.end())
+      return;
+
+   it->second.sharers &= ~((uint64_t)1 << core);
+   if (it->second.owner == (int)core)
+      it->second.owner = -1;
+   if (it->second.sharers == 0)
+      lines.erase(it);
+}
@@ -0,0 +1,83 @@
+#ifndef COHERENCE_H
+#define COHERENCE_H
+
+#include <vector>
+#include <unordered_map>
+#include "decode.h"
+
+class CacheClass;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// MESI directory between the private L1 data caches of the cores, used with
+// a shared L2 (-p <n> with --sharedl2).
+//
+// For each line held by some L1 D$, the directory tracks the cores that hold
+// it (sharers) and the core that holds it exclusively (owner, E or M). An L1
+// D$ line's own state follows from its "exclusive" and "dirty" bits: M
+// (exclusive, dirty), E (exclusive, clean), S (not exclusive), I (absent).
+// E becomes M silently on a store.
+//
+// Requests are made on an L1 D$ miss (read or write), and on a store to an S
+// line (write, an upgrade):
+// * Read: if another core owns the line, it supplies the data (a
+//   cache-to-cache transfer) and is downgraded to S. Its dirty data is
+//   written to the L2 at the same time. The requester gets E if no other core
+//   holds the line, else S.
+// * Write: every other copy is invalidated. If another core owned the line,
+//   it supplies the data. The requester gets M.
+// An L1 D$ replacement removes its core from the line's sharers.
+//
+// Timing: the directory returns the latency of a request, which CacheClass
+// adds from the cycle the request is sent:
+// * the directory latency, for a request that only looks up the directory;
+//   a miss does this in parallel with its L2 access;
+// * the cache-to-cache latency, for a miss supplied by another core, instead
+//   of the L2 access;
+// * at least the invalidation latency (invalidations and their acks), for a
+//   request that invalidates other copies.
+//
+// Simplifications: the directory is not inclusive of the L2 (L2 replacements
+// do not invalidate L1 copies), and an owner's write-back to the L2 on a
+// downgrade is not timed.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#define COH_MAX_CORES	64	// one sharers bit per core
+
+typedef struct {
+	bool exclusive;			// the requester gets the line in E or M
+	bool c2c;			// another core's L1 D$ supplies the line
+	unsigned int invalidations;	// other copies invalidated
+	cycle_t latency;		// latency of the request, from when it is sent
+} coh_result_t;
+
+typedef struct {
+	uint64_t sharers;		// bit c: core c's L1 D$ holds the line
+	int owner;			// core holding the line in E or M, or -1
+} dir_entry_t;
+
+class directory_t {
+private:
+	std::vector<CacheClass*> l1;	// the L1 D$ of each core
+	std::unordered_map<reg_t, dir_entry_t> lines;
+
+	cycle_t dir_latency;
+	cycle_t c2c_latency;
+	cycle_t inv_latency;
+
+public:
+	directory_t(cycle_t dir_latency, cycle_t c2c_latency, cycle_t inv_latency);
+	~directory_t();
+
+	// Attach core "core"'s L1 D$.
+	void attach(unsigned int core, CacheClass* dc);
+
+	// Core "core" requests line "line" (address >> line size), to read or write it.
+	coh_result_t request(unsigned int core, reg_t line, bool write);
+
+	// Core "core" replaced line "line".
+	void evict(unsigned int core, reg_t line);
+};
+
+#endif //COHERENCE_H
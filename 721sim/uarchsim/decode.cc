@@ -1,8 +1,17 @@
 #include "pipeline.h"
 
 
+// Macro-op fusion: an instruction that can be fused with an adjacent one.
+// Only plain integer instructions outside of hammocks (NORMAL) are fused: a hammock branch already has a
+// destination (the predicate), and THEN/ELSE/CMOV instructions are renamed differently (see renamer.h).
+static bool fusible(payload_t &pay) {
+	return((pay.instruction_type == NORMAL) && !pay.is_hammock && !pay.mp_fork && !pay.mp_join &&
+	       !pay.split && !pay.trap.valid() && (pay.iq == SEL_IQ) && !pay.fused && !pay.absorbed);
+}
+
+
 void pipeline_t::decode() {
-	unsigned int i;
+	unsigned int i, j;
 	unsigned int index;
 	insn_t inst;
 
@@ -32,12 +41,48 @@ void pipeline_t::decode() {
 		}
 
 		index = DECODE[i].index;
+		inc_counter(fetched_inst_count);	// Instructions delivered by the Fetch Unit, including injected CMOVs.
 
 		// Get instruction from payload buffer.
     inst = PAY.buf[index].inst;
 
     LOG(decode_log,cycle,PAY.buf[index].sequence,PAY.buf[index].pc,"Instruction: %08" PRIX32 "",(word_t)inst.bits());
 
+		// Predicate prediction: a hammock consults the predicate predictor, and the CMOVs that follow it
+		// inherit its prediction. Decode is in program order and hammocks do not nest, so the most
+		// recently decoded hammock is always the one that owns the CMOVs.
+		PAY.buf[index].pp_valid = false;
+		PAY.buf[index].pp_executed = false;
+		PAY.buf[index].src_read = false;
+		PAY.buf[index].wb_done = false;
+		PAY.buf[index].move_elim = false;
+		PAY.buf[index].const_elim = false;
+		PAY.buf[index].src_pending = false;
+		PAY.buf[index].vp_eligible = false;
+		PAY.buf[index].vp_counted = false;
+		PAY.buf[index].vp_valid = false;
+		PAY.buf[index].fused = false;
+		PAY.buf[index].fused_A = false;
+		PAY.buf[index].absorbed = false;
+		if (PP) {
+			if (PAY.buf[index].mp_fork) {
+				// The CMOVs of a multipath fork also resolve which path continues: never predict their predicate.
+				pp_last_valid = false;
+			}
+			else if (PAY.buf[index].is_hammock) {
+				PAY.buf[index].pp_index = PP->predict(PAY.buf[index].pc, PAY.buf[index].pp_predicate, PAY.buf[index].pp_valid);
+				pp_last_valid = PAY.buf[index].pp_valid;
+				pp_last_predicate = PAY.buf[index].pp_predicate;
+				inc_counter(pp_lookup_count);
+				if (PAY.buf[index].pp_valid)
+					inc_counter(pp_predict_count);
+			}
+			else if (PAY.buf[index].instruction_type == CMOV) {
+				PAY.buf[index].pp_valid = pp_last_valid;
+				PAY.buf[index].pp_predicate = pp_last_predicate;
+			}
+		}
+
 
 		// Set checkpoint flag.
 		switch (inst.opcode()) {
@@ -54,6 +99,13 @@ void pipeline_t::decode() {
 				break;
 		}
 
+		// Dynamic multipath: the fork is not checkpointed (it is a hammock), but its join is, since the join
+		// recovers from fetching the continuation of the wrong path.
+		if (PAY.buf[index].mp_fork)
+			inc_counter(mp_fork_count);
+		if (PAY.buf[index].mp_join)
+			PAY.buf[index].checkpoint = true;
+
 		// Set flags  and function units
 		switch(inst.opcode()) {
 
@@ -536,7 +588,28 @@ void pipeline_t::decode() {
 				break;
 		}
 
-		// Insert one or two instructions into the Fetch Queue (indices).
+		// Macro-op fusion: fuse this instruction with the previous one in the fetch bundle, if possible.
+		if (FUSION && (i > 0) && fuse(DECODE[i-1].index, index))
+			inc_counter(fused_count);
+
+
+    #ifdef RISCV_MICRO_DEBUG
+      // Dump debug info if needed
+      //Pass a pointer to the processor
+    
+      PAY.dump(this,index,decode_log);
+    #endif
+
+
+	}
+
+	// Insert one or two instructions into the Fetch Queue (indices).
+	// This is done after the whole fetch bundle is decoded, so that absorbed instructions are not inserted.
+	for (j = 0; j < i; j++) {
+		index = DECODE[j].index;
+		if (PAY.buf[index].absorbed)
+			continue;
+
 		FQ.push(index);
 		if (PAY.buf[index].split) {
       // Should not come here in current 721sim, with unified int/fp pipeline.
@@ -547,15 +620,95 @@ void pipeline_t::decode() {
 			assert(!PAY.buf[index+1].upper);
 			FQ.push(index+1);
 		}
+	}
+}
 
 
-    #ifdef RISCV_MICRO_DEBUG
-      // Dump debug info if needed
-      //Pass a pointer to the processor
-    
-      PAY.dump(this,index,decode_log);
-    #endif
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Macro-op fusion (FUSION).
+//
+// Try to fuse the adjacent instructions 'f' and 's' (in program order) into a single instruction.
+// The second instruction survives: it takes the first instruction's source operands, and executes both
+// (see pipeline_t::alu()). The first instruction is absorbed: it does not occupy Fetch Queue, Issue Queue,
+// or Active List entries, and it is not renamed. It keeps its own PAY entry (and db_index), so that the
+// Retire Stage can retire and check it just before the fused instruction (see pipeline_t::retire_absorbed()).
+//
+// Fused pairs (FUSE_* in parameters.h):
+// 1. "lui/auipc rd, imm" + "addi/addiw/jalr rd, rd, imm".
+// 2. "slli rd, rs, k" + "srli/srai rd, rd, k" (zero/sign extension).
+// 3. "slt/sltu/slti/sltiu rd, ..." + "beq/bne rd, x0" (either operand order). rd remains live after the
+//    branch, so the fused branch also writes it.
+// In the first two cases the second instruction overwrites rd, so the first instruction's result is only
+// needed inside the fused instruction.
+//
+// Returns true if the instructions were fused.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool pipeline_t::fuse(unsigned int f, unsigned int s) {
+	insn_t first = PAY.buf[f].inst;
+	insn_t second = PAY.buf[s].inst;
+	unsigned int rd;
+	bool ok = false;
+	bool cmp_br = false;
+
+	// Each instruction is allocated two PAY entries.
+	if ((s != MOD((f + 2), PAYLOAD_BUFFER_SIZE)) || !fusible(PAY.buf[f]) || !fusible(PAY.buf[s]) || !PAY.buf[f].C_valid)
+		return(false);
+
+	// Only integer results are fused: the Issue Queue also holds FP instructions.
+	// x0 results (e.g., nop) are not fused either.
+	rd = PAY.buf[f].C_log_reg;
+	if ((rd == 0) || (rd >= NXPR))
+		return(false);
+
+	switch (first.opcode()) {
+		case OP_LUI:
+		case OP_AUIPC:
+			ok = ((FUSION & FUSE_IMM) &&
+			        ((((second.opcode() == OP_OP_IMM) || (second.opcode() == OP_OP_IMM_32)) && (second.funct3() == 0)) ||
+			         (second.opcode() == OP_JALR)) &&
+			        (second.rs1() == rd) && (second.rd() == rd));
+			break;
+
+		case OP_OP_IMM:
+			if (first.funct3() == 1) {	// slli
+				ok = ((FUSION & FUSE_SHIFT) &&
+				        (second.opcode() == OP_OP_IMM) && (second.funct3() == 5) &&	// srli, srai
+				        ((first.i_imm() & 0x3f) == (second.i_imm() & 0x3f)) &&
+				        (second.rs1() == rd) && (second.rd() == rd));
+				break;
+			}
+			// slti, sltiu.
+			// Fall through.
+
+		case OP_OP:
+			cmp_br = (((first.funct3() == 2) || (first.funct3() == 3)) &&			// slt(i), slt(i)u
+			          ((first.opcode() == OP_OP_IMM) || (first.funct7() == 0)) &&
+			          (second.opcode() == OP_BRANCH) && (second.funct3() <= 1) &&		// beq, bne
+			          (((second.rs1() == rd) && (second.rs2() == 0)) || ((second.rs1() == 0) && (second.rs2() == rd))));
+			ok = ((FUSION & FUSE_CMP_BR) && cmp_br);
+			break;
 
+		default:
+			break;
+	}
 
+	if (!ok)
+		return(false);
+
+	// The survivor reads the absorbed instruction's source operands instead of rd.
+	// Its other operand, if any, is x0.
+	PAY.buf[s].fused = true;
+	PAY.buf[s].fused_A = (second.rs1() == rd);
+	PAY.buf[s].A_valid = PAY.buf[f].A_valid;
+	PAY.buf[s].A_log_reg = PAY.buf[f].A_log_reg;
+	PAY.buf[s].B_valid = PAY.buf[f].B_valid;
+	PAY.buf[s].B_log_reg = PAY.buf[f].B_log_reg;
+	if (cmp_br) {
+		assert(!PAY.buf[s].C_valid);
+		PAY.buf[s].C_valid = true;
+		PAY.buf[s].C_log_reg = rd;
 	}
+
+	PAY.buf[f].absorbed = true;
+	return(true);
 }
@@ -17,6 +17,10 @@ void pipeline_t::dispatch() {
    db_t* actual;
    instruction_dhp_e dhp_type ;
    bool is_hammock;
+   bool reused;
+   bool eliminated;
+   bool mdp_wait;
+   unsigned int mdp_store;
    // Stall the Dispatch Stage if either:
    // (1) There isn't a dispatch bundle.
    // (2) There aren't enough IQ entries for the dispatch bundle.
@@ -154,7 +158,8 @@ void pipeline_t::dispatch() {
                                                        csr_flag,
                                                        PAY.buf[index].pc,
                                                        dhp_type,
-                                                       is_hammock 
+                                                       is_hammock,
+                                                       PAY.buf[index].move_elim
                                                      );  
       // FIX_ME #7 END
 
@@ -176,9 +181,18 @@ void pipeline_t::dispatch() {
       // FIX_ME #8 BEGIN
          A_ready = (PAY.buf[index].A_valid) ? REN->is_ready(PAY.buf[index].A_phys_reg) : 1; 
          B_ready = (PAY.buf[index].B_valid) ? REN->is_ready(PAY.buf[index].B_phys_reg) : 1; 
-         D_ready = (PAY.buf[index].D_valid) ? REN->is_ready(PAY.buf[index].D_phys_reg) : 1; 
+         D_ready = (PAY.buf[index].D_valid) ? REN->is_ready(PAY.buf[index].D_phys_reg) : 1;
       // FIX_ME #8 END
 
+      // A CMOV with a predicted predicate does not wait for the predicate register.
+      // If the predicate is already available, use it instead of the prediction.
+      if (PAY.buf[index].pp_valid && (PAY.buf[index].instruction_type == CMOV)) {
+         if (D_ready)
+            PAY.buf[index].pp_valid = false;
+         else
+            D_ready = true;
+      }
+
       // FIX_ME #9
       // Clear the ready bit of the instruction's destination register.
       // This is needed to synchronize future consumers.
@@ -193,9 +207,40 @@ void pipeline_t::dispatch() {
       // 2. If the instruction has a destination register, then clear its ready bit; otherwise do nothing.
 
       // FIX_ME #9 BEGIN
-         if(PAY.buf[index].C_valid) REN->clear_ready(PAY.buf[index].C_phys_reg);
+         if(PAY.buf[index].C_valid && !PAY.buf[index].move_elim) REN->clear_ready(PAY.buf[index].C_phys_reg);
       // FIX_ME #9 END
 
+      // Rename-time elimination: the instruction completes without executing (see rename2()).
+      // An eliminated move's destination is its source register, so it is ready when the source is.
+      eliminated = (PAY.buf[index].move_elim || PAY.buf[index].const_elim);
+      if (PAY.buf[index].const_elim) {
+         PAY.buf[index].wb_done = true;
+         REN->write(PAY.buf[index].C_phys_reg, PAY.buf[index].C_value.dw);
+         REN->set_ready(PAY.buf[index].C_phys_reg);
+      }
+      if (eliminated)
+         REN->set_complete(PAY.buf[index].AL_index);
+
+      // Control-independent squash reuse: the instruction may complete right away with its result from the squashed wrong path.
+      reused = ((CI && ci_reuse(index, A_ready, B_ready)) || eliminated);
+
+      // Value prediction of loads and integer ALU instructions (see value_pred.h).
+      // With a confident prediction, consumers find the destination register ready.
+      if (VP && !reused &&
+          (PAY.buf[index].iq == SEL_IQ) &&
+          (PAY.buf[index].instruction_type == NORMAL) &&
+          PAY.buf[index].C_valid && (PAY.buf[index].C_log_reg != 0) && (PAY.buf[index].C_log_reg < NXPR) &&
+          !IS_BRANCH(PAY.buf[index].flags) && !IS_AMO(PAY.buf[index].flags) && !IS_CSR(PAY.buf[index].flags) &&
+          !PAY.buf[index].split) {
+         PAY.buf[index].vp_eligible = true;
+         if (VP->predict(PAY.buf[index].pc, PAY.buf[index].vp_value, PAY.buf[index].vp_counted)) {
+            inc_counter(vp_predict_count);
+            PAY.buf[index].vp_valid = true;
+            REN->write_prediction(PAY.buf[index].C_phys_reg, PAY.buf[index].vp_value);
+            REN->set_ready(PAY.buf[index].C_phys_reg);
+         }
+      }
+
       // FIX_ME #10
       // Dispatch the instruction into the Issue Queue, or circumvent the Issue Queue and immediately update status in the Active List.
       //
@@ -209,6 +254,14 @@ void pipeline_t::dispatch() {
 
       switch (PAY.buf[index].iq) {
          case SEL_IQ:
+            // A reused or eliminated instruction already completed (see ci_reuse()).
+            // An eliminated instruction reads its source registers at retirement, for the checker.
+            if (reused) {
+               if (!eliminated)
+                  release_sources(index);
+               break;
+            }
+
             // FIX_ME #10a
             // Dispatch the instruction into the IQ.
             //
@@ -252,6 +305,8 @@ void pipeline_t::dispatch() {
                REN->set_complete(PAY.buf[index].AL_index);
             // FIX_ME #10b1 END
 
+            release_sources(index);
+
             // Check if any previous pipeline stage posted an exception.
             if (PAY.buf[index].trap.valid()) {
                // *** FIX_ME #10b (part 2): Set exception bit in Active List.
@@ -286,6 +341,15 @@ void pipeline_t::dispatch() {
       // Dispatch loads and stores into the LQ/SQ and record their LQ/SQ indices.
       if (IS_MEM_OP(PAY.buf[index].flags)) {
          if (!PAY.buf[index].split_store || PAY.buf[index].upper) {
+            // Speculative disambiguation: the store-set predictor may predict a load to depend on a prior store.
+            mdp_wait = false;
+            mdp_store = 0;
+            if (MDP && SPEC_DISAMBIG && IS_LOAD(PAY.buf[index].flags)) {
+               mdp_wait = MDP->load(PAY.buf[index].pc, mdp_store);
+               if (mdp_wait)
+                  inc_counter(mdp_wait_count);
+            }
+
             LSU.dispatch(IS_LOAD(PAY.buf[index].flags),
                          PAY.buf[index].size,
                          PAY.buf[index].left,
@@ -295,7 +359,12 @@ void pipeline_t::dispatch() {
                          index,
                          PAY.buf[index].LQ_index, PAY.buf[index].LQ_phase,
                          PAY.buf[index].SQ_index, PAY.buf[index].SQ_phase,
-			 (IS_LOAD(PAY.buf[index].flags) && (!SPEC_DISAMBIG || (MEM_DEP_PRED && (MDP.find(PAY.buf[index].pc) != MDP.end())))));
+			 (IS_LOAD(PAY.buf[index].flags) && !SPEC_DISAMBIG),
+                         mdp_wait, mdp_store);
+
+            // A store becomes the last fetched store of its store set.
+            if (MDP && IS_STORE(PAY.buf[index].flags))
+               MDP->store(PAY.buf[index].pc, PAY.buf[index].SQ_index);
 
             // The lower part of a split-store should inherit the same LSU indices.
             if (PAY.buf[index].split_store) {
@@ -359,3 +428,81 @@ unsigned int pipeline_t::steer(fu_type fu) {
    fu_lane_ptr[(unsigned int)fu] = lane_id;
    return(lane_id);
 }
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Control-independent squash reuse (see pipeline_t::ci_capture()).
+//
+// Refetched instructions are matched in program order against the instructions recorded at the last
+// misprediction, starting at the reconvergence point. A reusable instruction whose source registers are
+// ready and hold the recorded source values does not need to execute: its recorded result is written to
+// its destination register and it completes in the Dispatch Stage. Any other instruction executes normally.
+// A PC mismatch, or not reaching the reconvergence point within RECONV_WINDOW instructions, ends reuse.
+//
+// Returns true if the instruction was reused.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool pipeline_t::ci_reuse(unsigned int index, bool A_ready, bool B_ready) {
+   ci_entry_t entry;
+   bool reuse;
+
+   if (ci_buf.empty())
+      return(false);
+
+   if (!ci_started) {
+      if (PAY.buf[index].pc != ci_buf[0].pc) {
+         if (++ci_wait >= RECONV_WINDOW) {
+            inc_counter(ci_abort_count);
+            ci_clear();
+         }
+         return(false);
+      }
+      ci_started = true;
+   }
+
+   entry = ci_buf[ci_pos];
+   if ((PAY.buf[index].pc != entry.pc) || ((uint32_t)PAY.buf[index].inst.bits() != entry.bits)) {
+      inc_counter(ci_abort_count);
+      ci_clear();
+      return(false);
+   }
+
+   ci_pos++;
+   if (ci_pos == ci_buf.size())
+      ci_clear();
+
+   if (!entry.reusable)
+      return(false);
+
+   reuse = ((PAY.buf[index].iq == SEL_IQ) &&
+            PAY.buf[index].C_valid &&
+            (PAY.buf[index].instruction_type == NORMAL) &&
+            !PAY.buf[index].move_elim && !PAY.buf[index].const_elim && !PAY.buf[index].fused &&
+            (!PAY.buf[index].A_valid || (A_ready && (REN->read(PAY.buf[index].A_phys_reg) == entry.A_value))) &&
+            (!PAY.buf[index].B_valid || (B_ready && (REN->read(PAY.buf[index].B_phys_reg) == entry.B_value))));
+
+   if (!reuse) {
+      inc_counter(ci_replay_count);
+      return(false);
+   }
+
+   inc_counter(ci_reuse_count);
+   PAY.buf[index].A_value.dw = entry.A_value;
+   PAY.buf[index].B_value.dw = entry.B_value;
+   PAY.buf[index].C_value.dw = entry.C_value;
+   PAY.buf[index].src_read = true;
+   PAY.buf[index].wb_done = true;
+
+   // Consumers are dispatched after this instruction, so they find the destination register ready.
+   REN->write(PAY.buf[index].C_phys_reg, entry.C_value);
+   REN->set_ready(PAY.buf[index].C_phys_reg);
+   REN->set_complete(PAY.buf[index].AL_index);
+   return(true);
+}
+
+
+void pipeline_t::ci_clear() {
+   ci_buf.clear();
+   ci_pos = 0;
+   ci_started = false;
+   ci_wait = 0;
+}
@@ -0,0 +1,154 @@
+#include <cinttypes>
+#include <cassert>
+#include "dram.h"
+#include "stats.h"
+
+dram_t::dram_t(uint64_t channels, uint64_t banks, uint64_t line_size, uint64_t row_size,
+               uint64_t rq_size, uint64_t wq_size,
+               cycle_t ctrl_latency, cycle_t tCL, cycle_t tRCD, cycle_t tRP, cycle_t tBURST,
+               stats_t *stats) {
+   assert((channels > 0) && (banks > 0) && (row_size >= line_size));
+   assert((rq_size > 0) && (wq_size > 0));
+
+   this->channels = channels;
+   this->banks = banks;
+   this->line_size = line_size;
+   this->col_bits = (row_size - line_size);
+   this->rq_size = rq_size;
+   this->wq_size = wq_size;
+   this->ctrl_latency = ctrl_latency;
+   this->tCL = tCL;
+   this->tRCD = tRCD;
+   this->tRP = tRP;
+   this->tBURST = tBURST;
+   this->stats = stats;
+
+   channel = new dram_channel_t[channels];
+   for (uint64_t c = 0; c < channels; c++) {
+      channel[c].bank = new dram_bank_t[banks];
+      for (uint64_t b = 0; b < banks; b++) {
+         channel[c].bank[b].open_row = -1;
+         channel[c].bank[b].ready = 0;
+      }
+      channel[c].bus_ready = 0;
+      channel[c].rq = new cycle_t[rq_size];
+      for (uint64_t i = 0; i < rq_size; i++)
+         channel[c].rq[i] = 0;
+      channel[c].wq.reserve(wq_size);
+   }
+}
+
+dram_t::~dram_t() {
+}
+
+// Line address bits, from least significant: column (line within the row), channel, bank, row.
+void dram_t::map(reg_t addr, uint64_t &ch, uint64_t &bank, int64_t &row) {
+   uint64_t r = ((addr >> line_size) >> col_bits);
+   ch = (r % channels);
+   r = (r / channels);
+   bank = (r % banks);
+   row = (int64_t)(r / banks);
+}
+
+// Perform one column access to "row" of bank "bank" of channel "ch", starting no earlier than "cycle".
+// Returns the cycle when its data burst is done.
+cycle_t dram_t::service(uint64_t ch, uint64_t bank, int64_t row, cycle_t cycle) {
+   dram_channel_t *c = &channel[ch];
+   dram_bank_t *b = &c->bank[bank];
+   cycle_t start;
+   cycle_t latency;
+   cycle_t data;
+
+   start = ((cycle > b->ready) ? cycle : b->ready);
+
+   if (b->open_row == row) {
+      latency = tCL;
+      inc_counter(dram_row_hit_count);
+   }
+   else if (b->open_row == -1) {
+      latency = (tRCD + tCL);
+      inc_counter(dram_row_miss_count);
+   }
+   else {
+      latency = (tRP + tRCD + tCL);
+      inc_counter(dram_row_conflict_count);
+   }
+   b->open_row = row;
+
+   data = start + latency;
+   if (data < c->bus_ready)
+      data = c->bus_ready;
+   c->bus_ready = data + tBURST;
+
+   // The next column command to this bank can follow this one by a burst.
+   b->ready = data - tCL + tBURST;
+
+   return(data + tBURST);
+}
+
+// Drain the write queue of channel "ch", FR-FCFS: each time, the write whose data is ready first (which favors row hits), oldest first among ties.
+void dram_t::drain(uint64_t ch, cycle_t cycle) {
+   std::vector<dram_write_t> &wq = channel[ch].wq;
+   std::vector<bool> done(wq.size(), false);
+
+   inc_counter(dram_wq_drain_count);
+   for (uint64_t n = 0; n < wq.size(); n++) {
+      uint64_t pick = wq.size();
+      cycle_t pick_ready = 0;
+      for (uint64_t i = 0; i < wq.size(); i++) {
+         if (!done[i]) {
+            dram_bank_t *b = &channel[ch].bank[wq[i].bank];
+            cycle_t ready = ((cycle > b->ready) ? cycle : b->ready);
+            if (b->open_row == wq[i].row)
+               ready += tCL;
+            else if (b->open_row == -1)
+               ready += (tRCD + tCL);
+            else
+               ready += (tRP + tRCD + tCL);
+
+            if ((pick == wq.size()) || (ready < pick_ready)) {
+               pick = i;
+               pick_ready = ready;
+            }
+         }
+      }
+      done[pick] = true;
+      service(ch, wq[pick].bank, wq[pick].row, cycle);
+   }
+   wq.clear();
+}
+
+cycle_t dram_t::access(cycle_t cycle, reg_t addr, bool write) {
+   uint64_t ch;
+   uint64_t bank;
+   int64_t row;
+
+   map(addr, ch, bank, row);
+   cycle += ctrl_latency;
+
+   if (write) {
+      inc_counter(dram_write_count);
+      dram_write_t w = {bank, row};
+      channel[ch].wq.push_back(w);
+      if (channel[ch].wq.size() >= wq_size)
+         drain(ch, cycle);
+      return(cycle);
+   }
+
+   inc_counter(dram_read_count);
+
+   // Get a read queue entry: the one freed first.
+   cycle_t *rq = channel[ch].rq;
+   uint64_t slot = 0;
+   for (uint64_t i = 1; i < rq_size; i++) {
+      if (rq[i] < rq[slot])
+         slot = i;
+   }
+   if (rq[slot] > cycle) {
+      inc_counter(dram_rq_full_count);
+      cycle = rq[slot];
+   }
+
+   rq[slot] = service(ch, bank, row, cycle);
+   return(rq[slot]);
+}
@@ -0,0 +1,94 @@
+#ifndef DRAM_H
+#define DRAM_H
+
+#include <vector>
+#include "decode.h"
+
+class stats_t;
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// DRAM timing model, behind the last-level cache.
+//
+// Like CacheClass, the model computes the completion cycle of an access when
+// the access is made. It keeps the state each access leaves behind.
+//
+// Organization: channels, each with its own data bus, and banks per channel,
+// each with a row buffer. The open-page policy is used. Consecutive lines
+// fall in the same row. Rows are interleaved across channels, then banks.
+//
+// Reads: a read pays the controller latency, then waits for its bank. Its
+// latency then depends on the bank's row buffer:
+// * row hit (the row is open):       tCL
+// * row miss (no row is open):       tRCD + tCL
+// * row conflict (another row open): tRP + tRCD + tCL
+// The read then waits for the channel's data bus, and holds it for tBURST.
+// Column accesses to an open row pipeline at the burst rate. Each channel's
+// read queue holds "rq_size" outstanding reads; a read that finds it full
+// waits for the oldest one to complete.
+//
+// Writes (writebacks) are acknowledged after the controller latency, and
+// wait in the channel's write queue. When it fills, the whole queue is
+// drained. The drain is scheduled FR-FCFS: the write whose data can go
+// first, which favors row hits, then the oldest among ties. A drain occupies
+// the banks and bus, and so delays later reads.
+//
+// Reads are scheduled in arrival order (FCFS per bank). A later row hit
+// cannot be moved ahead of an earlier read, because the earlier read's
+// completion cycle has already been returned to the cache.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+	int64_t open_row;		// -1: no row is open
+	cycle_t ready;			// when the bank can take its next column command
+} dram_bank_t;
+
+typedef struct {
+	uint64_t bank;
+	int64_t row;
+} dram_write_t;
+
+typedef struct {
+	dram_bank_t *bank;
+	cycle_t bus_ready;		// when the data bus is free
+	cycle_t *rq;			// completion cycles of the reads in the read queue
+	std::vector<dram_write_t> wq;	// write queue
+} dram_channel_t;
+
+class dram_t {
+private:
+	uint64_t channels;
+	uint64_t banks;			// per channel
+	uint64_t line_size;		// log2 bytes
+	uint64_t col_bits;		// log2 lines per row
+	uint64_t rq_size;
+	uint64_t wq_size;
+
+	// Timing, in processor cycles.
+	cycle_t ctrl_latency;
+	cycle_t tCL;
+	cycle_t tRCD;
+	cycle_t tRP;
+	cycle_t tBURST;
+
+	dram_channel_t *channel;
+
+	stats_t *stats;
+
+	void map(reg_t addr, uint64_t &ch, uint64_t &bank, int64_t &row);
+	cycle_t service(uint64_t ch, uint64_t bank, int64_t row, cycle_t cycle);
+	void drain(uint64_t ch, cycle_t cycle);
+
+public:
+	dram_t(uint64_t channels, uint64_t banks, uint64_t line_size, uint64_t row_size,
+	       uint64_t rq_size, uint64_t wq_size,
+	       cycle_t ctrl_latency, cycle_t tCL, cycle_t tRCD, cycle_t tRP, cycle_t tBURST,
+	       stats_t *stats);
+	~dram_t();
+
+	// Access the line containing "addr" at cycle "cycle". Returns the cycle when the line has been read or the write acknowledged.
+	cycle_t access(cycle_t cycle, reg_t addr, bool write);
+};
+
+#endif //DRAM_H
@@ -268,5 +268,7 @@ void pipeline_t::load_replay() {
       // FIX_ME #18b BEGIN
          REN->set_complete(PAY.buf[index].AL_index);
       // FIX_ME #18b END
+
+      vp_verify(index);
    }
 }
@@ -47,6 +47,12 @@ unsigned int fetch_queue::pop() {
 	return(index);
 }
 
+// the instruction (its payload buffer index) at the head of the fetch queue
+unsigned int fetch_queue::peek() {
+	assert(length > 0);
+	return(q[head]);
+}
+
 // flush the fetch queue (make it empty)
 void fetch_queue::flush() {
 	head = 0;
@@ -21,6 +21,7 @@ public:
 
 	unsigned int get_length();		// returns the number of instructions in the fetch queue
 	unsigned int pop();			// pop an instruction (its payload buffer index) from the fetch queue
+	unsigned int peek();			// the instruction (its payload buffer index) at the head of the fetch queue
 
 	void flush();				// flush the fetch queue (make it empty)
 };
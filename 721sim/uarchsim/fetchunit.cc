@@ -11,6 +11,7 @@ fetchunit_t::fetchunit_t(uint64_t instr_per_cycle,			// "n"
 			 uint64_t cond_branch_per_cycle,		// "m"
 			 uint64_t btb_entries,				// total number of entries in the BTB
 			 uint64_t btb_assoc,				// set-associativity of the BTB
+			 repl_policy_e btb_repl,			// replacement policy of the BTB
 			 uint64_t cb_pc_length, uint64_t cb_bhr_length,	// gshare cond. br. predictor: pc length (index size), bhr length
 			 uint64_t ib_pc_length, uint64_t ib_bhr_length,	// gshare indirect br. predictor: pc length (index size), bhr length
 			 uint64_t ras_size,				// # entries in the RAS
@@ -27,12 +28,16 @@ fetchunit_t::fetchunit_t(uint64_t instr_per_cycle,			// "n"
 			 uint64_t ic_num_MHSRs,				// I$ number of MHSRs
 			 uint64_t ic_miss_srv_ports,			// see CacheClass.h/cc
 			 uint64_t ic_miss_srv_latency,			// see CacheClass.h/cc
+			 repl_policy_e ic_repl,				// I$ replacement policy
+			 uint64_t fdip_depth,				// fetch-directed I$ prefetching: fetch bundles to prefetch ahead (0: disabled)
+			 bool ic_line_buffer,				// I$ fetch line buffer (see ic.h)
 			 CacheClass *L2C,				// The L2 cache that backs the instruction cache.
 			 mmu_t *mmu,					// mmu is needed by (1) the instruction cache and (2) perfect trace cache mode
 			 pipeline_t *proc,				// proc is needed by (1) PAY->map_to_actual() and PAY->predict(), and
 									//                   (2) instruction cache's access to proc's stats
 			 payload *PAY,			// (1) Payload of fetched instructions. (2) Provides a function that serves as a perfect branch predictor.
-	       std::string file //-------------------- ADDED CODE ----------------------------
+	       std::string file, //-------------------- ADDED CODE ----------------------------
+			 uint64_t mp_depth				// Dynamic multipath: maximum instructions per path (0: disabled).
        ):instr_per_cycle(instr_per_cycle),
 	      cond_branch_per_cycle(cond_branch_per_cycle),
 	      PAY(PAY),
@@ -40,9 +45,11 @@ fetchunit_t::fetchunit_t(uint64_t instr_per_cycle,			// "n"
 	      fetch_active(true),
 	      pc((uint64_t)0x2000),
 	      ic(ic_perfect, mmu, instr_per_cycle,
-	         ic_sets, ic_assoc, ic_line_size, ic_hit_latency, ic_miss_latency, ic_num_MHSRs, ic_miss_srv_ports, ic_miss_srv_latency, proc, L2C),
+	         ic_sets, ic_assoc, ic_line_size, ic_hit_latency, ic_miss_latency, ic_num_MHSRs, ic_miss_srv_ports, ic_miss_srv_latency, ic_repl, (fdip_depth > 0), ic_line_buffer, proc, L2C),
 	      ic_miss(false),
-	      btb(btb_entries, instr_per_cycle, btb_assoc, cond_branch_per_cycle),
+	      fdip_depth(fdip_depth),
+	      fdip_pc(0),
+	      btb(btb_entries, instr_per_cycle, btb_assoc, btb_repl, cond_branch_per_cycle, mp_depth),
 	      tc_enable(tc_enable),
 	      tc(tc_perfect, mmu, cond_branch_per_cycle, instr_per_cycle),
 	      cb_index(cb_pc_length, cb_bhr_length),
@@ -50,7 +57,8 @@ fetchunit_t::fetchunit_t(uint64_t instr_per_cycle,			// "n"
               ras(ras_size),
 	      bp_perfect(bp_perfect),
 	      bq(bq_size), 
-         h_file(file)            { //------------------ ADDED CODE ------------------
+         h_file(file),  //------------------ ADDED CODE ------------------
+         hammock_stats(cb_index.table_size()) {
 
    // Memory-allocate the fetch bundle from the instruction cache + BTB or from the trace cache.
    fetch_bundle = new fetch_bundle_t[instr_per_cycle];
@@ -94,6 +102,9 @@ fetchunit_t::fetchunit_t(uint64_t instr_per_cycle,			// "n"
    btb.construct_hammock_table(h_file);
    fetch_state = REGULAR;
    //--------------------------------------------------------------------------------------
+   hammock_pc = 0;
+   hammock_fetch_cycle = 0;
+   mp_pred_tag = 0;
    //branch_count = 0;
    //branch_mispredict_count = 0;
 }
@@ -131,6 +142,41 @@ void fetchunit_t::spec_update(spec_update_t *update, uint64_t cb_predictions) {
    }
 }
 
+void fetchunit_t::hammock_measure(cycle_t cycle) {
+   bool cmov = false;
+
+   for (uint64_t pos = 0; (pos < instr_per_cycle) && fetch_bundle[pos].valid; pos++) {
+      fetch_bundle[pos].hammock_pc = 0;
+      fetch_bundle[pos].hammock_gshare_index = 0;
+
+      if (fetch_bundle[pos].is_hammock) {
+         // Start of a new hammock instance.
+         hammock_pc = fetch_bundle[pos].pc;
+         hammock_fetch_cycle = cycle;
+         fetch_bundle[pos].hammock_pc = hammock_pc;
+         fetch_bundle[pos].hammock_gshare_index = cb_index.index(hammock_pc);
+         hammock_stats.fetch_hammock(hammock_pc);
+      }
+      else if (fetch_bundle[pos].region_type == THEN) {
+         fetch_bundle[pos].hammock_pc = hammock_pc;
+         hammock_stats.fetch_then(hammock_pc);
+      }
+      else if (fetch_bundle[pos].region_type == ELSE) {
+         fetch_bundle[pos].hammock_pc = hammock_pc;
+         hammock_stats.fetch_else(hammock_pc);
+      }
+      else if (fetch_bundle[pos].region_type == CMOV) {
+         fetch_bundle[pos].hammock_pc = hammock_pc;
+         hammock_stats.fetch_cmov(hammock_pc);
+         cmov = true;
+      }
+   }
+
+   // The last CMOV was injected: the next fetch bundle starts at the reconvergent PC.
+   if (cmov && (fetch_state == REGULAR))
+      hammock_stats.reconverge(hammock_pc, (cycle - hammock_fetch_cycle));
+}
+
 void fetchunit_t::transfer_fetch_bundle(fetch_state_e fetch_state) {
    uint64_t pos;	// instruction's position in the fetch bundle
    uint64_t index;	// PAY index
@@ -152,8 +198,25 @@ void fetchunit_t::transfer_fetch_bundle(fetch_state_e fetch_state) {
       PAY->buf[index].instruction_type = fetch_bundle[pos].region_type;
       PAY->buf[index].is_hammock = fetch_bundle[pos].is_hammock;
       if(PAY->buf[index].instruction_type == CMOV) PAY->buf[index].CMOV_log_reg = fetch_bundle[pos].cmov_log_reg;
+      PAY->buf[index].hammock_pc = fetch_bundle[pos].hammock_pc;
+      PAY->buf[index].hammock_gshare_index = fetch_bundle[pos].hammock_gshare_index;
+      PAY->buf[index].mp_fork = fetch_bundle[pos].mp_fork;
+      PAY->buf[index].mp_join = fetch_bundle[pos].mp_join;
+      if (fetch_bundle[pos].mp_fork || fetch_bundle[pos].mp_join)
+         PAY->buf[index].mp_taken = fetch_bundle[pos].mp_taken;
+      if (fetch_bundle[pos].mp_join) {
+         PAY->buf[index].mp_taken_pc = fetch_bundle[pos].mp_taken_pc;
+         PAY->buf[index].mp_not_taken_pc = fetch_bundle[pos].mp_not_taken_pc;
+      }
       //--------------------------------------------
 
+      // Recovery walks PAY up to its tail, which includes fetched instructions that are not decoded yet:
+      // clear the flags it checks, so that they are not left over from this entry's previous instruction.
+      PAY->buf[index].src_read = false;
+      PAY->buf[index].pp_valid = false;
+      PAY->buf[index].src_pending = false;
+      PAY->buf[index].vp_counted = false;
+
       // Clear the trap storage before the first time it is used.
       PAY->buf[index].trap.clear();
       assert(!PAY->buf[index].trap.valid());
@@ -205,6 +268,10 @@ void fetchunit_t::squash_fetch2() {
 
 // Fetch1 pipeline stage.
 void fetchunit_t::fetch1(cycle_t cycle) {
+   // Fetch-directed instruction prefetching runs ahead of the fetch pc, including while Fetch1 is stalled.
+   if (fdip_depth && fetch_active)
+      fdip(cycle);
+
    // Stall if any of the following conditions hold:
    // 1. The Fetch2 bundle hasn't advanced.
    // 2. Instruction fetching is disabled until a serializing instruction (fetch exception, amo, or csr instruction) retires.
@@ -294,6 +361,13 @@ void fetchunit_t::fetch1(cycle_t cycle) {
       }
    }
 
+   // A multipath path ended at the first instruction of the fetch bundle (see btb_t::lookup()).
+   // The bundle is empty: just redirect fetch.
+   if (!tc_hit && !ic_miss && !fetch_bundle[0].valid) {
+      pc = update.next_pc;
+      return;
+   }
+
    if (tc_hit || !ic_miss) {
       ///////////////////////////////////////////////////////////////////////////////////////////////////////////
       // Save the fetch bundle's pc, BHRs (prior to the fetch bundle), RAS TOS (prior to the fetch bundle),
@@ -311,6 +385,11 @@ void fetchunit_t::fetch1(cycle_t cycle) {
       fetch2_status.pay_checkpoint = PAY->checkpoint();
       fetch2_status.tc_hit = tc_hit;
 
+      ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+      // Tag hammock instructions and update per-hammock measurements.
+      ///////////////////////////////////////////////////////////////////////////////////////////////////////////
+      hammock_measure(cycle);
+
       ///////////////////////////////////////////////////////////////////////////////////////////////////////////
       // Transfer the fetch bundle to PAY->buf[] and push PAY indices into the FETCH2 pipeline register.
       ///////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -323,6 +402,24 @@ void fetchunit_t::fetch1(cycle_t cycle) {
    }
 }
 
+// Fetch-directed instruction prefetching.
+// Starting from the current fetch bundle, predict the next "fdip_depth" fetch bundles with the BTB and the conditional branch
+// predictor, and prefetch their instruction cache lines. Nothing is updated: the predictions use the current BHR for all bundles.
+// The walk stops at a return or indirect branch, and is skipped if the fetch pc has not changed since the last walk.
+void fetchunit_t::fdip(cycle_t cycle) {
+   uint64_t walk_pc = pc;
+
+   if (pc == fdip_pc)
+      return;
+   fdip_pc = pc;
+
+   for (uint64_t i = 0; i < fdip_depth; i++) {
+      if (!btb.peek(walk_pc, (bp_perfect ? 0 : cb[cb_index.index(walk_pc)]), walk_pc))
+         break;
+      ic.prefetch(cycle, walk_pc);
+   }
+}
+
 // Fetch2 pipeline stage.
 // If it returns true: call fetchunit_t::fetch1() after.
 // If it returns false: do NOT call fetchunit_t::fetch1() after, because of a misfetch recovery.
@@ -540,7 +637,15 @@ bool fetchunit_t::fetch2(pipeline_register DECODE[]) {
       // get PAY index
       index = FETCH2[pos].index;
       //printf("IN FETCH2 PC %llx\t", PAY->buf[index].pc);
-      if (PAY->buf[index].branch && PAY->buf[index].branch_type != HAMMOCK) {
+      // A multipath fork is a conditional branch as far as the branch predictor is concerned: it gets a branch queue entry.
+      // Its join (the last CMOV after both paths) takes over the entry: the join resolves whether the predicted path was
+      // the correct one, and the entry is committed when the join retires.
+      if (PAY->buf[index].mp_join) {
+         PAY->buf[index].pred_tag = mp_pred_tag;
+         bq.bq[mp_pred_tag >> 1].next_pc = PAY->buf[index].next_pc;
+      }
+
+      if ((PAY->buf[index].branch && PAY->buf[index].branch_type != HAMMOCK) || PAY->buf[index].mp_fork) {
       // Push an entry into the branch queue.
       // This merely allocates the entry; below, we set the entry's contents.
       //printf("Branch Queue PC %llx\n", PAY->buf[index].pc);
@@ -551,7 +656,7 @@ bool fetchunit_t::fetch2(pipeline_register DECODE[]) {
       PAY->buf[index].pred_tag = ((pred_tag << 1) | (pred_tag_phase ? 1 : 0));
 
       // Set up context-related fields in the new branch queue entry.
-      bq.bq[pred_tag].branch_type = PAY->buf[index].branch_type;
+      bq.bq[pred_tag].branch_type = (PAY->buf[index].mp_fork ? BTB_BRANCH : PAY->buf[index].branch_type);
       bq.bq[pred_tag].precise_cb_bhr = my_cb_bhr;
       bq.bq[pred_tag].precise_ib_bhr = my_ib_bhr;
       bq.bq[pred_tag].precise_ras_tos = fetch2_status.ras_tos;  // FIX_ME: unsure about this, if bundle ends in a return.
@@ -564,14 +669,21 @@ bool fetchunit_t::fetch2(pipeline_register DECODE[]) {
       bq.bq[pred_tag].misp = false;
 
       // Record the prediction.
-      taken = (PAY->buf[index].next_pc != INCREMENT_PC(PAY->buf[index].pc));
+      // For a multipath fork, the predicted next_pc is the predicted path's continuation; it is recorded when the join arrives.
+      if (PAY->buf[index].mp_fork) {
+         taken = PAY->buf[index].mp_taken;
+         mp_pred_tag = PAY->buf[index].pred_tag;
+      }
+      else {
+         taken = (PAY->buf[index].next_pc != INCREMENT_PC(PAY->buf[index].pc));
+      }
       bq.bq[pred_tag].taken = taken;
       bq.bq[pred_tag].next_pc = PAY->buf[index].next_pc;
 
       // If this is a conditional branch:
       // - Record its position within the conditional branch prediction bundle (fetch_cb_pos_in_entry).
       // - Update the precise BHRs.
-      if (PAY->buf[index].branch_type == BTB_BRANCH) {
+      if (bq.bq[pred_tag].branch_type == BTB_BRANCH) {
          // Record this conditional branch's position within the conditional branch prediction bundle.
          bq.bq[pred_tag].fetch_cb_pos_in_entry = fetch_cb_pos_in_entry;
 
@@ -661,6 +773,25 @@ void fetchunit_t::mispredict(uint64_t branch_pred_tag, bool taken, uint64_t next
 }
 
 
+// A mispredicted branch was recovered selectively (see pipeline_t::ci_recover()).
+// Steps 2 and 4 of mispredict() only: fetch continues down the current path.
+void fetchunit_t::reconverge(uint64_t branch_pred_tag, bool taken, uint64_t next_pc) {
+   uint64_t pred_tag = (branch_pred_tag >> 1);
+
+   // Correct the mispredicted branch's information in its branch queue entry.
+   assert(bq.bq[pred_tag].next_pc != next_pc);
+   bq.bq[pred_tag].next_pc = next_pc;
+
+   if (bq.bq[pred_tag].branch_type == BTB_BRANCH)
+      assert(bq.bq[pred_tag].taken != taken);
+
+   bq.bq[pred_tag].taken = taken;
+
+   // Note that the branch was mispredicted (for measuring mispredictions at retirement).
+   bq.bq[pred_tag].misp = true;
+}
+
+
 // Commit the indicated branch from the branch queue.
 // We assert that it is at the head.
 void fetchunit_t::commit(uint64_t branch_pred_tag) {
@@ -771,6 +902,7 @@ void fetchunit_t::commit(uint64_t branch_pred_tag) {
 // 4. Go active again, whether or not currently active (restore fetch_active).
 // 5. Squash the fetch2_status register and FETCH2 pipeline register.
 // 6. Reset ic_miss (discard pending I$ misses).
+// 7. Empty the I$ fetch line buffer.
 void fetchunit_t::flush(uint64_t pc) {
    uint64_t pred_tag;
 
@@ -793,6 +925,21 @@ void fetchunit_t::flush(uint64_t pc) {
 
    // 6. Reset ic_miss (discard pending I$ misses).
    ic_miss = false;
+
+   // 7. Empty the I$ fetch line buffer.
+   ic.flush();
+}
+
+
+// Update per-hammock measurements for the committing instruction at PAY index "index".
+void fetchunit_t::commit_hammock(uint64_t index, bool deactivated) {
+   if (PAY->buf[index].is_hammock) {
+      // Taken path sets the predicate (see pipeline_t::alu()).
+      hammock_stats.commit_hammock(PAY->buf[index].hammock_pc, PAY->buf[index].hammock_gshare_index, (PAY->buf[index].C_value.dw == 1));
+   }
+   else if (deactivated) {
+      hammock_stats.commit_deactivated(PAY->buf[index].hammock_pc);
+   }
 }
 
 
@@ -816,6 +963,8 @@ void fetchunit_t::output(uint64_t num_instr, uint64_t num_cycles, FILE *fp) {
    fprintf(fp, "(Number of Jump Indirects whose target was the next sequential PC = %lu)\n", meas_jumpind_seq);
    fprintf(fp, "BTB MEASUREMENTS-----------------------------------\n");
    fprintf(fp, "BTB misses (fetch cycles squashed due to a BTB miss) = %lu (%.2f%% of all cycles)\n", meas_btbmiss, 100.0*((double)meas_btbmiss/(double)num_cycles));
+   if (h_file != "")
+      hammock_stats.output(fp);
    //fprintf(fp, "Number of Times Branch Hammock fetched- %lu\n", branch_count);
    //fprintf(fp, "Number of Times Branch Hammock Mispredicted- %lu\n", branch_mispredict_count);
    //fprintf(fp, "Misprediction Rate for Hammock- %0.3f\n", (float)branch_mispredict_count/branch_count);
@@ -832,3 +981,10 @@ uint64_t fetchunit_t::getPC() {
 bool fetchunit_t::active() {
    return(fetch_active);
 }
+
+bool fetchunit_t::fetch2_index(unsigned int &index) {
+   if (!FETCH2[0].valid)
+      return(false);
+   index = FETCH2[0].index;
+   return(true);
+}
@@ -7,6 +7,7 @@
 #include "perfectbp.h"
 #include "ic.h"
 #include "tc.h"
+#include "hammock_stats.h"
 #include <string>
 #include <fstream>
 #include <unordered_map>
@@ -85,6 +86,13 @@ private:
 	bool ic_miss;
 	cycle_t ic_miss_resolve_cycle;
 
+	// Fetch-directed instruction prefetching.
+	// The BTB and conditional branch predictor walk ahead of the fetch pc, predicting the next
+	// "fdip_depth" fetch bundles, and the I$ lines of these bundles are prefetched.
+	// The walk is repeated only when the fetch pc changes.
+	uint64_t fdip_depth;		// 0: disabled
+	uint64_t fdip_pc;		// fetch pc of the last walk
+
 	// Branch Target Buffer (BTB):
 	//
 	// Locates branches within a sequential fetch bundle, and provides their types and
@@ -156,6 +164,14 @@ private:
 
 	std::string h_file; //-------------------------------------------- ADDED CODE -----------------------------------
 	fetch_state_e fetch_state;
+
+	// Per-hammock measurements.
+	hammock_stats_t hammock_stats;
+	uint64_t hammock_pc;		// PC of the most recently fetched hammock.
+	cycle_t hammock_fetch_cycle;	// Cycle at which it was fetched.
+
+	// Dynamic multipath execution (see btb.h).
+	uint64_t mp_pred_tag;		// Branch queue entry of the most recent multipath fork. Its join resolves it.
 	////////////////////////////
 	// Private functions.
 	////////////////////////////
@@ -163,6 +179,12 @@ private:
 	// Function for speculatively updating the pc, BHRs, and RAS, based on the assembled fetch bundle.
 	void spec_update(spec_update_t *update, uint64_t cb_predictions);
 
+	// Function for fetch-directed instruction prefetching.
+	void fdip(cycle_t cycle);
+
+	// Function for tagging THEN/ELSE/CMOV instructions of the fetch bundle with their hammock, and updating per-hammock fetch measurements.
+	void hammock_measure(cycle_t cycle);
+
 	// Function for transferring the fetch bundle into (1) the PAY buffer and (2) the FETCH2 pipeline register.
 	void transfer_fetch_bundle(fetch_state_e fetch_state);
 
@@ -174,6 +196,7 @@ public:
 	            uint64_t cond_branch_per_cycle,			// "m"
 	            uint64_t btb_entries,				// total number of entries in the BTB
 	            uint64_t btb_assoc,					// set-associativity of the BTB
+	            repl_policy_e btb_repl,				// replacement policy of the BTB
 	            uint64_t cb_pc_length, uint64_t cb_bhr_length,	// gshare cond. br. predictor: pc length (index size), bhr length
 	            uint64_t ib_pc_length, uint64_t ib_bhr_length,	// gshare indirect br. predictor: pc length (index size), bhr length
 	            uint64_t ras_size,					// # entries in the RAS
@@ -190,11 +213,15 @@ public:
 		    uint64_t ic_num_MHSRs,				// I$ number of MHSRs
 		    uint64_t ic_miss_srv_ports,				// see CacheClass.h/cc
 		    uint64_t ic_miss_srv_latency,			// see CacheClass.h/cc
+		    repl_policy_e ic_repl,				// I$ replacement policy
+		    uint64_t fdip_depth,				// fetch-directed I$ prefetching: fetch bundles to prefetch ahead (0: disabled)
+		    bool ic_line_buffer,				// I$ fetch line buffer (see ic.h)
 		    CacheClass *L2C,					// The L2 cache that backs the instruction cache.
 		    mmu_t *mmu,						// mmu is needed by (1) the instruction cache and (2) perfect trace cache mode
 		    pipeline_t *proc,					// proc is needed by (1) PAY->map_to_actual() and PAY->predict(), and
 									//                   (2) instruction cache's access to proc's stats
-		    payload *PAY, std::string file);			// (1) Payload of fetched instructions. (2) Provides a function that serves as a perfect branch predictor.
+		    payload *PAY, std::string file,			// (1) Payload of fetched instructions. (2) Provides a function that serves as a perfect branch predictor.
+		    uint64_t mp_depth);					// Dynamic multipath: maximum instructions per path (0: disabled).
 	~fetchunit_t();
 
 	// Predict and supply a fetch bundle from either the instruction cache + BTB or the trace cache.
@@ -231,10 +258,20 @@ public:
 	// 7. Squash the fetch2_status register and FETCH2 pipeline register.
 	void mispredict(uint64_t branch_pred_tag, bool taken, uint64_t next_pc);
 
+	// A mispredicted branch was recovered selectively: the instructions fetched after its reconvergence point
+	// were kept (see pipeline_t::ci_recover()).
+	// Steps 2 and 4 of mispredict() only. Fetch continues down the current path, so the later branch queue
+	// entries, global histories, and RAS are left as they are (the histories keep the wrong outcome of the branch).
+	void reconverge(uint64_t branch_pred_tag, bool taken, uint64_t next_pc);
+
 	// Commit the indicated branch from the branch queue.
 	// We assert that it is at the head.
 	void commit(uint64_t branch_pred_tag);
 
+	// Update per-hammock measurements for the committing instruction at PAY index "index".
+	// Hammocks train the shadow gshare predictor; deactivated instructions are charged to their hammock.
+	void commit_hammock(uint64_t index, bool deactivated);
+
 	// Complete squash.
 	// 1. Roll-back the branch queue to the head entry.
 	// 2. Restore checkpointed global histories and the RAS (as best we can for RAS).
@@ -253,4 +290,8 @@ public:
 
 	// Public function for querying fetch_active.
 	bool active();
+
+	// Public function for querying the PAY index of the oldest instruction in the Fetch2 stage.
+	// Returns false if the Fetch2 stage is empty.
+	bool fetch2_index(unsigned int &index);
 };
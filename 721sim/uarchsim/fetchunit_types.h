@@ -48,6 +48,15 @@ struct {
 	inst_region_e region_type;
 	uint64_t cmov_log_reg;
 	bool is_hammock;
+	uint64_t hammock_pc;		// PC of the hammock that this THEN/ELSE/CMOV instruction belongs to (or the hammock's own PC).
+	uint64_t hammock_gshare_index;	// Hammock only: shadow gshare index (see hammock_stats.h).
+
+	// Dynamic multipath execution (see btb.h).
+	bool mp_fork;			// Multipath fork branch.
+	bool mp_join;			// Last CMOV of a multipath fork: resolves which path continues.
+	bool mp_taken;			// Fork/join: predicted direction of the fork branch.
+	uint64_t mp_taken_pc;		// Join only: PC after the last instruction of the taken path.
+	uint64_t mp_not_taken_pc;	// Join only: PC after the last instruction of the not-taken path.
 } fetch_bundle_t;
 
 
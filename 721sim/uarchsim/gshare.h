@@ -1,3 +1,6 @@
+#ifndef GSHARE_H
+#define GSHARE_H
+
 class gshare_index_t {
 private:
 	// Global branch history register.
@@ -32,3 +35,5 @@ public:
 	uint64_t get_bhr();
 	void set_bhr(uint64_t bhr);
 };
+
+#endif //GSHARE_H
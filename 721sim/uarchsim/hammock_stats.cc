@@ -0,0 +1,89 @@
+#include <cinttypes>
+#include <cstring>
+#include <cassert>
+#include "hammock_stats.h"
+
+hammock_stats_t::hammock_stats_t(uint64_t gshare_table_size) {
+   shadow_size = gshare_table_size;
+   shadow = new uint8_t[shadow_size];
+   for (uint64_t i = 0; i < shadow_size; i++)
+      shadow[i] = 2; // Initialize counters to weakly-taken, same as the real gshare predictor.
+}
+
+hammock_stats_t::~hammock_stats_t() {
+}
+
+hammock_stat_t &hammock_stats_t::lookup(uint64_t pc) {
+   std::map<uint64_t, hammock_stat_t>::iterator it = table.find(pc);
+   if (it == table.end()) {
+      hammock_stat_t entry;
+      memset(&entry, 0, sizeof(entry));
+      it = table.insert(std::make_pair(pc, entry)).first;
+   }
+   return(it->second);
+}
+
+void hammock_stats_t::fetch_hammock(uint64_t pc) {
+   lookup(pc).fetched++;
+}
+
+void hammock_stats_t::fetch_then(uint64_t pc) {
+   lookup(pc).then_fetched++;
+}
+
+void hammock_stats_t::fetch_else(uint64_t pc) {
+   lookup(pc).else_fetched++;
+}
+
+void hammock_stats_t::fetch_cmov(uint64_t pc) {
+   lookup(pc).cmovs++;
+}
+
+void hammock_stats_t::reconverge(uint64_t pc, uint64_t cycles) {
+   hammock_stat_t &entry = lookup(pc);
+   entry.reconverged++;
+   entry.reconv_cycles += cycles;
+}
+
+void hammock_stats_t::commit_hammock(uint64_t pc, uint64_t gshare_index, bool taken) {
+   hammock_stat_t &entry = lookup(pc);
+   assert(gshare_index < shadow_size);
+
+   entry.committed++;
+   if ((shadow[gshare_index] >= 2) != taken)
+      entry.gshare_m++;
+
+   // Train the shadow gshare predictor.
+   if (taken) {
+      if (shadow[gshare_index] < 3)
+         shadow[gshare_index]++;
+   }
+   else {
+      if (shadow[gshare_index] > 0)
+         shadow[gshare_index]--;
+   }
+}
+
+void hammock_stats_t::commit_deactivated(uint64_t pc) {
+   lookup(pc).deactivated++;
+}
+
+void hammock_stats_t::output(FILE *fp) {
+   fprintf(fp, "HAMMOCK MEASUREMENTS-------------------------------\n");
+   fprintf(fp, "PC                   fetched   committed        then        else       cmovs deactivated  reconv  gshare_m  gshare_mr\n");
+   for (std::map<uint64_t, hammock_stat_t>::iterator it = table.begin(); it != table.end(); it++) {
+      hammock_stat_t &entry = it->second;
+      fprintf(fp, "%16lx %11lu %11lu %11lu %11lu %11lu %11lu %7.2lf %9lu %9.2lf%%\n",
+              it->first,
+              entry.fetched,
+              entry.committed,
+              entry.then_fetched,
+              entry.else_fetched,
+              entry.cmovs,
+              entry.deactivated,
+              (entry.reconverged ? ((double)entry.reconv_cycles/(double)entry.reconverged) : 0.0),
+              entry.gshare_m,
+              (entry.committed ? 100.0*((double)entry.gshare_m/(double)entry.committed) : 0.0));
+   }
+   fprintf(fp, "(reconv = average cycles from fetching the hammock to fetching its reconvergent PC)\n");
+}
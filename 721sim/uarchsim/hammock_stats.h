@@ -0,0 +1,66 @@
+#ifndef HAMMOCK_STATS_H
+#define HAMMOCK_STATS_H
+
+#include <cinttypes>
+#include <cstdio>
+#include <map>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Per-hammock measurements, keyed by hammock PC (the PCs listed in the
+// hammock table, see btb.h).
+//
+// Fetch-side counts (fetched instances, THEN/ELSE instructions, CMOVs,
+// fetch-to-reconvergence cycles) include wrong-path fetching.
+// Retire-side counts (committed instances, deactivated instructions,
+// shadow gshare mispredictions) only include committed instructions.
+//
+// The shadow gshare predictor estimates the mispredictions each hammock
+// branch would have incurred without predication. It uses a private table of
+// 2-bit counters, indexed with the hammock PC and the fetch unit's
+// conditional branch history at the time the hammock was fetched, and is
+// trained when the hammock retires.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+	uint64_t fetched;		// # dynamic instances fetched
+	uint64_t committed;		// # dynamic instances committed
+	uint64_t then_fetched;		// # THEN instructions fetched
+	uint64_t else_fetched;		// # ELSE instructions fetched
+	uint64_t cmovs;			// # CMOVs injected
+	uint64_t deactivated;		// # instructions deactivated at precommit (committed without effect)
+	uint64_t reconverged;		// # instances whose fetch reached the reconvergent PC
+	uint64_t reconv_cycles;		// total cycles from hammock fetch to reconvergence
+	uint64_t gshare_m;		// # committed instances that gshare would have mispredicted
+} hammock_stat_t;
+
+class hammock_stats_t {
+private:
+	std::map<uint64_t, hammock_stat_t> table;	// ordered by hammock PC for the report
+
+	// Shadow gshare predictor.
+	uint8_t *shadow;
+	uint64_t shadow_size;
+
+	hammock_stat_t &lookup(uint64_t pc);
+
+public:
+	hammock_stats_t(uint64_t gshare_table_size);
+	~hammock_stats_t();
+
+	// Fetch side.
+	void fetch_hammock(uint64_t pc);
+	void fetch_then(uint64_t pc);
+	void fetch_else(uint64_t pc);
+	void fetch_cmov(uint64_t pc);
+	void reconverge(uint64_t pc, uint64_t cycles);
+
+	// Retire side.
+	void commit_hammock(uint64_t pc, uint64_t gshare_index, bool taken);
+	void commit_deactivated(uint64_t pc);
+
+	void output(FILE *fp);
+};
+
+#endif //HAMMOCK_STATS_H
@@ -212,3 +212,140 @@ void HistogramClass::PrintStat(ostream& out)
 	out << "Standard Deviation: " << sqrt(Variance()) << "\n";
 }
 #endif
+
+
+/*--------------------------------------------------------------------------*\
+ | LogHistogramClass
+\*--------------------------------------------------------------------------*/
+
+LogHistogramClass::LogHistogramClass(int subBits, int maxBits)
+{
+	assert((subBits >= 0) && (maxBits > subBits) && (maxBits < 64));
+
+	this->subBits = subBits;
+	this->maxBits = maxBits;
+
+	// 2^subBits exact buckets, 2^subBits buckets for each power of two up
+	// to 2^maxBits, and one bucket for higher values.
+	hist.resize(((maxBits - subBits + 1) << subBits) + 1);
+	Clear();
+}
+
+void LogHistogramClass::Clear()
+{
+	for (unsigned int i=0; i<hist.size(); i++) {
+		hist[i] = 0;
+	}
+	samples = 0;
+	sum = 0;
+	max = 0;
+}
+
+unsigned int LogHistogramClass::Bucket(uint64_t value)
+{
+	int e;
+
+	if (value < ((uint64_t)1 << subBits))
+		return((unsigned int)value);
+	if (value >= ((uint64_t)1 << maxBits))
+		return(hist.size() - 1);
+
+	e = (63 - __builtin_clzll(value));	// 2^e <= value < 2^(e+1)
+	return(((e - subBits + 1) << subBits) + ((value >> (e - subBits)) & (((uint64_t)1 << subBits) - 1)));
+}
+
+uint64_t LogHistogramClass::Low(unsigned int bucket)
+{
+	unsigned int e;
+
+	if (bucket < ((unsigned int)1 << subBits))
+		return(bucket);
+	if (bucket == (hist.size() - 1))
+		return((uint64_t)1 << maxBits);
+
+	e = ((bucket >> subBits) + subBits - 1);
+	return(((uint64_t)1 << e) + ((uint64_t)(bucket & ((1 << subBits) - 1)) << (e - subBits)));
+}
+
+uint64_t LogHistogramClass::High(unsigned int bucket)
+{
+	if (bucket == (hist.size() - 1))
+		return(max);
+	return(Low(bucket + 1) - 1);
+}
+
+void LogHistogramClass::Increment(uint64_t value)
+{
+	hist[Bucket(value)]++;
+	samples++;
+	sum += value;
+	if (value > max)
+		max = value;
+}
+
+uint64_t LogHistogramClass::Samples()
+{
+	return(samples);
+}
+
+uint64_t LogHistogramClass::Sum()
+{
+	return(sum);
+}
+
+uint64_t LogHistogramClass::Max()
+{
+	return(max);
+}
+
+double LogHistogramClass::Average()
+{
+	return(samples ? ((double)sum/(double)samples) : 0.0);
+}
+
+uint64_t LogHistogramClass::Percentile(double p)
+{
+	uint64_t rank;
+	uint64_t n = 0;
+	uint64_t high;
+
+	assert((p > 0.0) && (p <= 100.0));
+	if (samples == 0)
+		return(0);
+
+	// The rank of the p-th percentile sample, counting from 1.
+	rank = (uint64_t)(((p * (double)samples) + 99.0) / 100.0);
+	if (rank == 0)
+		rank = 1;
+
+	for (unsigned int i=0; i<hist.size(); i++) {
+		n += hist[i];
+		if (n >= rank) {
+			high = High(i);
+			return((high < max) ? high : max);
+		}
+	}
+	return(max);
+}
+
+void LogHistogramClass::PrintSummary(FILE* fp)
+{
+	fprintf(fp, "samples = %" PRIu64 ", avg = %.2f, p50 = %" PRIu64 ", p90 = %" PRIu64 ", p99 = %" PRIu64 ", max = %" PRIu64 "\n",
+	        samples, Average(), Percentile(50.0), Percentile(90.0), Percentile(99.0), max);
+}
+
+void LogHistogramClass::Print(FILE* fp)
+{
+	uint64_t n = 0;
+
+	fprintf(fp, "  ");
+	PrintSummary(fp);
+	for (unsigned int i=0; i<hist.size(); i++) {
+		if (hist[i]) {
+			n += hist[i];
+			fprintf(fp, "  %8" PRIu64 " - %-8" PRIu64 " %12" PRIu64 " %6.2f%% %7.2f%%\n",
+			        Low(i), High(i), hist[i],
+			        100.0*(double)hist[i]/(double)samples, 100.0*(double)n/(double)samples);
+		}
+	}
+}
@@ -2,6 +2,9 @@
 #define HISTOGRAM_H
 
 #include <iostream>
+#include <cstdio>
+#include <cinttypes>
+#include <vector>
 
 /*--------------------------------------------------------------------------*\
  | histogram.h
@@ -117,4 +120,64 @@ private:
 };
 
 
+/*--------------------------------------------------------------------------*\
+ | Log-bucketed histogram, for latencies (HDR-style).
+ |
+ | Values below 2^subBits each have their own bucket. Above that, each
+ |  power of two [2^e, 2^(e+1)) is split into 2^subBits equal buckets, so a
+ |  bucket's width is within 1/2^subBits of its values. Values of 2^maxBits
+ |  and higher all go into the last bucket.
+ |
+ | The sum and the maximum are kept exactly.
+\*--------------------------------------------------------------------------*/
+class LogHistogramClass
+{
+public:
+	LogHistogramClass(int subBits = 2, int maxBits = 24);
+
+	void Increment(uint64_t value);
+	/*------------------------------------------------------------------------*\
+	 | Adds one sample.
+	\*------------------------------------------------------------------------*/
+
+	void Clear();
+
+	uint64_t Samples();
+	uint64_t Sum();
+	uint64_t Max();
+	double Average();
+
+	uint64_t Percentile(double p);
+	/*------------------------------------------------------------------------*\
+	 | Returns the highest value of the bucket holding the p-th percentile
+	 |  sample (0 < p <= 100), capped at Max().
+	\*------------------------------------------------------------------------*/
+
+	void PrintSummary(FILE* fp);
+	/*------------------------------------------------------------------------*\
+	 | Prints samples, average, 50th/90th/99th percentiles and maximum, on
+	 |  one line.
+	\*------------------------------------------------------------------------*/
+
+	void Print(FILE* fp);
+	/*------------------------------------------------------------------------*\
+	 | Prints the summary, then one line per non-empty bucket: its range of
+	 |  values, samples, and the percentage and cumulative percentage of all
+	 |  samples.
+	\*------------------------------------------------------------------------*/
+
+private:
+	int subBits;
+	int maxBits;
+	std::vector<uint64_t> hist;
+	uint64_t samples;
+	uint64_t sum;
+	uint64_t max;
+
+	unsigned int Bucket(uint64_t value);
+	uint64_t Low(unsigned int bucket);	/* Lowest value of a bucket.  */
+	uint64_t High(unsigned int bucket);	/* Highest value of a bucket. */
+};
+
+
 #endif //HISTOGRAM_H
@@ -1,8 +1,10 @@
+#include <algorithm>
 #include "processor.h"
 #include "mmu.h"
 
 #include "CacheClass.h"
 #include "fetchunit_types.h"
+#include "pipeline.h"
 #include "ic.h"
 
 
@@ -17,13 +19,19 @@ ic_t::ic_t(bool perfect,
 	   uint64_t num_MHSRs,
 	   uint64_t miss_srv_ports,
 	   uint64_t miss_srv_latency,
+	   repl_policy_e repl,
+	   bool fdip,
+	   bool line_buffer,
 	   pipeline_t *proc,
 	   CacheClass *L2C) {
    this->perfect = perfect;
    this->mmu = mmu;
-   IC = new CacheClass(sets, assoc, line_size, hit_latency, miss_latency, num_MHSRs, miss_srv_ports, miss_srv_latency, proc, "l1_ic", L2C);
+   IC = new CacheClass(sets, assoc, line_size, hit_latency, miss_latency, num_MHSRs, miss_srv_ports, miss_srv_latency, repl, proc, "l1_ic", L2C);
    this->line_size = line_size;
    this->fetch_width = fetch_width;
+   if (fdip)
+      IC->register_prefetch_counters();
+   stats = proc->get_stats();
 
    // fetch_width: number of instructions in a full fetch bundle.
    // line_size: log2 the line size (where line size is in bytes).
@@ -33,9 +41,56 @@ ic_t::ic_t(bool perfect,
 
    // Assert that the fetch width is less than or equal to the number of instructions in a cache line.
    assert(fetch_width <= (1 << (line_size - 2)));	// The 2 is for a 4-byte instruction.
+
+   // The fetch line buffer needs the two lines of a lookup to be in different sets.
+   lb_enable = (line_buffer && (sets > 1));
+   lb_words = ((uint64_t)1 << (line_size - 2));
+   lb_line = 0;
+   for (uint64_t e = 0; e < 2; e++) {
+      lb_valid[e] = false;
+      lb_insn[e] = new insn_t[lb_words];
+      lb_insn_valid[e] = new bool[lb_words];
+   }
 }
 
 ic_t::~ic_t() {
+   for (uint64_t e = 0; e < 2; e++) {
+      delete [] lb_insn[e];
+      delete [] lb_insn_valid[e];
+   }
+}
+
+// Is "line" in the fetch line buffer? If so, "e" is its entry.
+bool ic_t::lb_find(uint64_t line, uint64_t &e) {
+   if (!lb_enable || (line < lb_line) || (line > (lb_line + 1)))
+      return(false);
+   e = (line - lb_line);
+   return(lb_valid[e]);
+}
+
+// Put "line" and the line after it, which both just hit, in the fetch line buffer.
+// Instructions already fetched from a line that stays in the buffer are kept.
+void ic_t::lb_fill(uint64_t line) {
+   if (lb_valid[1] && (line == (lb_line + 1))) {
+      // Sequential fetch moved into the second line: it becomes the first.
+      std::swap(lb_insn[0], lb_insn[1]);
+      std::swap(lb_insn_valid[0], lb_insn_valid[1]);
+      lb_valid[0] = true;
+      lb_valid[1] = false;
+   }
+   else if (line != lb_line) {
+      lb_valid[0] = false;
+      lb_valid[1] = false;
+   }
+   lb_line = line;
+
+   for (uint64_t e = 0; e < 2; e++) {
+      if (!lb_valid[e]) {
+         lb_valid[e] = true;
+         for (uint64_t w = 0; w < lb_words; w++)
+            lb_insn_valid[e][w] = false;
+      }
+   }
 }
 
 // Inputs:
@@ -50,7 +105,9 @@ ic_t::~ic_t() {
 bool ic_t::lookup(cycle_t cycle, uint64_t pc, fetch_bundle_t bundle[], cycle_t &miss_resolve_cycle) {
    uint64_t line1, line2;
    bool hit1, hit2;
-   cycle_t resolve_cycle1, resolve_cycle2;
+   cycle_t resolve_cycle1 = 0, resolve_cycle2 = 0;
+   uint64_t e;
+   bool lb_hit1, lb_hit2;
 
    //////////////////////////////////////////////////////
    // Model I$ misses.
@@ -60,16 +117,46 @@ bool ic_t::lookup(cycle_t cycle, uint64_t pc, fetch_bundle_t bundle[], cycle_t &
       // Model an interleaved I$ with two banks: fetch two consecutive lines, starting with the line that the pc falls within.
       line1 = (pc >> line_size);
       line2 = (pc >> line_size) + 1;
-      resolve_cycle1 = IC->Access(0, cycle, (line1 << line_size), false, &hit1);
-      resolve_cycle2 = IC->Access(0, cycle, (line2 << line_size), false, &hit2);
+
+      // A line in the fetch line buffer hits without a lookup.
+      // A miss fills a line and allocates an MHSR (see prefetch()): the buffer may no longer hold the most recently used lines.
+      lb_hit1 = lb_find(line1, e);
+      if (lb_hit1) {
+         IC->RecordReadHit();
+         hit1 = true;
+      }
+      else {
+         resolve_cycle1 = IC->Access(0, cycle, (line1 << line_size), false, &hit1);
+         if (!hit1)
+            flush();
+      }
+      lb_hit2 = lb_find(line2, e);
+      if (lb_hit2) {
+         IC->RecordReadHit();
+         hit2 = true;
+      }
+      else {
+         resolve_cycle2 = IC->Access(0, cycle, (line2 << line_size), false, &hit2);
+      }
 
       if (!hit1 || !hit2) {
+         flush();
          miss_resolve_cycle = MAX((hit1 ? (cycle_t)0 : resolve_cycle1), (hit2 ? (cycle_t)0 : resolve_cycle2));
          assert(miss_resolve_cycle > cycle);
          return(false);	// I$ miss, and we properly set the miss_resolve_cycle.
       }
+
+      if (lb_hit1 && lb_hit2)
+         inc_counter(ic_line_buffer_hit_count);
+   }
+   else {
+      line1 = (pc >> line_size);
    }
 
+   // Both lines hit (or the I$ is perfect): they are the most recently used lines of their sets.
+   if (lb_enable)
+      lb_fill(line1);
+
    //////////////////////////////////////////////////////
    // Get fetch_width sequential instructions.
    //////////////////////////////////////////////////////
@@ -77,6 +164,14 @@ bool ic_t::lookup(cycle_t cycle, uint64_t pc, fetch_bundle_t bundle[], cycle_t &
       // Try fetching the instruction via the MMU.
       // Generate a "NOP with fetch exception" if the MMU reference generates an exception.
       bundle[i].exception = false;
+
+      // Reuse the instruction if it was already fetched from the line.
+      if (lb_find((pc >> line_size), e) && lb_insn_valid[e][(pc >> 2) & (lb_words - 1)]) {
+         bundle[i].insn = lb_insn[e][(pc >> 2) & (lb_words - 1)];
+         pc = INCREMENT_PC(pc);
+         continue;
+      }
+
       try {
          bundle[i].insn = (mmu->load_insn(pc)).insn;
       }
@@ -87,9 +182,39 @@ bool ic_t::lookup(cycle_t cycle, uint64_t pc, fetch_bundle_t bundle[], cycle_t &
 	 break;	// Exit loop: terminate the sequential fetch bundle at the offending instruction.
       }
 
+      // Keep the instruction in the fetch line buffer. Instructions that raise a fetch exception are not kept.
+      if (lb_find((pc >> line_size), e)) {
+         lb_insn[e][(pc >> 2) & (lb_words - 1)] = bundle[i].insn;
+         lb_insn_valid[e][(pc >> 2) & (lb_words - 1)] = true;
+      }
+
       // Increment pc to get to the next sequential instruction.
       pc = INCREMENT_PC(pc);
    }
 
    return(true);	// I$ hit, and the miss_resolve_cycle is a dont-care.
 }
+
+// Fetch-directed instruction prefetching: prefetch the two lines that a lookup of the fetch bundle at "pc" would access.
+// The prefetches do not train the L2 prefetcher, which is trained on data accesses. A prefetch that is not issued (its line is
+// cached or in flight, or too few MHSRs are free) leaves the I$, including its replacement state, unchanged.
+void ic_t::prefetch(cycle_t cycle, uint64_t pc) {
+   uint64_t line;
+
+   if (perfect)
+      return;
+
+   for (line = (pc >> line_size); line <= ((pc >> line_size) + 1); line++) {
+      // An issued prefetch allocates an MHSR, and freeing the MHSR's previous miss looks up that line, in any set: empty the fetch line buffer.
+      if (IC->Prefetch(0, cycle, line, 0))
+         flush();
+   }
+}
+
+// Empty the fetch line buffer.
+// The fetch unit calls this on a complete squash. Complete squashes follow exceptions and serializing instructions, after which the
+// instructions or their translations may have changed.
+void ic_t::flush() {
+   lb_valid[0] = false;
+   lb_valid[1] = false;
+}
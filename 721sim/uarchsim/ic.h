@@ -1,4 +1,6 @@
 
+class stats_t;
+
 class ic_t {
 private:
 	bool perfect;		// If true, I$ always hits.
@@ -7,6 +9,25 @@ private:
 	uint64_t line_size;	// Log2 of line size (where line size is in bytes).
 	uint64_t fetch_width;	// Number of instructions in a full fetch bundle. We assert that (fetch_width == (1 << (line_size - 2))). The 2 is for a 4-byte instr.
 
+	// Fetch line buffer: the two lines of the last lookup that hit, and the instructions fetched from them so far.
+	// A line in the buffer is the most recently used line of its set, and is not being loaded. Looking it up again would
+	// only count a hit and leave the I$ state (including the replacement state) unchanged, so the lookup is skipped and
+	// the hit is just counted. The same goes for the MMU: an instruction already fetched from the line is reused.
+	// This requires the two lines to be in different sets (sets > 1). Anything else that may update the replacement state
+	// of a line's set empties the buffer: any miss or issued prefetch (an MHSR allocation). Prefetches that are not issued
+	// only probe the I$. A complete squash also empties the buffer (see flush()).
+	bool lb_enable;
+	bool lb_valid[2];	// Entry 0 holds the line at lb_line, entry 1 the line after it.
+	uint64_t lb_line;
+	uint64_t lb_words;	// Instructions per line.
+	insn_t *lb_insn[2];
+	bool *lb_insn_valid[2];
+
+	stats_t *stats;
+
+	bool lb_find(uint64_t line, uint64_t &e);
+	void lb_fill(uint64_t line);
+
 public:
 	ic_t(bool perfect, 
 	     mmu_t *mmu,
@@ -19,9 +40,14 @@ public:
 	     uint64_t num_MHSRs,
 	     uint64_t miss_srv_ports,
 	     uint64_t miss_srv_latency,
+	     repl_policy_e repl,
+	     bool fdip,
+	     bool line_buffer,
 	     pipeline_t *proc,
 	     CacheClass *L2C);
 	~ic_t();
 
 	bool lookup(cycle_t cycle, uint64_t pc, fetch_bundle_t bundle[], cycle_t &miss_resolve_cycle);
+	void prefetch(cycle_t cycle, uint64_t pc);
+	void flush();
 };
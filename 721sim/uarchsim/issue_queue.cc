@@ -38,7 +38,7 @@ bool issue_queue::stall(unsigned int bundle_inst) {
 	return(fl_length < bundle_inst);
 }
 
-void issue_queue::dispatch(unsigned int index, unsigned long long branch_mask, unsigned int lane_id,
+void issue_queue::dispatch(unsigned int index, const branch_mask_t &branch_mask, unsigned int lane_id,
                            bool A_valid, bool A_ready, unsigned int A_tag,
                            bool B_valid, bool B_ready, unsigned int B_tag,
                            bool D_valid, bool D_ready, unsigned int D_tag) {
@@ -129,6 +129,28 @@ void issue_queue::wakeup(unsigned int tag) {
 	}
 }
 
+// Selective recovery of a mispredicted branch (see pipeline_t::ci_recover()): the instruction at PAY index
+// 'index' now reads physical register 'new_tag' instead of 'old_tag', with the indicated ready bit.
+void issue_queue::rename_source(unsigned int index, unsigned int old_tag, unsigned int new_tag, bool ready) {
+	for (unsigned int i = 0; i < size; i++) {
+		if (q[i].valid && (q[i].index == index)) {
+			if (q[i].A_valid && (q[i].A_tag == old_tag)) {
+				q[i].A_tag = new_tag;
+				q[i].A_ready = ready;
+			}
+			if (q[i].B_valid && (q[i].B_tag == old_tag)) {
+				q[i].B_tag = new_tag;
+				q[i].B_ready = ready;
+			}
+			if (q[i].D_valid && (q[i].D_tag == old_tag)) {
+				q[i].D_tag = new_tag;
+				q[i].D_ready = ready;
+			}
+			return;
+		}
+	}
+}
+
 void issue_queue::select_and_issue(unsigned int num_lanes, lane* Execution_Lanes) {
    unsigned int i, j;
    bool issue;
@@ -282,17 +304,22 @@ void issue_queue::flush() {
 	youngest = -1;
 }
 
+// Instructions enter the IQ in program order and the age-ordered list links them in that order, so the
+// instructions that depend on a branch (have its bit set) are always the youngest ones in the list.
+// Clearing a branch bit and squashing only walk those instructions, from the youngest.
+
 void issue_queue::clear_branch_bit(unsigned int branch_ID) {
-	for (unsigned int i = 0; i < size; i++) {
-		CLEAR_BIT(q[i].branch_mask, branch_ID);
+	for (int i = youngest; (i != -1) && q[i].branch_mask.test(branch_ID); i = q[i].prev) {
+		q[i].branch_mask.clear(branch_ID);
 	}
 }
 
 void issue_queue::squash(unsigned int branch_ID) {
-	for (unsigned int i = 0; i < size; i++) {
-		if (q[i].valid && BIT_IS_ONE(q[i].branch_mask, branch_ID)) {
-			remove(i);
-		}
+	int i, prev;
+
+	for (i = youngest; (i != -1) && q[i].branch_mask.test(branch_ID); i = prev) {
+		prev = q[i].prev;
+		remove(i);
 	}
 }
 
@@ -302,7 +329,10 @@ void issue_queue::dump_iq(pipeline_t* proc, unsigned int index,FILE* file)
   proc->disasm(proc->PAY.buf[q[index].index].inst,proc->cycle,proc->PAY.buf[q[index].index].pc,proc->PAY.buf[q[index].index].sequence,file);
   ifprintf(logging_on,file,"fl_head %d fl_tail %d fl_length %d\n",fl_head, fl_tail, fl_length);
   ifprintf(logging_on,file,"valid      : %u\t",           q[index].valid);
-  ifprintf(logging_on,file,"branch_mask: %" PRIu64 "\t",  q[index].branch_mask);
+  ifprintf(logging_on,file,"branch_mask: ");
+  for (unsigned int i = q[index].branch_mask.words(); i > 0; i--)
+    ifprintf(logging_on,file,"%016" PRIx64,            q[index].branch_mask.word(i-1));
+  ifprintf(logging_on,file,"\t");
   ifprintf(logging_on,file,"lane_id    : %u\t",           q[index].lane_id);
   ifprintf(logging_on,file,"\n");
   ifprintf(logging_on,file,"RS1_Valid  : %u\t",           q[index].A_valid);
@@ -1,6 +1,8 @@
 #ifndef ISSUE_QUEUE_H
 #define ISSUE_QUEUE_H
 
+#include "branch_mask.h"
+
 typedef struct {
 
 	// Valid bit for the issue queue entry as a whole.
@@ -11,7 +13,7 @@ typedef struct {
 	unsigned int index;
 
 	// Branches that this instruction depends on.
-	uint64_t branch_mask;
+	branch_mask_t branch_mask;
 
 	// Execution lane that this instruction wants.
 	unsigned int lane_id;
@@ -71,11 +73,12 @@ private:
 public:
 	issue_queue(unsigned int size, unsigned int num_parts, pipeline_t* _proc=NULL);	// constructor
 	bool stall(unsigned int bundle_inst);
-	void dispatch(unsigned int index, unsigned long long branch_mask, unsigned int lane_id,
+	void dispatch(unsigned int index, const branch_mask_t &branch_mask, unsigned int lane_id,
 	              bool A_valid, bool A_ready, unsigned int A_tag,
 	              bool B_valid, bool B_ready, unsigned int B_tag,
 	              bool D_valid, bool D_ready, unsigned int D_tag);
 	void wakeup(unsigned int tag);
+	void rename_source(unsigned int index, unsigned int old_tag, unsigned int new_tag, bool ready);
 	void select_and_issue(unsigned int num_lanes, lane* Execution_Lanes);
 	void flush();
 	void clear_branch_bit(unsigned int branch_ID);
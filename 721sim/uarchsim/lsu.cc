@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <cinttypes>
+#include <algorithm>
 
 #include "parameters.h"
 #include "histogram.h"
@@ -11,6 +12,54 @@
 #include "stats.h"
 
 
+void lsq_hash_t::init(lsq_entry* Q, unsigned int q_size) {
+	this->Q = Q;
+
+	// At least two buckets per entry.
+	n_buckets = 1;
+	while (n_buckets < (q_size << 1))
+		n_buckets <<= 1;
+	bucket = new unsigned int[n_buckets];
+
+	for (unsigned int i = 0; i < q_size; i++)
+		Q[i].hashed = false;
+	clear();
+}
+
+void lsq_hash_t::insert(unsigned int i) {
+	unsigned int b;
+
+	assert(Q[i].addr_avail && !Q[i].hashed);
+
+	b = hash(Q[i].addr);
+	Q[i].hashed = true;
+	Q[i].hash_prev = LSQ_HASH_NONE;
+	Q[i].hash_next = bucket[b];
+	if (bucket[b] != LSQ_HASH_NONE)
+		Q[bucket[b]].hash_prev = i;
+	bucket[b] = i;
+}
+
+void lsq_hash_t::remove(unsigned int i) {
+	if (!Q[i].hashed)
+		return;
+
+	if (Q[i].hash_prev != LSQ_HASH_NONE)
+		Q[Q[i].hash_prev].hash_next = Q[i].hash_next;
+	else
+		bucket[hash(Q[i].addr)] = Q[i].hash_next;
+	if (Q[i].hash_next != LSQ_HASH_NONE)
+		Q[Q[i].hash_next].hash_prev = Q[i].hash_prev;
+	Q[i].hashed = false;
+}
+
+// The caller clears the hashed flags of the entries.
+void lsq_hash_t::clear() {
+	for (unsigned int b = 0; b < n_buckets; b++)
+		bucket[b] = LSQ_HASH_NONE;
+}
+
+
 bool lsu::disambiguate(unsigned int lq_index,
                        unsigned int sq_index, bool sq_index_phase,
                        bool& forward,
@@ -18,6 +67,10 @@ bool lsu::disambiguate(unsigned int lq_index,
 	bool stall;		// return value
 	uint64_t max_size;
 	uint64_t mask;
+	unsigned int limit;	// prior stores are the stores with an SQ age below this
+	unsigned int age;
+	bool conflict;
+	unsigned int conflict_age;
 
 	// Check if the load is logically at the head of the SQ, i.e., no prior stores.
 	if ((sq_index == sq_head) && (sq_index_phase == sq_head_phase)) {
@@ -33,59 +86,110 @@ bool lsu::disambiguate(unsigned int lq_index,
 		// it must be true that the SQ has at least one store.
 		assert(sq_length > 0);
 
-		store_entry = sq_index;
-		do {
-			store_entry = MOD_S((store_entry + sq_size - 1), sq_size);
+		limit = sq_age(sq_index);
+		if (limit == 0)
+			limit = sq_size;	// the SQ is full: all stores are prior stores
+
+		// Find the youngest prior store with a known address that conflicts with the load.
+		// Only the stores that access the same block are visited.
+		conflict = false;
+		conflict_age = 0;
+		for (unsigned int i = SQ_hash.first(LQ[lq_index].addr); i != LSQ_HASH_NONE; i = SQ[i].hash_next) {
+			age = sq_age(i);
+			if ((age < limit) && (!conflict || (age > conflict_age))) {
+				max_size = MAX(SQ[i].size, LQ[lq_index].size);
+				mask = (~(max_size - 1));
+				if ((SQ[i].addr & mask) == (LQ[lq_index].addr & mask)) {
+					conflict = true;
+					conflict_age = age;
+					store_entry = i;
+				}
+			}
+		}
 
-			max_size = MAX(SQ[store_entry].size, LQ[lq_index].size);
-			mask = (~(max_size - 1));
+		// A prior store with an unknown address that is younger than the conflicting store is a possible conflict:
+		// stall (if prediction says to).
+		if (LQ[lq_index].mdp_stall) {
+			age = (conflict ? (conflict_age + 1) : 0);
+			stall = any_unknown(MOD_S((sq_head + age), sq_size), (limit - age));
+		}
+		else if (LQ[lq_index].mdp_wait) {
+			age = sq_age(LQ[lq_index].mdp_store);
+			stall = ((age < limit) && (!conflict || (age > conflict_age)) && !SQ[LQ[lq_index].mdp_store].addr_avail);
+		}
 
-			if (!SQ[store_entry].addr_avail) {
-				stall = LQ[lq_index].mdp_stall;  // stall (if prediction says to): possible conflict
+		if (!stall && conflict) {
+			// There is a conflict.
+			if (SQ[store_entry].size != LQ[lq_index].size) {
+				stall = true;    // stall: partial conflict scenarios are hard
 			}
-			else if ((SQ[store_entry].addr & mask) ==
-			         (LQ[lq_index].addr    & mask)) {
-				// There is a conflict.
-				if (SQ[store_entry].size != LQ[lq_index].size) {
-					stall = true;    // stall: partial conflict scenarios are hard
-				}
-				else if (!SQ[store_entry].value_avail) {
-					stall = true;    // stall: must wait for value to be available
-				}
-				else {
-					forward = true;    // forward: sizes match and value is available
-				}
+			else if (!SQ[store_entry].value_avail) {
+				stall = true;    // stall: must wait for value to be available
 			}
-		} while ((store_entry != sq_head) && !stall && !forward);
+			else {
+				forward = true;    // forward: sizes match and value is available
+			}
+		}
 	}
 
 	return(stall);
 }	// disambiguate()
 
+bool lsu::any_unknown(unsigned int first, unsigned int n) {
+	unsigned int end;	// exclusive
+	unsigned int w;
+	uint64_t mask;
+
+	// The range wraps around at most once: split it into two ranges that do not.
+	while (n > 0) {
+		end = (((first + n) < sq_size) ? (first + n) : sq_size);
+		n -= (end - first);
+
+		for (w = (first >> 6); w <= ((end - 1) >> 6); w++) {
+			mask = ~((uint64_t)0);
+			if (w == (first >> 6))
+				mask &= (~((uint64_t)0) << (first & 63));
+			if (w == ((end - 1) >> 6))
+				mask &= (~((uint64_t)0) >> (63 - ((end - 1) & 63)));
+			if (sq_unknown[w] & mask)
+				return(true);
+		}
+
+		first = 0;
+	}
+	return(false);
+}
+
 bool lsu::ld_violation(unsigned int sq_index,
                        unsigned int lq_index, bool lq_index_phase,
                        unsigned int& load_entry) {
    bool misp;
-   bool load_entry_phase;
    uint64_t max_size;
    uint64_t mask;
+   unsigned int start;   // loads after the store are the loads with an LQ age at or above this
+   unsigned int age;
+   unsigned int misp_age;
 
    misp = false;
-   load_entry = lq_index;
-   load_entry_phase = lq_index_phase;
-
-   // Search the LQ from the first load after the store (if it exists) to the tail.
-   while (!misp && !((load_entry == lq_tail) && (load_entry_phase == lq_tail_phase))) {
-      max_size = MAX(SQ[sq_index].size, LQ[load_entry].size);
-      mask = (~(max_size - 1));
-
-      if (LQ[load_entry].value_avail && ((SQ[sq_index].addr & mask) == (LQ[load_entry].addr & mask))) {
-         misp = true;
-      }
-      else {
-         load_entry = MOD_S((load_entry + 1), lq_size);
-         if (load_entry == 0)   // wrapped around, so toggle phase bit
-            load_entry_phase = !load_entry_phase;
+   misp_age = 0;
+
+   if ((lq_index == lq_tail) && (lq_index_phase == lq_tail_phase))
+      start = lq_length;   // no loads after the store
+   else
+      start = lq_age(lq_index);
+
+   // Find the oldest load after the store that already executed and conflicts with the store.
+   // Only the loads that access the same block are visited.
+   for (unsigned int i = LQ_hash.first(SQ[sq_index].addr); i != LSQ_HASH_NONE; i = LQ[i].hash_next) {
+      age = lq_age(i);
+      if ((age >= start) && (age < lq_length) && (!misp || (age < misp_age)) && LQ[i].value_avail) {
+         max_size = MAX(SQ[sq_index].size, LQ[i].size);
+         mask = (~(max_size - 1));
+         if ((SQ[sq_index].addr & mask) == (LQ[i].addr & mask)) {
+            misp = true;
+            misp_age = age;
+            load_entry = i;
+         }
       }
    }
 
@@ -96,6 +200,10 @@ void lsu::set_l2_cache(CacheClass* l2_dc){
 	DC->set_nextLevel(l2_dc);
 }
 
+void lsu::set_directory(directory_t* dir, unsigned int core){
+	DC->set_directory(dir, core);
+}
+
 lsu::lsu(unsigned int lq_size, unsigned int sq_size, unsigned int Tid, mmu_t* _mmu, pipeline_t* _proc):
       proc(_proc),
       mmu(_mmu)
@@ -111,9 +219,12 @@ lsu::lsu(unsigned int lq_size, unsigned int sq_size, unsigned int Tid, mmu_t* _m
           	            L1_DC_NUM_MHSRs,
           	            L1_DC_MISS_SRV_PORTS,
           	            L1_DC_MISS_SRV_LATENCY,
+          	            L1_DC_REPL,
                         _proc,
                         "l1_dc",
                         _proc->L2C);
+	DC->set_prefetcher(prefetcher_t::create(L1_DC_PREFETCH, L1_DC_LINE_SIZE, PREFETCH_DEGREE, PREFETCH_DISTANCE, PREFETCH_STRIDE_SIZE, PREFETCH_STREAMS));
+	DC->set_writeback_buffer(L1_DC_WBB_SIZE);
 
 	// LQ initialization.
 	this->lq_size = lq_size;
@@ -127,6 +238,7 @@ lsu::lsu(unsigned int lq_size, unsigned int sq_size, unsigned int Tid, mmu_t* _m
 	for (unsigned int i = 0; i < lq_size; i++) {
 		LQ[i].valid = false;
 	}
+	LQ_hash.init(LQ, lq_size);
 
 	// SQ initialization.
 	this->sq_size = sq_size;
@@ -140,6 +252,12 @@ lsu::lsu(unsigned int lq_size, unsigned int sq_size, unsigned int Tid, mmu_t* _m
 	for (unsigned int i = 0; i < sq_size; i++) {
 		SQ[i].valid = false;
   }
+	SQ_hash.init(SQ, sq_size);
+
+	sq_unknown_words = ((sq_size + 63) >> 6);
+	sq_unknown = new uint64_t[sq_unknown_words];
+	for (unsigned int i = 0; i < sq_unknown_words; i++)
+		sq_unknown[i] = 0;
 
 	// STATS
 	n_stall_disambig = 0;
@@ -172,7 +290,7 @@ void lsu::dispatch(bool load,
                    unsigned int pay_index,
                    unsigned int& lq_index, bool& lq_index_phase,
                    unsigned int& sq_index, bool& sq_index_phase,
-                   bool mdp_stall) {
+                   bool mdp_stall, bool mdp_wait, unsigned int mdp_store) {
 	// Assign indices to the load or store.
 	lq_index = lq_tail;
 	lq_index_phase = lq_tail_phase;
@@ -184,6 +302,7 @@ void lsu::dispatch(bool load,
 		assert(lq_length < lq_size);
 
 		// Allocate entry in the LQ.
+		assert(!LQ[lq_tail].hashed);
 		LQ[lq_tail].valid = true;
 		LQ[lq_tail].is_signed = is_signed;
 		//LQ[lq_tail].left = left;
@@ -199,6 +318,8 @@ void lsu::dispatch(bool load,
 		LQ[lq_tail].sq_index_phase = sq_index_phase;
 
                 LQ[lq_tail].mdp_stall = mdp_stall;
+                LQ[lq_tail].mdp_wait = mdp_wait;
+                LQ[lq_tail].mdp_store = mdp_store;
 
 		// STATS
 		LQ[lq_tail].stat_load_stall_disambig = false;
@@ -225,6 +346,7 @@ void lsu::dispatch(bool load,
 		assert(sq_length < sq_size);
 
 		// Allocate entry in the SQ.
+		assert(!SQ[sq_tail].hashed);
 		SQ[sq_tail].valid = true;
 		SQ[sq_tail].is_signed = is_signed;
 		//SQ[sq_tail].left = left;
@@ -233,6 +355,7 @@ void lsu::dispatch(bool load,
 		SQ[sq_tail].amo = amo;
 		SQ[sq_tail].addr_avail = false;
 		SQ[sq_tail].value_avail = false;
+		set_unknown(sq_tail);
 		SQ[sq_tail].missed = false;
 
 		SQ[sq_tail].pay_index = pay_index;
@@ -288,6 +411,8 @@ void lsu::store_addr(cycle_t cycle,
 
    SQ[sq_index].addr_avail = true;
    SQ[sq_index].addr = addr;
+   clear_unknown(sq_index);
+   SQ_hash.insert(sq_index);
 
    // Detect and mark load violations.
    if (SPEC_DISAMBIG) {
@@ -296,12 +421,15 @@ void lsu::store_addr(cycle_t cycle,
       if (ld_violation(sq_index, lq_index, lq_index_phase, load_entry)) {
          al_index = proc->PAY.buf[LQ[load_entry].pay_index].AL_index;
          proc->set_load_violation(al_index);
+
+         // Record the store for training the memory dependence predictor at retirement.
+         proc->PAY.buf[LQ[load_entry].pay_index].viol_store_pc = proc->PAY.buf[SQ[sq_index].pay_index].pc;
       }
    }
 
    if (!PERFECT_DCACHE) {
       bool hit;
-      SQ[sq_index].miss_resolve_cycle = DC->Access(Tid, cycle, addr, true, &hit);
+      SQ[sq_index].miss_resolve_cycle = DC->Access(Tid, cycle, addr, true, &hit, false, true, proc->PAY.buf[SQ[sq_index].pay_index].pc);
       SQ[sq_index].missed = !hit;
 
       if (!hit) inc_counter(spec_store_miss_count);
@@ -332,8 +460,10 @@ bool lsu::load_addr(cycle_t cycle,
 	assert(LQ[lq_index].valid);
 
 	// Set up information for executing the load.
+	LQ_hash.remove(lq_index);	// in case the load executes again: it is keyed by its old address
 	LQ[lq_index].addr_avail = true;
 	LQ[lq_index].addr = addr;
+	LQ_hash.insert(lq_index);
 	//LQ[lq_index].back_data = back_data;
 
   #ifdef RISCV_MICRO_DEBUG
@@ -343,8 +473,9 @@ bool lsu::load_addr(cycle_t cycle,
 
 	if (!PERFECT_DCACHE) {
 		bool hit;
-		LQ[lq_index].miss_resolve_cycle = DC->Access(Tid, cycle, addr, false, &hit);
+		LQ[lq_index].miss_resolve_cycle = DC->Access(Tid, cycle, addr, false, &hit, false, true, proc->PAY.buf[LQ[lq_index].pay_index].pc);
 		LQ[lq_index].missed = !hit;
+		LQ[lq_index].access_cycle = cycle;
     if(!hit){
       inc_counter(spec_load_miss_count);
     }
@@ -373,7 +504,7 @@ bool lsu::load_unstall(cycle_t cycle, unsigned int& pay_index, reg_t& value) {
          if (!PERFECT_DCACHE && (LQ[scan].miss_resolve_cycle == -1)) {
             bool hit;
             assert(LQ[scan].addr_avail);
-            LQ[scan].miss_resolve_cycle = DC->Access(Tid, cycle, LQ[scan].addr, false, &hit);
+            LQ[scan].miss_resolve_cycle = DC->Access(Tid, cycle, LQ[scan].addr, false, &hit, false, true, proc->PAY.buf[LQ[scan].pay_index].pc);
             LQ[scan].missed = !hit;
          }
 
@@ -555,10 +686,17 @@ void lsu::checkpoint(unsigned int& chkpt_lq_tail, bool& chkpt_lq_tail_phase,
 
 void lsu::restore(unsigned int recover_lq_tail, bool recover_lq_tail_phase,
                   unsigned int recover_sq_tail, bool recover_sq_tail_phase) {
+	unsigned int squashed;
+
+	// Entries are valid exactly between head and tail, so only the squashed entries,
+	// between the recovered tail and the current tail, need their valid bits cleared.
+
 	/////////////////////////////
 	// Restore LQ.
 	/////////////////////////////
 
+	squashed = lq_length;
+
 	// Restore tail state.
 	lq_tail = recover_lq_tail;
 	lq_tail_phase = recover_lq_tail_phase;
@@ -569,22 +707,20 @@ void lsu::restore(unsigned int recover_lq_tail, bool recover_lq_tail_phase,
 		lq_length = lq_size;
 	}
 
-	// Restore valid bits in two steps:
-	// (1) Clear all valid bits.
-	// (2) Set valid bits between head and tail.
-
-	for (unsigned int i = 0; i < lq_size; i++) {
-		LQ[i].valid = false;
-	}
-
-	for (unsigned int i = 0, j = lq_head; i < lq_length; i++, j = MOD_S((j+1), lq_size)) {
-		LQ[j].valid = true;
+	// Clear the valid bits of the squashed entries.
+	assert(squashed >= lq_length);
+	squashed -= lq_length;
+	for (unsigned int i = 0, j = lq_tail; i < squashed; i++, j = MOD_S((j+1), lq_size)) {
+		LQ[j].valid = false;
+		LQ_hash.remove(j);
 	}
 
 	/////////////////////////////
 	// Restore SQ.
 	/////////////////////////////
 
+	squashed = sq_length;
+
 	// Restore tail state.
 	sq_tail = recover_sq_tail;
 	sq_tail_phase = recover_sq_tail_phase;
@@ -595,16 +731,13 @@ void lsu::restore(unsigned int recover_lq_tail, bool recover_lq_tail_phase,
 		sq_length = sq_size;
 	}
 
-	// Restore valid bits in two steps:
-	// (1) Clear all valid bits.
-	// (2) Set valid bits between head and tail.
-
-	for (unsigned int i = 0; i < sq_size; i++) {
-		SQ[i].valid = false;
-	}
-
-	for (unsigned int i = 0, j = sq_head; i < sq_length; i++, j = MOD_S((j+1), sq_size)) {
-		SQ[j].valid = true;
+	// Clear the valid bits of the squashed entries.
+	assert(squashed >= sq_length);
+	squashed -= sq_length;
+	for (unsigned int i = 0, j = sq_tail; i < squashed; i++, j = MOD_S((j+1), sq_size)) {
+		SQ[j].valid = false;
+		SQ_hash.remove(j);
+		clear_unknown(j);
 	}
 }
 
@@ -637,10 +770,17 @@ bool lsu::commit(bool load, bool atomic_op, bool& atomic_success, bool deactivat
         if (LQ[lq_head].missed) {
            inc_counter(load_miss_count);
         }
+        if (LATENCY_HIST && !PERFECT_DCACHE && LQ[lq_head].addr_avail && !LQ[lq_head].stat_forward &&
+            (LQ[lq_head].miss_resolve_cycle != -1)) {
+           cycle_t latency = (LQ[lq_head].miss_resolve_cycle - LQ[lq_head].access_cycle);
+           load_latency.Increment(latency);
+           load_latency_pc[proc->PAY.buf[LQ[lq_head].pay_index].pc].Increment(latency);
+        }
       }
 
         // Invalidate the entry.
         LQ[lq_head].valid = false;
+        LQ_hash.remove(lq_head);
 
         // Advance the head pointer and decrement the queue length.
         lq_head = MOD_S((lq_head + 1), lq_size);
@@ -702,6 +842,8 @@ bool lsu::commit(bool load, bool atomic_op, bool& atomic_success, bool deactivat
 
       // Invalidate the entry.
       SQ[sq_head].valid = false;
+      SQ_hash.remove(sq_head);
+      clear_unknown(sq_head);
   
       // Advance the head pointer and decrement the queue length.
       sq_head = MOD_S((sq_head + 1), sq_size);
@@ -727,7 +869,9 @@ void lsu::flush() {
 
 	for (unsigned int i = 0; i < lq_size; i++) {
 		LQ[i].valid = false;
+		LQ[i].hashed = false;
 	}
+	LQ_hash.clear();
 
 	// Flush SQ.
 	sq_head = 0;
@@ -738,7 +882,12 @@ void lsu::flush() {
 
 	for (unsigned int i = 0; i < sq_size; i++) {
 		SQ[i].valid = false;
+		SQ[i].hashed = false;
 	}
+	SQ_hash.clear();
+
+	for (unsigned int i = 0; i < sq_unknown_words; i++)
+		sq_unknown[i] = 0;
 }
 
 
@@ -780,6 +929,32 @@ void lsu::dump_stats(FILE* fp) {
 	fprintf(fp, "  miss stall       = %d (%.2f%%)\n",
 	        n_stall_miss_s,
 	        100.0*(double)n_stall_miss_s/(double)n_store);
+
+	if (LATENCY_HIST)
+		dump_load_latency(fp);
+}
+
+void lsu::dump_load_latency(FILE* fp) {
+	std::vector<std::pair<uint64_t, reg_t> > pcs;
+
+	fprintf(fp, "LOAD LATENCY (retired, not forwarded: D$ access to data, in cycles)\n");
+	load_latency.Print(fp);
+
+	// The top LATENCY_HIST_PCS load PCs by total latency.
+	for (std::unordered_map<reg_t, LogHistogramClass>::iterator it = load_latency_pc.begin(); it != load_latency_pc.end(); it++)
+		pcs.push_back(std::make_pair(it->second.Sum(), it->first));
+	std::sort(pcs.begin(), pcs.end(), std::greater<std::pair<uint64_t, reg_t> >());
+	if (pcs.size() > LATENCY_HIST_PCS)
+		pcs.resize(LATENCY_HIST_PCS);
+
+	fprintf(fp, "LOAD LATENCY: top %lu of %lu load PCs by total latency\n", pcs.size(), load_latency_pc.size());
+	for (unsigned int i = 0; i < pcs.size(); i++) {
+		fprintf(fp, "  pc %" PRIx64 ": total = %" PRIu64 " (%.2f%%), ", pcs[i].second, pcs[i].first,
+		        100.0*(double)pcs[i].first/(double)load_latency.Sum());
+		load_latency_pc[pcs[i].second].PrintSummary(fp);
+	}
+
+	DC->dump_latency(fp);
 }
 
 
@@ -7,6 +7,8 @@
 // 3. Committed memory state.
 ///////////////////////////////////////////////////////////////
 //#include "CcacheClass.h"
+#include <unordered_map>
+#include "histogram.h"
 
 // Single entry in the load-store queue.
 typedef struct {
@@ -27,6 +29,7 @@ typedef struct {
 
   bool missed;        // The memory block referenced by load or store is not in cache.
   cycle_t miss_resolve_cycle; // Cycle when referenced memory block will be in cache.
+  cycle_t access_cycle;       // Cycle of the load's D$ access (its latency is miss_resolve_cycle - access_cycle).
 
   // These three fields are needed for replaying stalled loads.
   unsigned int pay_index; // Index into PAY buffer.
@@ -38,6 +41,16 @@ typedef struct {
   // and a prediction from the memory dependence predictor (MDP).
   bool mdp_stall;
 
+  // With the store-set memory dependence predictor (see store_set.h), a "speculate type" load
+  // may instead be predicted to depend on one prior store: it stalls only for that store's address.
+  bool mdp_wait;
+  unsigned int mdp_store;   // SQ index of the predicted store.
+
+  // Address-hashed index (see lsq_hash_t).
+  bool hashed;              // The entry is in its queue's address-hashed index.
+  unsigned int hash_prev;
+  unsigned int hash_next;
+
   // STATS
   bool stat_load_stall_disambig;  // Load stalled due to unknown store address and/or value.
   bool stat_load_stall_miss;  // Load stalled due to a cache miss.
@@ -46,11 +59,43 @@ typedef struct {
 } lsq_entry;
 
 
+
+///////////////////////////////////////////////////////////////
+// Address-hashed index of the LQ or SQ entries whose addresses
+// are known. Loads and stores can only conflict if they access
+// the same 8-byte aligned block (sizes are 1, 2, 4, or 8 bytes),
+// so the index is keyed by block address. The entries of a bucket
+// are chained through their hash_prev/hash_next fields.
+// Disambiguation and load violation checks only visit the entries
+// in the bucket of the address being checked.
+///////////////////////////////////////////////////////////////
+#define LSQ_HASH_NONE 0xffffffff
+
+class lsq_hash_t {
+private:
+  lsq_entry* Q;
+  unsigned int n_buckets;   // a power of 2
+  unsigned int* bucket;     // first entry of each bucket
+
+  inline unsigned int hash(reg_t addr) { return((unsigned int)(addr >> 3) & (n_buckets - 1)); }
+
+public:
+  void init(lsq_entry* Q, unsigned int q_size);
+  void insert(unsigned int i);
+  void remove(unsigned int i);
+  void clear();
+
+  // First entry that may conflict with "addr". Iterate with Q[i].hash_next until LSQ_HASH_NONE.
+  inline unsigned int first(reg_t addr) { return(bucket[hash(addr)]); }
+};
+
+
 //Forward declaring classes 
 class mmu_t;
 class pipeline_t;
 class CacheClass;
 class stats_t;
+class directory_t;
 
 class lsu {
 
@@ -85,6 +130,30 @@ private:
   bool sq_head_phase;
   bool sq_tail_phase;
 
+  //////////////////////////
+  // Address-hashed indices
+  //////////////////////////
+  lsq_hash_t LQ_hash;   // Loads with known addresses.
+  lsq_hash_t SQ_hash;   // Stores with known addresses.
+
+  // Position of an entry relative to the head of its queue, i.e., 0 for the oldest.
+  inline unsigned int lq_age(unsigned int i) { return((i + lq_size - lq_head) % lq_size); }
+  inline unsigned int sq_age(unsigned int i) { return((i + sq_size - sq_head) % sq_size); }
+
+  //////////////////////////
+  // Unknown store addresses
+  //////////////////////////
+  // Bit i is set if SQ entry i holds a store whose address is not yet known.
+  // Searching a range of stores for one with an unknown address tests 64 entries at a time.
+  uint64_t* sq_unknown;
+  unsigned int sq_unknown_words;
+
+  inline void set_unknown(unsigned int i)   { sq_unknown[i >> 6] |= (((uint64_t)1) << (i & 63)); }
+  inline void clear_unknown(unsigned int i) { sq_unknown[i >> 6] &= ~(((uint64_t)1) << (i & 63)); }
+
+  // Returns true if any of the "n" SQ entries starting at "first" (wrapping around) has an unknown address.
+  bool any_unknown(unsigned int first, unsigned int n);
+
   //////////////////////////
   // Data Cache
   //////////////////////////
@@ -112,6 +181,12 @@ private:
   unsigned int n_load;
   unsigned int n_store;
 
+  // Load latency (LATENCY_HIST): D$ access to data, of retired loads that
+  // did not get their value from a store. Over all loads, and per load PC.
+  LogHistogramClass load_latency;
+  std::unordered_map<reg_t, LogHistogramClass> load_latency_pc;
+  void dump_load_latency(FILE* fp);
+
   //////////////////////////
   //  Private functions
   //////////////////////////
@@ -151,6 +226,7 @@ public:
   ~lsu();
 
   void set_l2_cache(CacheClass* l2_dc);
+  void set_directory(directory_t* dir, unsigned int core);
 
   bool stall(unsigned int bundle_load, unsigned int bundle_store);
 
@@ -158,7 +234,7 @@ public:
                 unsigned int pay_index,
                 unsigned int& lq_index, bool& lq_index_phase,
                 unsigned int& sq_index, bool& sq_index_phase,
-		bool mdp_stall);
+		bool mdp_stall, bool mdp_wait = false, unsigned int mdp_store = 0);
 
   void store_addr(cycle_t cycle,
                   reg_t addr,
@@ -179,6 +255,9 @@ public:
   void restore(unsigned int recover_lq_tail, bool recover_lq_tail_phase,
                unsigned int recover_sq_tail, bool recover_sq_tail_phase);
 
+  // The in-flight stores: "length" SQ entries starting at "head", in an SQ of "size" entries.
+  void get_sq(unsigned int& head, unsigned int& length, unsigned int& size) { head = sq_head; length = sq_length; size = sq_size; }
+
   bool commit(bool load, bool atomic_op, bool& atomic_success, bool deactivted);
 
   void flush();
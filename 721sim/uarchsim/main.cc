@@ -15,6 +15,7 @@
 #include <algorithm>
 #include "debug.h"
 #include "parameters.h"
+#include "branch_mask.h"
 #include <signal.h>
 
 static void help()
@@ -31,7 +32,7 @@ static void help()
   fprintf(stderr, "  -p<n>              Simulate <n> processors\n");
   fprintf(stderr, "  -s<n>              Fast skip <n> instructions before microarchitectural simulation\n");
   fprintf(stderr, "  --perf=<pbp>,<pdc>,<pic>,<ptc>\tEach of pbp (perf. branch pred.), pdc (perf. D$), pic (perf. I$), and ptc (perf. T$), are 0 or 1\n");
-  fprintf(stderr, "  --cp=<n>           <n> branch checkpoints for mispredict recovery\n");
+  fprintf(stderr, "  --cp=<n>           <n> branch checkpoints for mispredict recovery (at most BRANCH_MASK_BITS = %d)\n", BRANCH_MASK_BITS);
 
   fprintf(stderr, "  --bq=<n>           Branch queue (all branches b/w fetch and retire) has <n> entries\n");
   fprintf(stderr, "  --btbentries=<n>   BTB has a total of <n> entries\n");
@@ -52,6 +53,7 @@ static void help()
   fprintf(stderr, "  -b                 Enable ideal age-based scheduling (override position-based scheduling)\n");
   fprintf(stderr, "  --lsq=<n>          Load/Store Queue has <n> entries\n");
   fprintf(stderr, "  --disambig=<oracle>,<spec>,<mdp>\tEach of <oracle> (oracle memory disambig.), <spec> (speculative memory disambig.), and <mdp> (mem. dep. predictor), are 0 or 1\n");
+  fprintf(stderr, "  --ssets=<ssit>,<lfst>,<clear>\tStore-set mem. dep. predictor: 2^<ssit> SSIT entries, 2^<lfst> LFST entries, cleared every <clear> cycles\n");
   fprintf(stderr, "  --fw=<n>           <n> wide fetch\n");
   fprintf(stderr, "  --dw=<n>           <n> wide dispatch\n");
   fprintf(stderr, "  --iw=<n>           <n> wide issue / <n> execution lanes\n");
@@ -60,9 +62,27 @@ static void help()
   fprintf(stderr, "  --lane=<B>:<L>:<S>:<C>:<LFP>:<FP>:<MTF>\tEach of <X> is a bit vector indicating which lanes support that instruction type.\n");
   fprintf(stderr, "  --lat=<B>:<L>:<S>:<C>:<LFP>:<FP>:<MTF>\tEach of <X> is an unsigned integer indicating the latency of that instruction type.\n");
   fprintf(stderr, "  --nol2             Do not use an L2 cache\n");
+  fprintf(stderr, "  --dram=<ch>,<banks>,<row>,<rq>,<wq>\tDRAM behind the L2$ (not with --nol2): <ch> channels, <banks> banks per channel, 2^<row> B rows, <rq>/<wq> read/write queue entries per channel\n");
+  fprintf(stderr, "  --dramt=<ctrl>,<cl>,<rcd>,<rp>,<burst>\tDRAM controller latency and tCL, tRCD, tRP, tBURST, in cycles\n");
+  fprintf(stderr, "  --wbb=<l1d>,<l2>   Write-back buffer entries of the L1 D$ and L2$ (0: a fill waits for its dirty victim's writeback)\n");
+  fprintf(stderr, "  --lathist=<n>      Dump load latency histograms, over all loads and for the top <n> load PCs by total latency, and the read latency histograms of the L1 D$ and L2$\n");
+  fprintf(stderr, "  --sharedl2=<dir>,<c2c>,<inv>\tOne L2$ shared by all cores (-p), with a MESI directory between the L1 D$s: directory, cache-to-cache and invalidation latencies, in cycles\n");
+  fprintf(stderr, "  --fdip=<depth>     Fetch-directed instruction prefetching: prefetch the I$ lines of the next <depth> predicted fetch bundles\n");
+  fprintf(stderr, "  --noicbuf          Do not use the fetch line buffer (look up the I$ and fetch from the MMU on every fetch)\n");
+  fprintf(stderr, "  --pf=<l1d>,<l2>,<degree>,<distance>\tData prefetcher of the L1 D$ and L2$ (each is none, nextline, stride or stream), prefetches per access, and stream distance in lines\n");
+  fprintf(stderr, "  --repl=<l1d>,<l1i>,<l2>,<btb>\tReplacement policy of the L1 D$, L1 I$, L2$ and BTB: each is lru, plru, srrip, brrip or drrip\n");
   fprintf(stderr, "  --ic=<S>:<W>:<B>   Instantiate a cache model with S sets,\n");
   fprintf(stderr, "  --dc=<S>:<W>:<B>   W ways, and B-byte blocks (with S and\n");
   fprintf(stderr, "  --l2=<S>:<W>:<B>   B both powers of 2).\n");
+  fprintf(stderr, "  --dhp=<file>       Enable Dynamic Hammock Predication using the hammock table in <file>\n");
+  fprintf(stderr, "  --ppred=<pc>,<hist>,<conf>\tEnable the DHP predicate predictor: <pc> bits of PC, <hist> bits of predicate history, confidence threshold <conf> (0-15) (requires --dhp)\n");
+  fprintf(stderr, "  --mp=<depth>       Enable dynamic multipath execution of low-confidence branches, fetching up to <depth> instructions down each path\n");
+  fprintf(stderr, "  --ci=<size>,<window>\tEnable control-independent squash reuse: 2^<size> reconvergence predictor entries, reuse window of <window> instructions\n");
+  fprintf(stderr, "  --cisel            Recover mispredicted if-then branches selectively: squash only the skipped body, keep the instructions after it (requires --ci)\n");
+  fprintf(stderr, "  --elim=<move>,<idiom>\tEach of <move> (move elimination) and <idiom> (constant-idiom elimination) is 0 or 1\n");
+  fprintf(stderr, "  --vp=<size>,<conf> Enable stride value prediction of loads and integer ALU instructions: 2^<size> entries, confidence threshold <conf> (0-15)\n");
+  fprintf(stderr, "  --erel             Release physical registers early: once redefined and read by all consumers (not with move elimination or --ppred)\n");
+  fprintf(stderr, "  --fusion=<mask>    Fuse adjacent instruction pairs in decode: 1 (lui/auipc + addi/jalr), 2 (slli + srli/srai), 4 (slt + beq/bne), or a sum\n");
   fprintf(stderr, "  --extension=<name> Specify RoCC Extension\n");
   fprintf(stderr, "  --extlib=<name>    Shared library to load\n");
   exit(1);
@@ -128,6 +148,14 @@ static void set_lane_matrix(const char* config)
   FU_LANE_MATRIX[6] = strtol(pEnd   ,NULL ,16)   /*    MTF: 0000 0010 */;
 }
 
+static void set_checkpoints(const char* config) {
+   if ((sscanf(config, "%u", &NUM_CHECKPOINTS) != 1) || (NUM_CHECKPOINTS == 0) || (NUM_CHECKPOINTS > BRANCH_MASK_BITS)) {
+      fprintf(stderr, "Incorrect usage of --cp=<n>\n");
+      fprintf(stderr, "...where n (number of branch checkpoints) is 1 to BRANCH_MASK_BITS = %d.\n", BRANCH_MASK_BITS);
+      exit(-1);
+   }
+}
+
 static void set_lane_latencies(const char* config) {
    if (sscanf(config, "%u:%u:%u:%u:%u:%u:%u", &(FU_LAT[0]), &(FU_LAT[1]), &(FU_LAT[2]), &(FU_LAT[3]), &(FU_LAT[4]), &(FU_LAT[5]), &(FU_LAT[6])) != 7) {
       fprintf(stderr, "Incorrect usage of --lat=<B>:<L>:<S>:<C>:<LFP>:<FP>:<MTF>\n");
@@ -164,6 +192,163 @@ static void set_disambig_flags(const char* config) {
    }
 }
 
+static void set_store_sets(const char* config) {
+   if ((sscanf(config, "%u,%u,%lu", &STORE_SET_SSIT_SIZE, &STORE_SET_LFST_SIZE, &STORE_SET_CLEAR_INTERVAL) != 3) || (STORE_SET_CLEAR_INTERVAL == 0)) {
+      fprintf(stderr, "Incorrect usage of --ssets=<ssit>,<lfst>,<clear>\n");
+      fprintf(stderr, "...where ssit and lfst (log2 of the number of SSIT and LFST entries) and clear (cycles between clearings, > 0) are unsigned integers.\n");
+      exit(-1);
+   }
+}
+
+static void set_predicate_pred(const char* config) {
+   if (sscanf(config, "%u,%u,%u", &PREDICATE_PRED_PC_LENGTH, &PREDICATE_PRED_HIST_LENGTH, &PREDICATE_PRED_CONF_THRESHOLD) != 3) {
+      fprintf(stderr, "Incorrect usage of --ppred=<pc>,<hist>,<conf>\n");
+      fprintf(stderr, "...where pc (bits of PC), hist (bits of predicate history), and conf (confidence threshold, 0-15), are unsigned integers.\n");
+      exit(-1);
+   }
+   else {
+      PREDICATE_PRED = true;
+   }
+}
+
+static void set_multipath(const char* config) {
+   if ((sscanf(config, "%u", &MULTIPATH_DEPTH) != 1) || (MULTIPATH_DEPTH == 0)) {
+      fprintf(stderr, "Incorrect usage of --mp=<depth>\n");
+      fprintf(stderr, "...where depth (maximum number of instructions fetched down each path) is a positive integer.\n");
+      exit(-1);
+   }
+   else {
+      MULTIPATH = true;
+   }
+}
+
+static void set_reconv_reuse(const char* config) {
+   if ((sscanf(config, "%u,%u", &RECONV_PRED_SIZE, &RECONV_WINDOW) != 2) || (RECONV_WINDOW == 0)) {
+      fprintf(stderr, "Incorrect usage of --ci=<size>,<window>\n");
+      fprintf(stderr, "...where size (log2 of the number of reconvergence predictor entries) and window (reuse window, in instructions) are unsigned integers, window > 0.\n");
+      exit(-1);
+   }
+   else {
+      RECONV_REUSE = true;
+   }
+}
+
+static void set_elim(const char* config) {
+   uint64_t move, idiom;
+   if (sscanf(config, "%lu,%lu", &move, &idiom) != 2) {
+      fprintf(stderr, "Incorrect usage of --elim=<move>,<idiom>\n");
+      fprintf(stderr, "...where move (move elimination) and idiom (constant-idiom elimination) are each 0 or 1\n");
+      exit(-1);
+   }
+   else {
+      MOVE_ELIM = (move ? true : false);
+      IDIOM_ELIM = (idiom ? true : false);
+   }
+}
+
+static void set_value_pred(const char* config) {
+   if ((sscanf(config, "%u,%u", &VALUE_PRED_SIZE, &VALUE_PRED_CONF_THRESHOLD) != 2) || (VALUE_PRED_CONF_THRESHOLD > 15)) {
+      fprintf(stderr, "Incorrect usage of --vp=<size>,<conf>\n");
+      fprintf(stderr, "...where size (log2 of the number of value predictor entries) and conf (confidence threshold, 0-15) are unsigned integers.\n");
+      exit(-1);
+   }
+   else {
+      VALUE_PRED = true;
+   }
+}
+
+static void set_fusion(const char* config) {
+   if ((sscanf(config, "%u", &FUSION) != 1) || (FUSION > (FUSE_IMM|FUSE_SHIFT|FUSE_CMP_BR))) {
+      fprintf(stderr, "Incorrect usage of --fusion=<mask>\n");
+      fprintf(stderr, "...where mask is the sum of the pair kinds to fuse: 1 (lui/auipc + addi/jalr), 2 (slli + srli/srai), 4 (slt + beq/bne).\n");
+      exit(-1);
+   }
+}
+
+static void set_repl(const char* config) {
+   repl_policy_e* policy[4] = {&L1_DC_REPL, &L1_IC_REPL, &L2_REPL, &BTB_REPL};
+   std::string s(config);
+   size_t pos = 0;
+   for (unsigned int i = 0; i < 4; i++) {
+      size_t end = s.find(',', pos);
+      if (((i == 3) != (end == std::string::npos)) || !repl_policy_t::parse(s.substr(pos, end - pos).c_str(), *policy[i])) {
+         fprintf(stderr, "Incorrect usage of --repl=<l1d>,<l1i>,<l2>,<btb>\n");
+         fprintf(stderr, "...where each of l1d, l1i, l2 and btb is one of: lru, plru, srrip, brrip, drrip.\n");
+         exit(-1);
+      }
+      pos = (end + 1);
+   }
+}
+
+static void set_prefetch(const char* config) {
+   char l1d[16], l2[16];
+   if ((sscanf(config, "%15[^,],%15[^,],%u,%u", l1d, l2, &PREFETCH_DEGREE, &PREFETCH_DISTANCE) != 4) ||
+       !prefetcher_t::parse(l1d, L1_DC_PREFETCH) || !prefetcher_t::parse(l2, L2_PREFETCH) ||
+       (PREFETCH_DEGREE == 0) || (PREFETCH_DEGREE > PF_MAX_DEGREE) || (PREFETCH_DISTANCE == 0)) {
+      fprintf(stderr, "Incorrect usage of --pf=<l1d>,<l2>,<degree>,<distance>\n");
+      fprintf(stderr, "...where l1d and l2 are each one of: none, nextline, stride, stream; degree is 1 to %d; and distance is > 0.\n", PF_MAX_DEGREE);
+      exit(-1);
+   }
+}
+
+static void set_fdip(const char* config) {
+   if ((sscanf(config, "%u", &L1_IC_FDIP_DEPTH) != 1) || (L1_IC_FDIP_DEPTH == 0)) {
+      fprintf(stderr, "Incorrect usage of --fdip=<depth>\n");
+      fprintf(stderr, "...where depth (number of predicted fetch bundles to prefetch ahead) is a positive integer.\n");
+      exit(-1);
+   }
+}
+
+static void set_dram(const char* config) {
+   if ((sscanf(config, "%u,%u,%u,%u,%u", &DRAM_CHANNELS, &DRAM_BANKS, &DRAM_ROW_SIZE, &DRAM_RQ_SIZE, &DRAM_WQ_SIZE) != 5) ||
+       (DRAM_CHANNELS == 0) || (DRAM_BANKS == 0) || (DRAM_ROW_SIZE < 6) || (DRAM_RQ_SIZE == 0) || (DRAM_WQ_SIZE == 0)) {
+      fprintf(stderr, "Incorrect usage of --dram=<ch>,<banks>,<row>,<rq>,<wq>\n");
+      fprintf(stderr, "...where ch, banks, rq and wq are positive integers and row (log2 of the row size in bytes) is at least the L2 line size.\n");
+      exit(-1);
+   }
+   else {
+      DRAM_PRESENT = true;
+   }
+}
+
+static void set_dram_timing(const char* config) {
+   if (sscanf(config, "%u,%u,%u,%u,%u", &DRAM_CTRL_LATENCY, &DRAM_tCL, &DRAM_tRCD, &DRAM_tRP, &DRAM_tBURST) != 5) {
+      fprintf(stderr, "Incorrect usage of --dramt=<ctrl>,<cl>,<rcd>,<rp>,<burst>\n");
+      fprintf(stderr, "...where each is an unsigned integer number of cycles.\n");
+      exit(-1);
+   }
+}
+
+static void set_wbb(const char* config) {
+   if (sscanf(config, "%u,%u", &L1_DC_WBB_SIZE, &L2_WBB_SIZE) != 2) {
+      fprintf(stderr, "Incorrect usage of --wbb=<l1d>,<l2>\n");
+      fprintf(stderr, "...where l1d and l2 (write-back buffer entries of the L1 D$ and L2$) are unsigned integers.\n");
+      exit(-1);
+   }
+}
+
+static void set_shared_l2(const char* config) {
+   if (sscanf(config, "%u,%u,%u", &COHERENCE_DIR_LATENCY, &COHERENCE_C2C_LATENCY, &COHERENCE_INV_LATENCY) != 3) {
+      fprintf(stderr, "Incorrect usage of --sharedl2=<dir>,<c2c>,<inv>\n");
+      fprintf(stderr, "...where dir, c2c and inv (directory, cache-to-cache and invalidation latencies) are unsigned integer numbers of cycles.\n");
+      exit(-1);
+   }
+   else {
+      L2_SHARED = true;
+   }
+}
+
+static void set_latency_hist(const char* config) {
+   if (sscanf(config, "%u", &LATENCY_HIST_PCS) != 1) {
+      fprintf(stderr, "Incorrect usage of --lathist=<n>\n");
+      fprintf(stderr, "...where n (number of load PCs to report) is an unsigned integer.\n");
+      exit(-1);
+   }
+   else {
+      LATENCY_HIST = true;
+   }
+}
+
 /* exit when this becomes non-zero */
 //int sim_exit_now = FALSE;
 // Should be global variables for access from all DPI functions
@@ -226,7 +411,7 @@ int main(int argc, char** argv)
     }
   });
   parser.option(0, "perf", 1, [&](const char* s){set_perfect_flags(s);});
-  parser.option(0, "cp"  , 1, [&](const char* s){NUM_CHECKPOINTS = atoi(s);});
+  parser.option(0, "cp"  , 1, [&](const char* s){set_checkpoints(s);});
 
   parser.option(0, "bq", 1, [&](const char* s){BQ_SIZE = atoi(s);});
   parser.option(0, "btbentries", 1, [&](const char* s){BTB_ENTRIES = atoi(s);});
@@ -247,6 +432,7 @@ int main(int argc, char** argv)
   parser.option('b', 0, 0, [&](const char* s){IDEAL_AGE_BASED = true;});
   parser.option(0, "lsq" , 1, [&](const char* s){LQ_SIZE = atoi(s);SQ_SIZE = atoi(s);});
   parser.option(0, "disambig", 1, [&](const char* s){set_disambig_flags(s);});
+  parser.option(0, "ssets", 1, [&](const char* s){set_store_sets(s);});
   parser.option(0, "fw"  , 1, [&](const char* s){FETCH_WIDTH = atoi(s);});
   parser.option(0, "dw"  , 1, [&](const char* s){DISPATCH_WIDTH = atoi(s);});
   parser.option(0, "iw"  , 1, [&](const char* s){ISSUE_WIDTH = atoi(s);});
@@ -255,8 +441,25 @@ int main(int argc, char** argv)
   parser.option(0, "lane" ,1, [&](const char *s){set_lane_matrix(s);});
   parser.option(0, "lat"  ,1, [&](const char *s){set_lane_latencies(s);});
   parser.option(0, "nol2", 1, [&](const char* s){L2_PRESENT = false;});
+  parser.option(0, "repl", 1, [&](const char* s){set_repl(s);});
+  parser.option(0, "pf"  , 1, [&](const char* s){set_prefetch(s);});
+  parser.option(0, "fdip", 1, [&](const char* s){set_fdip(s);});
+  parser.option(0, "noicbuf", 0, [&](const char* s){L1_IC_LINE_BUFFER = false;});
+  parser.option(0, "dram", 1, [&](const char* s){set_dram(s);});
+  parser.option(0, "dramt", 1, [&](const char* s){set_dram_timing(s);});
+  parser.option(0, "wbb" , 1, [&](const char* s){set_wbb(s);});
+  parser.option(0, "sharedl2", 1, [&](const char* s){set_shared_l2(s);});
+  parser.option(0, "lathist", 1, [&](const char* s){set_latency_hist(s);});
   //-------------------------------- ADDED CODE -----------------------
   parser.option(0, "dhp"  , 1, [&](const char* s){H_file = s;});
+  parser.option(0, "ppred", 1, [&](const char* s){set_predicate_pred(s);});
+  parser.option(0, "mp"   , 1, [&](const char* s){set_multipath(s);});
+  parser.option(0, "ci"   , 1, [&](const char* s){set_reconv_reuse(s);});
+  parser.option(0, "cisel", 0, [&](const char* s){RECONV_SELECTIVE = true;});
+  parser.option(0, "elim" , 1, [&](const char* s){set_elim(s);});
+  parser.option(0, "erel" , 0, [&](const char* s){EARLY_RELEASE = true;});
+  parser.option(0, "vp"   , 1, [&](const char* s){set_value_pred(s);});
+  parser.option(0, "fusion", 1, [&](const char* s){set_fusion(s);});
   //-------------------------------------------------------------------
   auto argv1 = parser.parse(argv);
   if (!*argv1)
@@ -1,5 +1,7 @@
 #include <cinttypes>
 #include "fu.h"
+#include "repl_policy.h"
+#include "prefetch.h"
 #include <string>
 // Pipe control
 uint32_t PIPE_QUEUE_SIZE  = 8192;
@@ -31,6 +33,9 @@ bool IC_SINGLE_BB		      = false;	// not used currently
 bool IN_ORDER_ISSUE		    = false;	// not used currently
 bool SPEC_DISAMBIG = false;
 bool MEM_DEP_PRED = false;
+unsigned int STORE_SET_SSIT_SIZE = 10;		// log2 of the number of SSIT entries
+unsigned int STORE_SET_LFST_SIZE = 7;		// log2 of the number of LFST entries (store sets)
+uint64_t STORE_SET_CLEAR_INTERVAL = 1000000;	// cycles between clearings of the store-set predictor
 
 bool PRESTEER = false;
 bool IDEAL_AGE_BASED = false;
@@ -78,6 +83,7 @@ unsigned int L1_DC_MISS_LATENCY     = 100; // Used only when no L2 cache
 unsigned int L1_DC_NUM_MHSRs        = 64; 
 unsigned int L1_DC_MISS_SRV_PORTS   = 64;
 unsigned int L1_DC_MISS_SRV_LATENCY = 1;
+repl_policy_e L1_DC_REPL            = REPL_LRU;
 
 // L1 Instruction Cache.
 unsigned int L1_IC_SETS             = 128;
@@ -88,6 +94,9 @@ unsigned int L1_IC_MISS_LATENCY     = 100; // Used only when no L2 cache
 unsigned int L1_IC_NUM_MHSRs        = 32;
 unsigned int L1_IC_MISS_SRV_PORTS   = 1;
 unsigned int L1_IC_MISS_SRV_LATENCY = 1;
+repl_policy_e L1_IC_REPL            = REPL_LRU;
+unsigned int L1_IC_FDIP_DEPTH       = 0;
+bool         L1_IC_LINE_BUFFER      = true;
 
 // L2 Unified Cache.
 bool         L2_PRESENT           = true;
@@ -99,11 +108,48 @@ unsigned int L2_MISS_LATENCY      = 100;  // Used only when no L3
 unsigned int L2_NUM_MHSRs         = 64; 
 unsigned int L2_MISS_SRV_PORTS    = 64;
 unsigned int L2_MISS_SRV_LATENCY  = 1;
+repl_policy_e L2_REPL              = REPL_LRU;
+
+// Write-back buffers.
+unsigned int L1_DC_WBB_SIZE        = 0;
+unsigned int L2_WBB_SIZE           = 0;
+
+// Shared L2 and coherence.
+bool         L2_SHARED             = false;
+unsigned int COHERENCE_DIR_LATENCY = 10;
+unsigned int COHERENCE_C2C_LATENCY = 30;
+unsigned int COHERENCE_INV_LATENCY = 20;
+
+// Latency histograms.
+bool         LATENCY_HIST          = false;
+unsigned int LATENCY_HIST_PCS      = 20;
+
+// Data prefetchers.
+prefetcher_e L1_DC_PREFETCH        = PF_NONE;
+prefetcher_e L2_PREFETCH           = PF_NONE;
+unsigned int PREFETCH_DEGREE       = 2;
+unsigned int PREFETCH_DISTANCE     = 16;
+unsigned int PREFETCH_STRIDE_SIZE  = 8;
+unsigned int PREFETCH_STREAMS      = 16;
+
+// DRAM: DDR4-3200-like timing for a 4 GHz processor.
+bool         DRAM_PRESENT         = false;
+unsigned int DRAM_CHANNELS        = 2;
+unsigned int DRAM_BANKS           = 16;
+unsigned int DRAM_ROW_SIZE        = 13;	// 8 KB rows
+unsigned int DRAM_RQ_SIZE         = 32;
+unsigned int DRAM_WQ_SIZE         = 32;
+unsigned int DRAM_CTRL_LATENCY    = 20;
+unsigned int DRAM_tCL             = 55;
+unsigned int DRAM_tRCD            = 55;
+unsigned int DRAM_tRP             = 55;
+unsigned int DRAM_tBURST          = 10;
 
 // Branch prediction unit
 unsigned int BQ_SIZE = 512;
 unsigned int BTB_ENTRIES = 8192;
 unsigned int BTB_ASSOC = 4;
+repl_policy_e BTB_REPL = REPL_LRU;
 unsigned int RAS_SIZE = 64;
 unsigned int COND_BRANCH_PRED_PER_CYCLE = 3;
 unsigned int CBP_PC_LENGTH = 20;
@@ -112,6 +158,38 @@ unsigned int IBP_PC_LENGTH = 20;
 unsigned int IBP_BHR_LENGTH = 16;
 bool ENABLE_TRACE_CACHE = false;
 
+// DHP predicate predictor
+bool PREDICATE_PRED = false;
+unsigned int PREDICATE_PRED_PC_LENGTH = 12;
+unsigned int PREDICATE_PRED_HIST_LENGTH = 8;
+unsigned int PREDICATE_PRED_CONF_THRESHOLD = 8;
+
+// Dynamic multipath execution
+bool MULTIPATH = false;
+unsigned int MULTIPATH_DEPTH = 8;
+
+// Control-independent squash reuse
+bool RECONV_REUSE = false;
+unsigned int RECONV_PRED_SIZE = 10;	// log2 of the number of reconvergence predictor entries
+unsigned int RECONV_WINDOW = 64;	// instructions searched for the reconvergence point, and reused after it
+unsigned int RECONV_CONF_THRESHOLD = 4;
+bool RECONV_SELECTIVE = false;		// squash only the wrong-path instructions before the reconvergence point, if possible
+
+// Rename-time elimination
+bool MOVE_ELIM = false;		// "addi rd, rs, 0": rd is mapped to rs's physical register
+bool IDIOM_ELIM = false;	// constant idioms ("li", "lui", "xor/sub rd, rs, rs"): the value is written at rename
+
+// Early physical register release
+bool EARLY_RELEASE = false;	// free a register once it is redefined (non-speculatively) and read by all consumers
+
+// Value prediction
+bool VALUE_PRED = false;
+unsigned int VALUE_PRED_SIZE = 12;		// log2 of the number of value predictor entries
+unsigned int VALUE_PRED_CONF_THRESHOLD = 15;
+
+// Macro-op fusion
+unsigned int FUSION = 0;	// mask of FUSE_* pair kinds fused in the Decode Stage (0: disabled)
+
 // Benchmark control.
 bool logging_on                     = false;
 int64_t logging_on_at               = -2;  //0xfffffffffffffffe
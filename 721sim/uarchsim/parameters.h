@@ -2,6 +2,8 @@
 #define PARAMETERS_H
 #include <cinttypes>
 #include <string>
+#include "repl_policy.h"
+#include "prefetch.h"
 // Pipe control
 extern unsigned int PIPE_QUEUE_SIZE;
 
@@ -33,6 +35,9 @@ extern bool         IC_SINGLE_BB;		// not used currently
 extern bool         IN_ORDER_ISSUE;		// not used currently
 extern bool         SPEC_DISAMBIG;
 extern bool         MEM_DEP_PRED;
+extern unsigned int STORE_SET_SSIT_SIZE;
+extern unsigned int STORE_SET_LFST_SIZE;
+extern uint64_t     STORE_SET_CLEAR_INTERVAL;
 extern bool         PRESTEER;
 extern bool         IDEAL_AGE_BASED;
 extern unsigned int FU_LANE_MATRIX[];
@@ -47,6 +52,7 @@ extern unsigned int L1_DC_MISS_LATENCY;
 extern unsigned int L1_DC_NUM_MHSRs;
 extern unsigned int L1_DC_MISS_SRV_PORTS;
 extern unsigned int L1_DC_MISS_SRV_LATENCY;
+extern repl_policy_e L1_DC_REPL;
 
 // L1 Instruction Cache.
 extern unsigned int L1_IC_SETS;
@@ -57,6 +63,9 @@ extern unsigned int L1_IC_MISS_LATENCY;
 extern unsigned int L1_IC_NUM_MHSRs;
 extern unsigned int L1_IC_MISS_SRV_PORTS;
 extern unsigned int L1_IC_MISS_SRV_LATENCY;
+extern repl_policy_e L1_IC_REPL;
+extern unsigned int L1_IC_FDIP_DEPTH;	// fetch-directed prefetching: fetch bundles to prefetch ahead (0: disabled)
+extern bool         L1_IC_LINE_BUFFER;	// fetch line buffer: skip the I$ lookups and MMU fetches of the last lines hit (see ic.h)
 
 // L2 Unified Cache.
 extern bool         L2_PRESENT;
@@ -68,11 +77,48 @@ extern unsigned int L2_MISS_LATENCY;
 extern unsigned int L2_NUM_MHSRs; 
 extern unsigned int L2_MISS_SRV_PORTS;
 extern unsigned int L2_MISS_SRV_LATENCY;
+extern repl_policy_e L2_REPL;
+
+// Write-back buffers: dirty victims waiting to be written to the next level (0: none; a fill waits for its victim's writeback).
+extern unsigned int L1_DC_WBB_SIZE;
+extern unsigned int L2_WBB_SIZE;
+
+// Shared L2 (-p <n>): one L2 for all cores, with a MESI directory between their L1 D$s (coherence.h).
+extern bool         L2_SHARED;
+extern unsigned int COHERENCE_DIR_LATENCY;	// directory lookup, when no other L1 is involved
+extern unsigned int COHERENCE_C2C_LATENCY;	// miss supplied by another core's L1
+extern unsigned int COHERENCE_INV_LATENCY;	// invalidating other copies, with acks
+
+// Latency histograms (histogram.h): of retired loads, over all and per load PC, and of the reads at each cache level.
+extern bool         LATENCY_HIST;
+extern unsigned int LATENCY_HIST_PCS;		// number of load PCs to report, by total latency
+
+// Data prefetchers (prefetch.h).
+extern prefetcher_e L1_DC_PREFETCH;
+extern prefetcher_e L2_PREFETCH;
+extern unsigned int PREFETCH_DEGREE;		// prefetches per training access
+extern unsigned int PREFETCH_DISTANCE;		// stream: lines ahead of the demand stream
+extern unsigned int PREFETCH_STRIDE_SIZE;	// stride: log2 of the number of table entries
+extern unsigned int PREFETCH_STREAMS;		// stream: number of streams tracked
+
+// DRAM (dram.h), behind the L2. If not present, an L2 miss takes L2_MISS_LATENCY.
+extern bool         DRAM_PRESENT;
+extern unsigned int DRAM_CHANNELS;
+extern unsigned int DRAM_BANKS;		// per channel
+extern unsigned int DRAM_ROW_SIZE;	// 2^ROW_SIZE bytes per row
+extern unsigned int DRAM_RQ_SIZE;	// read queue entries per channel
+extern unsigned int DRAM_WQ_SIZE;	// write queue entries per channel
+extern unsigned int DRAM_CTRL_LATENCY;	// timing is in processor cycles
+extern unsigned int DRAM_tCL;
+extern unsigned int DRAM_tRCD;
+extern unsigned int DRAM_tRP;
+extern unsigned int DRAM_tBURST;
 
 // Branch prediction unit
 extern unsigned int BQ_SIZE;
 extern unsigned int BTB_ENTRIES;
 extern unsigned int BTB_ASSOC;
+extern repl_policy_e BTB_REPL;
 extern unsigned int RAS_SIZE;
 extern unsigned int COND_BRANCH_PRED_PER_CYCLE;
 extern unsigned int CBP_PC_LENGTH;
@@ -81,6 +127,41 @@ extern unsigned int IBP_PC_LENGTH;
 extern unsigned int IBP_BHR_LENGTH;
 extern bool ENABLE_TRACE_CACHE;
 
+// DHP predicate predictor
+extern bool PREDICATE_PRED;
+extern unsigned int PREDICATE_PRED_PC_LENGTH;
+extern unsigned int PREDICATE_PRED_HIST_LENGTH;
+extern unsigned int PREDICATE_PRED_CONF_THRESHOLD;
+
+// Dynamic multipath execution
+extern bool MULTIPATH;
+extern unsigned int MULTIPATH_DEPTH;
+
+// Control-independent squash reuse
+extern bool RECONV_REUSE;
+extern unsigned int RECONV_PRED_SIZE;
+extern unsigned int RECONV_WINDOW;
+extern unsigned int RECONV_CONF_THRESHOLD;
+extern bool RECONV_SELECTIVE;
+
+// Rename-time elimination
+extern bool MOVE_ELIM;
+extern bool IDIOM_ELIM;
+
+// Early physical register release
+extern bool EARLY_RELEASE;
+
+// Value prediction
+extern bool VALUE_PRED;
+extern unsigned int VALUE_PRED_SIZE;
+extern unsigned int VALUE_PRED_CONF_THRESHOLD;
+
+// Macro-op fusion
+#define FUSE_IMM	1	// "lui/auipc rd" + "addi/addiw/jalr rd, rd, imm"
+#define FUSE_SHIFT	2	// "slli rd, rs, k" + "srli/srai rd, rd, k"
+#define FUSE_CMP_BR	4	// "slt/sltu/slti/sltiu rd" + "beq/bne rd, x0"
+extern unsigned int FUSION;
+
 // Benchmark control.
 extern bool logging_on;
 extern int64_t logging_on_at;
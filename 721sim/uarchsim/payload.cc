@@ -171,7 +171,12 @@ void payload::map_to_actual(pipeline_t* proc, unsigned int index) {
     //TODO: Fix this
 		//Previous was a hammock.
 		//HP--printf("Previous is Good --- Map to actual\n");
-		if(buf[prev_index].branch && buf[prev_index].branch_type == HAMMOCK) {
+		if(buf[prev_index].branch && buf[prev_index].branch_type == HAMMOCK && buf[index].instruction_type == CMOV) {
+			//Multipath fork whose paths are both empty: the CMOVs inherit the fork's db_index.
+			buf[index].good_instruction = true;
+			buf[index].db_index = buf[prev_index].db_index;
+		}
+		else if(buf[prev_index].branch && buf[prev_index].branch_type == HAMMOCK) {
 			db_index = proc->get_pipe()->check_next(buf[prev_index].db_index, buf[index].pc);
 			//Current instruction should be in then clause. 
 			if(db_index == DEBUG_INDEX_INVALID) {
@@ -256,10 +261,17 @@ void payload::map_to_actual(pipeline_t* proc, unsigned int index) {
 					db_index = proc->get_pipe()->check_next(buf[prev_index].db_index, buf[index].pc);
 					//printf("PC %llx\n", buf[index].pc);
 					//printf("DB_INDEX of Previous CMOV - %d\n", buf[prev_index].db_index);
-					//Current is not CMOV. Then it should be Reconvergent Point and should have a mapping in debug buffer.
-					//assert(db_index != DEBUG_INDEX_INVALID);
-					buf[index].good_instruction = true;
-					buf[index].db_index = db_index;
+					//Current is not CMOV. Then it should be Reconvergent Point and should have a mapping in debug buffer,
+					//unless it is the continuation of the wrong path of a multipath fork.
+					if(db_index == DEBUG_INDEX_INVALID) {
+						// Transition to bad mode.
+						buf[index].good_instruction = false;
+						buf[index].db_index = DEBUG_INDEX_INVALID;
+					}
+					else {
+						buf[index].good_instruction = true;
+						buf[index].db_index = db_index;
+					}
 				}
 			}
 		}
@@ -73,6 +73,44 @@ typedef struct {
    int predication_tag;
    //-----------------------------------------------
 
+   // Dynamic multipath execution (see btb.h).
+   bool mp_fork;                // Multipath fork branch.
+   bool mp_join;                // Last CMOV of a multipath fork: resolves which path continues.
+   bool mp_taken;               // Fork/join: predicted direction of the fork branch.
+   uint64_t mp_taken_pc;        // Join only: PC after the last instruction of the taken path.
+   uint64_t mp_not_taken_pc;    // Join only: PC after the last instruction of the not-taken path.
+
+   // Predicate prediction (see predicate_pred.h).
+   bool pp_valid;               // Hammock: its predicate was predicted with confidence.
+                                // CMOV: select a side using pp_predicate instead of
+                                // waiting for the predicate register (D).
+   bool pp_predicate;           // The predicted predicate. For a CMOV, this is overwritten
+                                // with the actual predicate when the hammock resolves.
+   uint64_t pp_index;           // Hammock: predicate predictor entry to train at retirement.
+   bool pp_executed;            // CMOV: executed using pp_predicate.
+   bool src_read;               // The source operands have been read from the PRF
+                                // (set by the Register Read Stage).
+   bool wb_done;                // Reached the Writeback Stage, i.e., C_value is final
+                                // (see pipeline_t::ci_capture()).
+   bool move_elim;              // Eliminated move: C shares A's physical register (see renamer::rename_move()).
+   bool const_elim;             // Eliminated constant idiom: C_value was computed by the Rename Stage.
+   bool vp_eligible;            // Value prediction: the instruction looked up the value predictor (see value_pred.h).
+   bool vp_counted;             // Counted as in flight by the value predictor.
+   bool vp_valid;               // Its consumers may use vp_value, which the Dispatch Stage wrote into C_phys_reg.
+   uint64_t vp_value;
+   bool src_pending;            // Early register release: the renamer counts this instruction as a pending
+                                // reader of its source registers (see pipeline_t::release_sources()).
+   bool fused;                  // Macro-op fusion: this instruction also executes the instruction before it
+                                // (see pipeline_t::fuse()).
+   bool fused_A;                // Fused: the operand that read the absorbed instruction's result is A (else B).
+   bool absorbed;               // Fused into the instruction after it: not renamed, dispatched, or executed
+                                // on its own, but retired and checked just before it.
+   reg_t viol_store_pc;         // Load violation: PC of the store that detected it (see store_set.h).
+
+   // Per-hammock measurements (see hammock_stats.h).
+   uint64_t hammock_pc;         // PC of the hammock this instruction belongs to, or its own PC if it is a hammock.
+   uint64_t hammock_gshare_index; // Hammock: shadow gshare index, for training at retirement.
+
    insn_t inst;                 // The RISCV instruction.
    reg_t pc;                    // The instruction's PC.
    reg_t next_pc;               // The next instruction's PC. (I.e., the PC of the instruction fetched after this one.)
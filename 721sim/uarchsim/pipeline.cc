@@ -21,6 +21,11 @@
 #undef STATE
 #define STATE state
 
+// With L2_SHARED, the first core builds the L2 and the coherence directory,
+// and the other cores use them.
+static CacheClass* shared_L2C = NULL;
+static directory_t* coherence_directory = NULL;
+
 static unsigned int count_bits32(unsigned int val)
 {
   unsigned int count = 0;
@@ -33,7 +38,7 @@ static unsigned int count_bits32(unsigned int val)
   return count;
 }
 
-static void print_cache_config(FILE *fp, unsigned int sets, unsigned int assoc, unsigned int blocksize, unsigned int latency, unsigned int MHSRs) {
+static void print_cache_config(FILE *fp, unsigned int sets, unsigned int assoc, unsigned int blocksize, unsigned int latency, unsigned int MHSRs, repl_policy_e repl) {
    unsigned int i = (sets*assoc*blocksize);
    if ((i >> 20) > 0)
       fprintf(fp, "   %d MB, ", (i >> 20));
@@ -51,6 +56,7 @@ static void print_cache_config(FILE *fp, unsigned int sets, unsigned int assoc,
 
    fprintf(fp, "   hit latency = %d cycles\n", latency);
    fprintf(fp, "   MHSRs = %d\n", MHSRs);
+   fprintf(fp, "   replacement policy = %s\n", repl_policy_t::name(repl));
 }
 
 
@@ -138,7 +144,13 @@ pipeline_t::pipeline_t(
   // Unified L2 cache.
   /////////////////////////////////////////////////////////////
 
-  if(L2_PRESENT){
+  if (DRAM_PRESENT && !L2_PRESENT) {
+     fprintf(stderr, "The DRAM model (--dram) sits behind the L2 cache: it cannot be combined with --nol2.\n");
+     exit(-1);
+  }
+  if(L2_PRESENT && L2_SHARED && shared_L2C){
+    L2C = shared_L2C;
+  } else if(L2_PRESENT){
     L2C = new CacheClass( L2_SETS,
                         L2_ASSOC,
                         L2_LINE_SIZE,
@@ -147,9 +159,21 @@ pipeline_t::pipeline_t(
                         L2_NUM_MHSRs,
                         L2_MISS_SRV_PORTS,
                         L2_MISS_SRV_LATENCY,
+                        L2_REPL,
                         this,
                         "l2_c",
                         NULL);
+    L2C->set_prefetcher(prefetcher_t::create(L2_PREFETCH, L2_LINE_SIZE, PREFETCH_DEGREE, PREFETCH_DISTANCE, PREFETCH_STRIDE_SIZE, PREFETCH_STREAMS));
+    L2C->set_writeback_buffer(L2_WBB_SIZE);
+    if (DRAM_PRESENT)
+      L2C->set_memory(new dram_t(DRAM_CHANNELS, DRAM_BANKS, L2_LINE_SIZE, DRAM_ROW_SIZE,
+                                 DRAM_RQ_SIZE, DRAM_WQ_SIZE,
+                                 DRAM_CTRL_LATENCY, DRAM_tCL, DRAM_tRCD, DRAM_tRP, DRAM_tBURST,
+                                 stats));
+    if (L2_SHARED) {
+      shared_L2C = L2C;
+      coherence_directory = new directory_t(COHERENCE_DIR_LATENCY, COHERENCE_C2C_LATENCY, COHERENCE_INV_LATENCY);
+    }
   } else {
     L2C = NULL;
   }
@@ -162,6 +186,7 @@ pipeline_t::pipeline_t(
 			      COND_BRANCH_PRED_PER_CYCLE,
 			      BTB_ENTRIES,
 			      BTB_ASSOC,
+			      BTB_REPL,
 			      CBP_PC_LENGTH, CBP_BHR_LENGTH,
 			      IBP_PC_LENGTH, IBP_BHR_LENGTH,
 			      RAS_SIZE,
@@ -178,11 +203,15 @@ pipeline_t::pipeline_t(
 			      L1_IC_NUM_MHSRs,
 			      L1_IC_MISS_SRV_PORTS,
 			      L1_IC_MISS_SRV_LATENCY,
+			      L1_IC_REPL,
+			      L1_IC_FDIP_DEPTH,
+			      L1_IC_LINE_BUFFER,
 			      L2C,   // pointer to L2 cache
 			      _mmu,  // pointer to mmu
 			      this,  // pointer to pipeline_t
 			      &PAY, // pointer to PAY
-            H_file); //pointer to DHP file ----------------------- ADDED CODE ---------------------  
+            H_file, //pointer to DHP file ----------------------- ADDED CODE ---------------------  
+			      (MULTIPATH ? MULTIPATH_DEPTH : 0));
   /////////////////////////////////////////////////////////////
   // Pipeline register between the Fetch and Decode Stages.
   /////////////////////////////////////////////////////////////
@@ -196,7 +225,16 @@ pipeline_t::pipeline_t(
   ////////////////////////////////////////////////////////////
   // Set up the register renaming modules.
   ////////////////////////////////////////////////////////////
-  REN = new renamer(NXPR+NFPR, (NXPR + NFPR + rob_size), num_chkpts);
+  if (MOVE_ELIM && EARLY_RELEASE) {
+     fprintf(stderr, "Early register release (--erel) cannot be combined with move elimination (--elim=1,<idiom>).\n");
+     exit(-1);
+  }
+  if (PREDICATE_PRED && EARLY_RELEASE) {
+     // A CMOV's destination could be released while its predicate is still a prediction, and then overwritten by the CMOV's replay.
+     fprintf(stderr, "Early register release (--erel) cannot be combined with the DHP predicate predictor (--ppred).\n");
+     exit(-1);
+  }
+  REN = new renamer(NXPR+NFPR, (NXPR + NFPR + rob_size), num_chkpts, MOVE_ELIM, EARLY_RELEASE);
 
   /////////////////////////////////////////////////////////////
   // Pipeline register between the Rename and Dispatch Stages.
@@ -242,6 +280,53 @@ pipeline_t::pipeline_t(
   /////////////////////////////////////////////////////////////
 
   LSU.set_l2_cache(L2C);
+  if (L2_PRESENT && L2_SHARED)
+    LSU.set_directory(coherence_directory, Tid);
+
+  /////////////////////////////////////////////////////////////
+  // DHP predicate predictor.
+  /////////////////////////////////////////////////////////////
+  if (PREDICATE_PRED && (H_file == "")) {
+     fprintf(stderr, "The DHP predicate predictor (--ppred) requires Dynamic Hammock Predication (--dhp).\n");
+     exit(-1);
+  }
+  if (PREDICATE_PRED) {
+     PP = new predicate_predictor_t(PREDICATE_PRED_PC_LENGTH, PREDICATE_PRED_HIST_LENGTH, PREDICATE_PRED_CONF_THRESHOLD);
+  }
+  else {
+     PP = NULL;
+  }
+  pp_last_valid = false;
+  pp_last_predicate = false;
+
+  /////////////////////////////////////////////////////////////
+  // Control-independent squash reuse.
+  /////////////////////////////////////////////////////////////
+  if (RECONV_SELECTIVE && !RECONV_REUSE) {
+     fprintf(stderr, "Selective recovery (--cisel) requires control-independent squash reuse (--ci).\n");
+     exit(-1);
+  }
+  if (RECONV_REUSE)
+     CI = new reconv_predictor_t(RECONV_PRED_SIZE, RECONV_WINDOW, RECONV_CONF_THRESHOLD);
+  else
+     CI = NULL;
+  ci_clear();
+
+  /////////////////////////////////////////////////////////////
+  // Value predictor.
+  /////////////////////////////////////////////////////////////
+  if (VALUE_PRED)
+     VP = new value_predictor_t(VALUE_PRED_SIZE, VALUE_PRED_CONF_THRESHOLD);
+  else
+     VP = NULL;
+
+  /////////////////////////////////////////////////////////////
+  // Store-set memory dependence predictor.
+  /////////////////////////////////////////////////////////////
+  if (MEM_DEP_PRED)
+     MDP = new store_set_t(STORE_SET_SSIT_SIZE, STORE_SET_LFST_SIZE);
+  else
+     MDP = NULL;
 
 
   // Declare and set the various knobs in the knobs database.
@@ -271,7 +356,12 @@ pipeline_t::pipeline_t(
   fprintf(stats_log, "   LOAD QUEUE = %d\n", lq_size);
   fprintf(stats_log, "   STORE QUEUE = %d\n", sq_size);
   fprintf(stats_log, "   SPECULATIVE DISAMBIGUATION = %d\n", SPEC_DISAMBIG);
-  fprintf(stats_log, "   USE STICKY-BIT MEMORY DEPENDENCE PREDICTOR = %d\n", MEM_DEP_PRED);
+  fprintf(stats_log, "   USE STORE-SET MEMORY DEPENDENCE PREDICTOR = %d\n", MEM_DEP_PRED);
+  if (MEM_DEP_PRED) {
+     fprintf(stats_log, "      SSIT = %d\n", (1 << STORE_SET_SSIT_SIZE));
+     fprintf(stats_log, "      LFST = %d\n", (1 << STORE_SET_LFST_SIZE));
+     fprintf(stats_log, "      CLEAR INTERVAL = %lu\n", STORE_SET_CLEAR_INTERVAL);
+  }
 
   fprintf(stats_log, "\n=== PIPELINE STAGE WIDTHS =======================================================\n\n");
   fprintf(stats_log, "FETCH WIDTH = %d\n", fetch_width);
@@ -296,17 +386,45 @@ pipeline_t::pipeline_t(
   fprintf(stats_log, "\n=== MEMORY HIERARCHY ============================================================\n\n");
 
   fprintf(stats_log, "L1 I$:\n");
-  print_cache_config(stats_log, L1_IC_SETS, L1_IC_ASSOC, (1<<L1_IC_LINE_SIZE), L1_IC_HIT_LATENCY, L1_IC_NUM_MHSRs);
+  print_cache_config(stats_log, L1_IC_SETS, L1_IC_ASSOC, (1<<L1_IC_LINE_SIZE), L1_IC_HIT_LATENCY, L1_IC_NUM_MHSRs, L1_IC_REPL);
   if (!L2_PRESENT) fprintf(stats_log, "   miss latency = %d cycles\n", L1_IC_MISS_LATENCY);
+  if (L1_IC_FDIP_DEPTH) fprintf(stats_log, "   fetch-directed prefetching = %d fetch bundles ahead\n", L1_IC_FDIP_DEPTH);
+  if (L1_IC_LINE_BUFFER) fprintf(stats_log, "   fetch line buffer = 2 lines\n");
 
   fprintf(stats_log, "L1 D$:\n");
-  print_cache_config(stats_log, L1_DC_SETS, L1_DC_ASSOC, (1<<L1_DC_LINE_SIZE), L1_DC_HIT_LATENCY, L1_DC_NUM_MHSRs);
+  print_cache_config(stats_log, L1_DC_SETS, L1_DC_ASSOC, (1<<L1_DC_LINE_SIZE), L1_DC_HIT_LATENCY, L1_DC_NUM_MHSRs, L1_DC_REPL);
   if (!L2_PRESENT) fprintf(stats_log, "   miss latency = %d cycles\n", L1_DC_MISS_LATENCY);
+  if (L1_DC_WBB_SIZE) fprintf(stats_log, "   write-back buffer = %d entries\n", L1_DC_WBB_SIZE);
 
   if (L2_PRESENT) {
      fprintf(stats_log, "L2$:\n");
-     print_cache_config(stats_log, L2_SETS, L2_ASSOC, (1<<L2_LINE_SIZE), L2_HIT_LATENCY, L2_NUM_MHSRs);
-     fprintf(stats_log, "   miss latency = %d cycles\n", L2_MISS_LATENCY);
+     print_cache_config(stats_log, L2_SETS, L2_ASSOC, (1<<L2_LINE_SIZE), L2_HIT_LATENCY, L2_NUM_MHSRs, L2_REPL);
+     if (!DRAM_PRESENT)
+        fprintf(stats_log, "   miss latency = %d cycles\n", L2_MISS_LATENCY);
+     if (L2_WBB_SIZE)
+        fprintf(stats_log, "   write-back buffer = %d entries\n", L2_WBB_SIZE);
+     if (L2_SHARED) {
+        fprintf(stats_log, "   shared by all cores, with a MESI directory between the L1 D$s\n");
+        fprintf(stats_log, "   directory = %d, cache-to-cache = %d, invalidation = %d cycles\n", COHERENCE_DIR_LATENCY, COHERENCE_C2C_LATENCY, COHERENCE_INV_LATENCY);
+     }
+  }
+
+  if (L2_PRESENT && DRAM_PRESENT) {
+     fprintf(stats_log, "DRAM:\n");
+     fprintf(stats_log, "   %d channels, %d banks per channel, %d B rows\n", DRAM_CHANNELS, DRAM_BANKS, (1<<DRAM_ROW_SIZE));
+     fprintf(stats_log, "   read queue = %d, write queue = %d (per channel)\n", DRAM_RQ_SIZE, DRAM_WQ_SIZE);
+     fprintf(stats_log, "   controller = %d, tCL = %d, tRCD = %d, tRP = %d, tBURST = %d cycles\n", DRAM_CTRL_LATENCY, DRAM_tCL, DRAM_tRCD, DRAM_tRP, DRAM_tBURST);
+  }
+
+  fprintf(stats_log, "\n=== DATA PREFETCHERS ============================================================\n\n");
+
+  fprintf(stats_log, "L1_DC_PREFETCH = %s\n", prefetcher_t::name(L1_DC_PREFETCH));
+  fprintf(stats_log, "L2_PREFETCH = %s\n", prefetcher_t::name(L2_PREFETCH));
+  if ((L1_DC_PREFETCH != PF_NONE) || (L2_PREFETCH != PF_NONE)) {
+     fprintf(stats_log, "PREFETCH_DEGREE = %d\n", PREFETCH_DEGREE);
+     fprintf(stats_log, "PREFETCH_DISTANCE = %d\n", PREFETCH_DISTANCE);
+     fprintf(stats_log, "PREFETCH_STRIDE_SIZE = %d\n", PREFETCH_STRIDE_SIZE);
+     fprintf(stats_log, "PREFETCH_STREAMS = %d\n", PREFETCH_STREAMS);
   }
 
   fprintf(stats_log, "\n=== BRANCH PREDICTOR ============================================================\n\n");
@@ -314,6 +432,7 @@ pipeline_t::pipeline_t(
   fprintf(stats_log, "BQ_SIZE = %d\n", BQ_SIZE);
   fprintf(stats_log, "BTB_ENTRIES = %d\n", BTB_ENTRIES);
   fprintf(stats_log, "BTB_ASSOC = %d\n", BTB_ASSOC);
+  fprintf(stats_log, "BTB_REPL = %s\n", repl_policy_t::name(BTB_REPL));
   fprintf(stats_log, "RAS_SIZE = %d\n", RAS_SIZE);
   fprintf(stats_log, "COND_BRANCH_PRED_PER_CYCLE = %d\n", COND_BRANCH_PRED_PER_CYCLE);
   fprintf(stats_log, "CBP_PC_LENGTH = %d\n", CBP_PC_LENGTH);
@@ -322,6 +441,52 @@ pipeline_t::pipeline_t(
   fprintf(stats_log, "IBP_BHR_LENGTH = %d\n", IBP_BHR_LENGTH);
   fprintf(stats_log, "ENABLE_TRACE_CACHE = %d\n", (ENABLE_TRACE_CACHE ? 1 : 0));
 
+  fprintf(stats_log, "\n=== DHP PREDICATE PREDICTOR ======================================================\n\n");
+
+  fprintf(stats_log, "PREDICATE_PRED = %d\n", (PP ? 1 : 0));
+  if (PP) {
+     fprintf(stats_log, "PREDICATE_PRED_PC_LENGTH = %d\n", PREDICATE_PRED_PC_LENGTH);
+     fprintf(stats_log, "PREDICATE_PRED_HIST_LENGTH = %d\n", PREDICATE_PRED_HIST_LENGTH);
+     fprintf(stats_log, "PREDICATE_PRED_CONF_THRESHOLD = %d\n", PREDICATE_PRED_CONF_THRESHOLD);
+  }
+
+  fprintf(stats_log, "\n=== DYNAMIC MULTIPATH EXECUTION =================================================\n\n");
+
+  fprintf(stats_log, "MULTIPATH = %d\n", (MULTIPATH ? 1 : 0));
+  if (MULTIPATH)
+     fprintf(stats_log, "MULTIPATH_DEPTH = %d\n", MULTIPATH_DEPTH);
+
+  fprintf(stats_log, "\n=== CONTROL-INDEPENDENT SQUASH REUSE ==========================================\n\n");
+
+  fprintf(stats_log, "RECONV_REUSE = %d\n", (CI ? 1 : 0));
+  if (CI) {
+     fprintf(stats_log, "RECONV_PRED_SIZE = %d\n", RECONV_PRED_SIZE);
+     fprintf(stats_log, "RECONV_WINDOW = %d\n", RECONV_WINDOW);
+     fprintf(stats_log, "RECONV_CONF_THRESHOLD = %d\n", RECONV_CONF_THRESHOLD);
+     fprintf(stats_log, "RECONV_SELECTIVE = %d\n", (RECONV_SELECTIVE ? 1 : 0));
+  }
+
+  fprintf(stats_log, "\n=== RENAME-TIME ELIMINATION ===================================================\n\n");
+
+  fprintf(stats_log, "MOVE_ELIM = %d\n", (MOVE_ELIM ? 1 : 0));
+  fprintf(stats_log, "IDIOM_ELIM = %d\n", (IDIOM_ELIM ? 1 : 0));
+
+  fprintf(stats_log, "\n=== EARLY REGISTER RELEASE ====================================================\n\n");
+
+  fprintf(stats_log, "EARLY_RELEASE = %d\n", (EARLY_RELEASE ? 1 : 0));
+
+  fprintf(stats_log, "\n=== VALUE PREDICTION ==========================================================\n\n");
+
+  fprintf(stats_log, "VALUE_PRED = %d\n", (VP ? 1 : 0));
+  if (VP) {
+     fprintf(stats_log, "VALUE_PRED_SIZE = %d\n", VALUE_PRED_SIZE);
+     fprintf(stats_log, "VALUE_PRED_CONF_THRESHOLD = %d\n", VALUE_PRED_CONF_THRESHOLD);
+  }
+
+  fprintf(stats_log, "\n=== MACRO-OP FUSION ===========================================================\n\n");
+
+  fprintf(stats_log, "FUSION = %d\n", FUSION);
+
   fprintf(stats_log, "\n=== END CONFIGURATION ===========================================================\n\n");
 
   //DECLARE_KNOB(get_stats(), ctiq_size, CTIQ_SIZE, proc);
@@ -349,6 +514,7 @@ pipeline_t::pipeline_t(
 pipeline_t::~pipeline_t()
 {
   //stats->dump_knobs();
+  stats->update_counter("early_release_count", (unsigned int)REN->get_early_release_count());
   stats->dump_counters();
   stats->dump_rates();
   stats->dump_pc_histogram();
@@ -365,6 +531,8 @@ pipeline_t::~pipeline_t()
 
   FetchUnit->output(stats->get_counter("commit_count"), stats->get_counter("cycle_count"), stats_log);
   LSU.dump_stats(stats_log);
+  if (LATENCY_HIST && L2C && (!L2_SHARED || (Tid == 0)))
+    L2C->dump_latency(stats_log);
 
   #ifdef RISCV_MICRO_DEBUG
     fclose(this->fetch_log    );
@@ -533,6 +701,10 @@ bool pipeline_t::step_micro(size_t instret_limit, size_t& instret)
         // Miscellaneous stuff that must be processed every cycle.
         /////////////////////////////////////////////////////////////
 
+        // Periodically clear the store-set predictor: store sets only grow.
+        if (MDP && ((cycle % STORE_SET_CLEAR_INTERVAL) == 0))
+          MDP->clear();
+
         // Go to the next simulator cycle.
         //next_cycle();
         cycle++;
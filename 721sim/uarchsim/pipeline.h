@@ -38,6 +38,13 @@
 
 #include "lsu.h"		// LOAD/STORE UNIT
 
+#include "predicate_pred.h"	// DHP PREDICATE PREDICTOR
+#include "reconv_pred.h"	// RECONVERGENCE PREDICTOR
+#include "value_pred.h"		// VALUE PREDICTOR
+#include "store_set.h"		// STORE-SET MEMORY DEPENDENCE PREDICTOR
+#include "dram.h"		// DRAM TIMING MODEL
+#include "coherence.h"		// MESI DIRECTORY FOR A SHARED L2
+
 #include "debug.h"
 
 #include "stats.h"
@@ -78,13 +85,6 @@
 
 //////////////////////////////////////////////////////////////////////////////
 
-#define BIT_IS_ZERO(x,i)	(((x) & (((unsigned long long)1) << i)) == 0)
-#define BIT_IS_ONE(x,i)		(((x) & (((unsigned long long)1) << i)) != 0)
-#define SET_BIT(x,i)		  (x |= (((unsigned long long)1) << i))
-#define CLEAR_BIT(x,i)		(x &= ~(((unsigned long long)1) << i))
-
-//////////////////////////////////////////////////////////////////////////////
-
 #define SOURCE1(in)		(in.rs1())
 #define SOURCE2(in)		(in.rs2())
 #define SOURCE3(in)		(in.rs3())
@@ -356,9 +356,33 @@ private:
 	CacheClass* L2C;
 
 	/////////////////////////////////////////////////////////////
-	// Sticky-bit memory dependence predictor (MDP)
+	// Store-set memory dependence predictor (NULL if disabled).
+	/////////////////////////////////////////////////////////////
+	store_set_t* MDP;
+
+	/////////////////////////////////////////////////////////////
+	// DHP predicate predictor (NULL if disabled).
+	// The last decoded hammock's prediction is passed on to its CMOVs.
+	/////////////////////////////////////////////////////////////
+	predicate_predictor_t* PP;
+	bool pp_last_valid;
+	bool pp_last_predicate;
+
+	/////////////////////////////////////////////////////////////
+	// Control-independent squash reuse (NULL if disabled).
+	// ci_buf holds the squashed instructions after the reconvergence
+	// point of the last mispredicted branch (see reconv_pred.h).
+	/////////////////////////////////////////////////////////////
+	reconv_predictor_t* CI;
+	std::vector<ci_entry_t> ci_buf;
+	unsigned int ci_pos;		// next entry to match
+	bool ci_started;		// the correct path reached the reconvergence point
+	unsigned int ci_wait;		// instructions dispatched while waiting for the reconvergence point
+
+	/////////////////////////////////////////////////////////////
+	// Value predictor (NULL if disabled).
 	/////////////////////////////////////////////////////////////
-	std::map<uint64_t, bool> MDP;
+	value_predictor_t* VP;
 
 	//////////////////////
 	// PRIVATE FUNCTIONS
@@ -369,6 +393,15 @@ private:
 	void alu(unsigned int index);
 	void squash_complete(reg_t jump_PC);
 	void resolve(unsigned int branch_ID, bool correct);
+	void predicate_replay(unsigned int index);
+	void ci_capture(unsigned int index);
+	bool ci_recover(unsigned int index);
+	bool ci_reuse(unsigned int index, bool A_ready, bool B_ready);
+	void ci_clear();
+	void release_sources(unsigned int index);
+	void vp_verify(unsigned int index);
+	bool fuse(unsigned int f, unsigned int s);
+	void retire_absorbed(size_t& instret);
 	void checker();
 	void check_single(reg_t micro, reg_t isa, db_t* actual, const char *desc);
 	void check_double(reg_t micro0, reg_t micro1, reg_t isa0, reg_t isa1, const char *desc);
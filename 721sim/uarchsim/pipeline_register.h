@@ -1,13 +1,15 @@
 #ifndef PIPELINE_REGISTER_H
 #define PIPELINE_REGISTER_H
 
+#include "branch_mask.h"
+
 class pipeline_register {
 
 public:
 
 	bool valid;				              // valid instruction
 	unsigned int index;			        // index into instruction payload buffer
-	unsigned long long branch_mask;	// branches that this instruction depends on
+	branch_mask_t branch_mask;	// branches that this instruction depends on
 
 	pipeline_register();	// constructor
 
@@ -0,0 +1,55 @@
+#include <cinttypes>
+#include <cassert>
+#include "predicate_pred.h"
+
+predicate_predictor_t::predicate_predictor_t(uint64_t pc_length, uint64_t hist_length, uint64_t conf_threshold):
+   pp_index(pc_length, hist_length)
+{
+   uint64_t size = pp_index.table_size();
+
+   ctr = new uint8_t[size];
+   conf = new uint8_t[size];
+   for (uint64_t i = 0; i < size; i++) {
+      ctr[i] = 1;	// Initialize counters to weakly-not-set.
+      conf[i] = 0;	// Initialize counters to not confident.
+   }
+
+   // Confidence counters are 4 bits.
+   conf_max = 15;
+   assert(conf_threshold <= conf_max);
+   this->conf_threshold = (uint8_t)conf_threshold;
+}
+
+predicate_predictor_t::~predicate_predictor_t() {
+}
+
+uint64_t predicate_predictor_t::predict(uint64_t pc, bool &predicate, bool &confident) {
+   uint64_t index = pp_index.index(pc);
+   predicate = (ctr[index] >= 2);
+   confident = (conf[index] >= conf_threshold);
+   return(index);
+}
+
+void predicate_predictor_t::update(uint64_t index, bool predicate) {
+   // Resetting confidence counter: increment if the counter would have predicted correctly, else reset.
+   if ((ctr[index] >= 2) == predicate) {
+      if (conf[index] < conf_max)
+         conf[index]++;
+   }
+   else {
+      conf[index] = 0;
+   }
+
+   // 2-bit predicate counter.
+   if (predicate) {
+      if (ctr[index] < 3)
+         ctr[index]++;
+   }
+   else {
+      if (ctr[index] > 0)
+         ctr[index]--;
+   }
+
+   // Committed predicate history.
+   pp_index.update_bhr(predicate);
+}
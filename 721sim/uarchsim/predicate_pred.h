@@ -0,0 +1,48 @@
+#ifndef PREDICATE_PRED_H
+#define PREDICATE_PRED_H
+
+#include <cinttypes>
+#include "gshare.h"
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Predicate predictor for Dynamic Hammock Predication.
+//
+// Without it, every CMOV waits on the predicate physical register (its D
+// operand), so consumers downstream of a hammock are gated by the latency of
+// the hammock's branch condition.
+//
+// The predictor is consulted when a hammock branch is decoded. The CMOVs of
+// the same hammock instance inherit the prediction. If the prediction is
+// confident, the CMOVs select a side without waiting for the predicate. The
+// hammock verifies the prediction in the Writeback Stage (see
+// pipeline_t::predicate_replay()).
+//
+// Each entry has a 2-bit predicate counter and a resetting confidence
+// counter. The table is indexed gshare-style with the hammock PC and a
+// history of committed predicates. The predictor is trained at retirement.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class predicate_predictor_t {
+private:
+	gshare_index_t pp_index;	// hammock PC xor committed predicate history
+	uint8_t *ctr;			// 2-bit predicate counters
+	uint8_t *conf;			// resetting confidence counters
+	uint8_t conf_max;
+	uint8_t conf_threshold;
+
+public:
+	predicate_predictor_t(uint64_t pc_length, uint64_t hist_length, uint64_t conf_threshold);
+	~predicate_predictor_t();
+
+	// Look up the predictor for the hammock at "pc".
+	// Returns the table index, which the hammock must carry until retirement to train the same entry.
+	// "predicate" is the predicted predicate and "confident" indicates whether CMOVs may use it.
+	uint64_t predict(uint64_t pc, bool &predicate, bool &confident);
+
+	// Train the entry at "index" with the committed predicate, and shift the predicate into the history.
+	void update(uint64_t index, bool predicate);
+};
+
+#endif //PREDICATE_PRED_H
@@ -0,0 +1,230 @@
+#include <cinttypes>
+#include <cassert>
+#include <cstring>
+#include "prefetch.h"
+
+static const char *prefetcher_names[NUM_PREFETCHERS] = {"none", "nextline", "stride", "stream"};
+
+prefetcher_t::prefetcher_t(uint64_t line_size, uint64_t degree) {
+   assert((degree > 0) && (degree <= PF_MAX_DEGREE));
+   this->line_size = line_size;
+   this->degree = degree;
+}
+
+prefetcher_t::~prefetcher_t() {
+}
+
+unsigned int prefetcher_t::add(uint64_t addr, uint64_t line, uint64_t *lines, unsigned int n) {
+   if (((line << line_size) >> 12) != (addr >> 12))
+      return(n);		// different page
+   if ((line == (addr >> line_size)) || ((n > 0) && (lines[n-1] == line)))
+      return(n);		// the accessed line, or already added
+   assert(n < PF_MAX_DEGREE);
+   lines[n] = line;
+   return(n + 1);
+}
+
+prefetcher_t *prefetcher_t::create(prefetcher_e pf, uint64_t line_size, uint64_t degree, uint64_t distance, uint64_t log2_stride_size, uint64_t streams) {
+   switch (pf) {
+      case PF_NONE:
+         return(NULL);
+      case PF_NEXT_LINE:
+         return(new next_line_prefetcher_t(line_size, degree));
+      case PF_STRIDE:
+         return(new stride_prefetcher_t(line_size, degree, log2_stride_size));
+      case PF_STREAM:
+         return(new stream_prefetcher_t(line_size, degree, distance, streams));
+      default:
+         assert(0);
+         return(NULL);
+   }
+}
+
+const char *prefetcher_t::name(prefetcher_e pf) {
+   assert(pf < NUM_PREFETCHERS);
+   return(prefetcher_names[pf]);
+}
+
+bool prefetcher_t::parse(const char *s, prefetcher_e &pf) {
+   for (unsigned int i = 0; i < NUM_PREFETCHERS; i++) {
+      if (!strcmp(s, prefetcher_names[i])) {
+         pf = (prefetcher_e)i;
+         return(true);
+      }
+   }
+   return(false);
+}
+
+
+////////////////////////////////////
+// Next-line
+////////////////////////////////////
+
+next_line_prefetcher_t::next_line_prefetcher_t(uint64_t line_size, uint64_t degree) : prefetcher_t(line_size, degree) {
+}
+
+unsigned int next_line_prefetcher_t::train(uint64_t pc, uint64_t addr, bool miss, bool pf_hit, uint64_t lines[PF_MAX_DEGREE]) {
+   unsigned int n = 0;
+   if (miss || pf_hit) {
+      for (uint64_t k = 1; k <= degree; k++)
+         n = add(addr, ((addr >> line_size) + k), lines, n);
+   }
+   return(n);
+}
+
+
+////////////////////////////////////
+// PC-stride
+////////////////////////////////////
+
+stride_prefetcher_t::stride_prefetcher_t(uint64_t line_size, uint64_t degree, uint64_t log2_size) : prefetcher_t(line_size, degree) {
+   size = ((uint64_t)1 << log2_size);
+   tag = new uint64_t[size];
+   last = new uint64_t[size];
+   stride = new int64_t[size];
+   conf = new uint8_t[size];
+   for (uint64_t i = 0; i < size; i++) {
+      tag[i] = 0;
+      last[i] = 0;
+      stride[i] = 0;
+      conf[i] = 0;
+   }
+}
+
+stride_prefetcher_t::~stride_prefetcher_t() {
+   delete [] tag;
+   delete [] last;
+   delete [] stride;
+   delete [] conf;
+}
+
+unsigned int stride_prefetcher_t::train(uint64_t pc, uint64_t addr, bool miss, bool pf_hit, uint64_t lines[PF_MAX_DEGREE]) {
+   uint64_t index = ((pc >> 2) & (size - 1));
+   unsigned int n = 0;
+
+   if (tag[index] != pc) {
+      // Replace the entry.
+      tag[index] = pc;
+      last[index] = addr;
+      stride[index] = 0;
+      conf[index] = 0;
+      return(0);
+   }
+
+   int64_t s = (int64_t)(addr - last[index]);
+   if (s == 0)
+      return(0);		// same address again: no new information
+
+   if (s == stride[index]) {
+      if (conf[index] < 3)
+         conf[index]++;
+   }
+   else if (conf[index] > 0) {
+      conf[index]--;
+   }
+   else {
+      stride[index] = s;
+   }
+   last[index] = addr;
+
+   if (conf[index] >= 2) {
+      for (uint64_t k = 1; k <= degree; k++)
+         n = add(addr, ((addr + (uint64_t)(stride[index] * (int64_t)k)) >> line_size), lines, n);
+   }
+   return(n);
+}
+
+
+////////////////////////////////////
+// Stream
+////////////////////////////////////
+
+stream_prefetcher_t::stream_prefetcher_t(uint64_t line_size, uint64_t degree, uint64_t distance, uint64_t streams) : prefetcher_t(line_size, degree) {
+   assert((distance > 0) && (streams > 0));
+   this->distance = distance;
+   this->streams = streams;
+   valid = new bool[streams];
+   last = new uint64_t[streams];
+   dir = new int64_t[streams];
+   next = new uint64_t[streams];
+   lru = new uint64_t[streams];
+   for (uint64_t i = 0; i < streams; i++) {
+      valid[i] = false;
+      lru[i] = 0;
+   }
+   time = 0;
+}
+
+stream_prefetcher_t::~stream_prefetcher_t() {
+   delete [] valid;
+   delete [] last;
+   delete [] dir;
+   delete [] next;
+   delete [] lru;
+}
+
+unsigned int stream_prefetcher_t::train(uint64_t pc, uint64_t addr, bool miss, bool pf_hit, uint64_t lines[PF_MAX_DEGREE]) {
+   uint64_t line = (addr >> line_size);
+   unsigned int n = 0;
+   uint64_t s;
+   int64_t d;
+
+   if (!miss && !pf_hit)
+      return(0);
+   time++;
+
+   // Find the stream that this line belongs to.
+   for (s = 0; s < streams; s++) {
+      if (valid[s]) {
+         d = (int64_t)(line - last[s]);
+         if ((d <= (int64_t)distance) && (d >= -(int64_t)distance))
+            break;
+      }
+   }
+
+   if (s == streams) {
+      // Allocate a stream: an invalid entry, else the least recently used.
+      uint64_t victim = 0;
+      for (s = 0; s < streams; s++) {
+         if (!valid[s]) {
+            victim = s;
+            break;
+         }
+         else if (lru[s] < lru[victim]) {
+            victim = s;
+         }
+      }
+      valid[victim] = true;
+      last[victim] = line;
+      dir[victim] = 0;
+      next[victim] = line;
+      lru[victim] = time;
+      return(0);
+   }
+
+   lru[s] = time;
+   d = (int64_t)(line - last[s]);
+   if (dir[s] == 0) {
+      // The second miss sets the direction.
+      if (d == 0)
+         return(0);
+      dir[s] = ((d > 0) ? 1 : -1);
+      next[s] = line + dir[s];
+   }
+   if ((d * dir[s]) > 0)
+      last[s] = line;
+
+   // Don't prefetch behind the demand stream.
+   if (((int64_t)(next[s] - line) * dir[s]) <= 0)
+      next[s] = line + dir[s];
+
+   // Prefetch up to "degree" lines, at most "distance" lines ahead.
+   while ((n < degree) && (((int64_t)(next[s] - line) * dir[s]) <= (int64_t)distance)) {
+      unsigned int added = add(addr, next[s], lines, n);
+      if (added == n)
+         break;			// end of page
+      n = added;
+      next[s] += dir[s];
+   }
+   return(n);
+}
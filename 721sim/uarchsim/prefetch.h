@@ -0,0 +1,104 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <cinttypes>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Hardware data prefetchers for CacheClass.
+//
+// A prefetcher is trained on the demand accesses of its cache: the PC and
+// address of each access, whether it missed, and whether it was the first
+// demand reference to a prefetched line (a prefetch hit, which trains like a
+// miss so that a covered stream keeps going). Training returns the line
+// addresses to prefetch. The cache issues them through its own MHSRs and miss
+// ports (CacheClass::Prefetch).
+//
+// Prefetchers:
+// * Next-line: a miss or prefetch hit to line L prefetches lines L+1 ...
+//   L+degree.
+// * PC-stride: a table indexed by load/store PC holds the last address and
+//   stride of each instruction, with a 2-bit confidence counter. Once the
+//   stride has repeated twice, each access prefetches the next "degree"
+//   strides.
+// * Stream: a small fully-associative table of streams. A miss that is not
+//   near an existing stream allocates one (LRU). The next miss within
+//   "distance" lines of it sets the stream's direction. After that, each miss
+//   or prefetch hit in the stream prefetches up to "degree" more lines, and
+//   keeps the prefetches up to "distance" lines ahead of the demand stream.
+//
+// Prefetches do not cross a 4KB page boundary, as addresses are physical.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#define PF_MAX_DEGREE	16	// maximum number of prefetches per training access
+
+typedef enum {
+	PF_NONE,
+	PF_NEXT_LINE,
+	PF_STRIDE,
+	PF_STREAM,
+	NUM_PREFETCHERS
+} prefetcher_e;
+
+class prefetcher_t {
+protected:
+	uint64_t line_size;		// log2 of the line size in bytes
+	uint64_t degree;
+
+	// Add "line" to "lines" if it is on the same page as "addr". Returns the new number of lines.
+	unsigned int add(uint64_t addr, uint64_t line, uint64_t *lines, unsigned int n);
+
+public:
+	prefetcher_t(uint64_t line_size, uint64_t degree);
+	virtual ~prefetcher_t();
+
+	// Train on a demand access. Returns the number of line addresses (addr >> line_size) to prefetch, in "lines".
+	virtual unsigned int train(uint64_t pc, uint64_t addr, bool miss, bool pf_hit, uint64_t lines[PF_MAX_DEGREE]) = 0;
+
+	// Allocate the prefetcher "pf" for a cache with (1 << line_size)-byte lines (NULL for PF_NONE).
+	static prefetcher_t *create(prefetcher_e pf, uint64_t line_size, uint64_t degree, uint64_t distance, uint64_t log2_stride_size, uint64_t streams);
+
+	// Name of a prefetcher, and the prefetcher with a given name (returns false if there is none).
+	static const char *name(prefetcher_e pf);
+	static bool parse(const char *s, prefetcher_e &pf);
+};
+
+class next_line_prefetcher_t : public prefetcher_t {
+public:
+	next_line_prefetcher_t(uint64_t line_size, uint64_t degree);
+	unsigned int train(uint64_t pc, uint64_t addr, bool miss, bool pf_hit, uint64_t lines[PF_MAX_DEGREE]);
+};
+
+class stride_prefetcher_t : public prefetcher_t {
+private:
+	uint64_t size;
+	uint64_t *tag;			// PC
+	uint64_t *last;			// last address
+	int64_t *stride;
+	uint8_t *conf;			// 2-bit confidence counter
+
+public:
+	stride_prefetcher_t(uint64_t line_size, uint64_t degree, uint64_t log2_size);
+	~stride_prefetcher_t();
+	unsigned int train(uint64_t pc, uint64_t addr, bool miss, bool pf_hit, uint64_t lines[PF_MAX_DEGREE]);
+};
+
+class stream_prefetcher_t : public prefetcher_t {
+private:
+	uint64_t distance;		// how far ahead of the demand stream to prefetch, in lines
+	uint64_t streams;
+	bool *valid;
+	uint64_t *last;			// line of the last miss or prefetch hit in the stream
+	int64_t *dir;			// +1 (ascending), -1 (descending) or 0 (not yet known)
+	uint64_t *next;			// next line to prefetch
+	uint64_t *lru;			// time stamp of the last use, for replacement
+	uint64_t time;
+
+public:
+	stream_prefetcher_t(uint64_t line_size, uint64_t degree, uint64_t distance, uint64_t streams);
+	~stream_prefetcher_t();
+	unsigned int train(uint64_t pc, uint64_t addr, bool miss, bool pf_hit, uint64_t lines[PF_MAX_DEGREE]);
+};
+
+#endif //PREFETCH_H
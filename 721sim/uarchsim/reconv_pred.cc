@@ -0,0 +1,94 @@
+#include <cinttypes>
+#include <cassert>
+#include "reconv_pred.h"
+
+reconv_predictor_t::reconv_predictor_t(uint64_t log2_size, uint64_t window, uint64_t conf_threshold) {
+   size = ((uint64_t)1 << log2_size);
+
+   tag = new uint64_t[size];
+   rpc = new uint64_t[size];
+   conf = new uint8_t[size];
+   for (uint64_t i = 0; i < size; i++) {
+      tag[i] = 0;
+      rpc[i] = 0;
+      conf[i] = 0;	// Initialize counters to not confident.
+   }
+
+   // Confidence counters are 4 bits.
+   conf_max = 15;
+   assert(conf_threshold <= conf_max);
+   this->conf_threshold = (uint8_t)conf_threshold;
+
+   assert(window > 0);
+   this->window = window;
+
+   pending = false;
+}
+
+reconv_predictor_t::~reconv_predictor_t() {
+}
+
+bool reconv_predictor_t::predict(uint64_t pc, uint64_t &rpc) {
+   uint64_t index = ((pc >> 2) & (size - 1));
+   if ((tag[index] == pc) && (conf[index] >= conf_threshold)) {
+      rpc = this->rpc[index];
+      return(true);
+   }
+   return(false);
+}
+
+// Train the pending branch's entry.
+// "reached": the committed path reached a reconvergence point, "observed_rpc", within the window.
+void reconv_predictor_t::train_entry(bool reached, uint64_t observed_rpc) {
+   uint64_t index = pending_index;
+
+   pending = false;
+
+   if (!reached) {
+      conf[index] = 0;
+   }
+   else if ((tag[index] == pending_pc) && (rpc[index] == observed_rpc)) {
+      if (conf[index] < conf_max)
+         conf[index]++;
+   }
+   else if (!pending_taken) {
+      // Only the not-taken path identifies the RPC; the taken path can only confirm it.
+      tag[index] = pending_pc;
+      rpc[index] = observed_rpc;
+      conf[index] = 0;
+   }
+}
+
+void reconv_predictor_t::train(uint64_t pc, uint64_t next_pc, uint64_t target, bool cond_branch, bool jump) {
+   if (pending) {
+      pending_count++;
+      if (pending_taken) {
+         // Taken path: confirm the RPC already in the entry.
+         if (pc == rpc[pending_index])
+            train_entry(true, pc);
+      }
+      else if (pc == pending_target) {
+         // Not-taken path fell through to the taken target: if-then.
+         train_entry(true, pc);
+      }
+      else if (jump && (pc > pending_pc) && (pc < pending_target) && (next_pc > pending_target)) {
+         // Not-taken path jumps over the taken path: if-then-else.
+         train_entry(true, next_pc);
+      }
+
+      if (pending && (pending_count >= window))
+         train_entry(false, 0);
+   }
+
+   // Start training a forward conditional branch.
+   if (!pending && cond_branch && (target > pc)) {
+      pending_index = ((pc >> 2) & (size - 1));
+      pending_pc = pc;
+      pending_target = target;
+      pending_taken = (next_pc == target);
+      pending_count = 0;
+
+      // A taken instance can only confirm an existing RPC.
+      pending = (!pending_taken || (tag[pending_index] == pc));
+   }
+}
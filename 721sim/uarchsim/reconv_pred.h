@@ -0,0 +1,85 @@
+#ifndef RECONV_PRED_H
+#define RECONV_PRED_H
+
+#include <cinttypes>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Reconvergence predictor for control-independent squash reuse.
+//
+// When a branch mispredicts, everything after it is squashed, including the
+// instructions after its reconvergence point (RPC). Those instructions are
+// control-independent: the correct path fetches them again. Instructions
+// among them that do not depend on the wrong path compute the same values a
+// second time.
+//
+// The predictor supplies the RPC of a forward conditional branch at pc P with
+// taken target T:
+// * The RPC is T for an if-then shape.
+// * If the not-taken path ends with a forward "jal x0, J" with J > T, the RPC
+//   is J (the if-then-else shape).
+//
+// Each entry has a PC tag, the RPC, and a resetting confidence counter. The
+// predictor is trained at retirement from the committed instruction stream.
+// The RPC is confirmed if the committed path reaches it within "window"
+// instructions.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class reconv_predictor_t {
+private:
+	uint64_t size;
+	uint64_t *tag;			// branch PC
+	uint64_t *rpc;			// reconvergence PC
+	uint8_t *conf;			// resetting confidence counters
+	uint8_t conf_max;
+	uint8_t conf_threshold;
+	uint64_t window;
+
+	// The committed branch that is currently being trained (one at a time: nested branches are skipped).
+	bool pending;
+	uint64_t pending_index;
+	uint64_t pending_pc;
+	uint64_t pending_target;	// taken target, T
+	bool pending_taken;
+	uint64_t pending_count;
+
+	void train_entry(bool reached, uint64_t observed_rpc);
+
+public:
+	reconv_predictor_t(uint64_t log2_size, uint64_t window, uint64_t conf_threshold);
+	~reconv_predictor_t();
+
+	// Look up the RPC of the branch at "pc".
+	// Returns true if there is a confident RPC, in which case it is returned in "rpc".
+	bool predict(uint64_t pc, uint64_t &rpc);
+
+	// Observe a committed instruction.
+	// "cond_branch": a conditional branch, with taken target "target".
+	// "jump": a direct jump that does not link (jal x0).
+	// "next_pc" is the PC of the next committed instruction.
+	void train(uint64_t pc, uint64_t next_pc, uint64_t target, bool cond_branch, bool jump);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// One squashed instruction after the RPC of a mispredicted branch.
+//
+// Instructions are recorded in program order. When the correct path reaches
+// the RPC, refetched instructions are matched in order against the record.
+// A reusable instruction whose source values still equal the recorded ones
+// does not execute again: the Dispatch Stage writes its recorded result.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+	uint64_t pc;
+	uint32_t bits;		// instruction bits (the result is a function of the instruction, its PC, and its source values)
+	bool reusable;		// integer ALU instruction that finished executing
+	uint64_t A_value;
+	uint64_t B_value;
+	uint64_t C_value;
+} ci_entry_t;
+
+#endif //RECONV_PRED_H
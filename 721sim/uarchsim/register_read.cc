@@ -73,8 +73,11 @@ void pipeline_t::register_read(unsigned int lane_number) {
          if(PAY.buf[index].A_valid==true)  PAY.buf[index].A_value.dw=REN->read(PAY.buf[index].A_phys_reg);
          if(PAY.buf[index].B_valid==true)  PAY.buf[index].B_value.dw=REN->read(PAY.buf[index].B_phys_reg);
          if(PAY.buf[index].D_valid==true)  PAY.buf[index].D_value.dw=REN->read(PAY.buf[index].D_phys_reg);
+         PAY.buf[index].src_read = true;
       // FIX_ME #12 END
 
+      release_sources(index);
+
       //////////////////////////////////////////////////////////////////////////////////////////////////////////
       // Advance the instruction to the Execution Stage.
       //////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -91,3 +94,19 @@ void pipeline_t::register_read(unsigned int lane_number) {
       Execution_Lanes[lane_number].rr.valid = false;
    }
 }
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Early register release: the instruction at 'index' no longer needs its source registers, either because
+// it read them, or because it completed or was squashed without reading them. The renamer may free a
+// source register once its last pending reader is done (see renamer.h, Structure 6c).
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+void pipeline_t::release_sources(unsigned int index) {
+   if (!PAY.buf[index].src_pending)
+      return;
+
+   PAY.buf[index].src_pending = false;
+   if (PAY.buf[index].A_valid) REN->read_done(PAY.buf[index].A_phys_reg);
+   if (PAY.buf[index].B_valid) REN->read_done(PAY.buf[index].B_phys_reg);
+   if (PAY.buf[index].D_valid) REN->read_done(PAY.buf[index].D_phys_reg);
+}
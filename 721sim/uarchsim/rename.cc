@@ -1,6 +1,45 @@
 #include "pipeline.h"
 
 
+////////////////////////////////////////////////////////////////////////////////////
+// Rename-time elimination (MOVE_ELIM, IDIOM_ELIM).
+//
+// Only instructions outside of hammocks (NORMAL) with a destination other than x0
+// are eliminated: the renamer does not log THEN/ELSE mappings (see renamer.h).
+////////////////////////////////////////////////////////////////////////////////////
+
+// A move: "addi rd, rs, 0" (mv).
+static bool is_move(payload_t &pay) {
+   return((pay.inst.opcode() == OP_OP_IMM) && (pay.inst.funct3() == 0) && (pay.inst.i_imm() == 0) &&
+          (pay.inst.rs1() != 0));
+}
+
+// A constant idiom: the result does not depend on the source values.
+// "addi rd, x0, imm" (li), "lui rd, imm", and "sub/subw/xor rd, rs, rs" (zero).
+static bool is_const_idiom(payload_t &pay, uint64_t &value) {
+   insn_t inst = pay.inst;
+   switch (inst.opcode()) {
+      case OP_OP_IMM:
+         value = inst.i_imm();
+         return((inst.funct3() == 0) && (inst.rs1() == 0));
+
+      case OP_LUI:
+         value = inst.u_imm();
+         return(true);
+
+      case OP_OP:
+      case OP_OP_32:
+         value = 0;
+         return((inst.rs1() == inst.rs2()) &&
+                (((inst.funct7() == 0x20) && (inst.funct3() == 0)) ||				// sub, subw
+                 ((inst.funct7() == 0) && (inst.funct3() == 4) && (inst.opcode() == OP_OP))));	// xor
+
+      default:
+         return(false);
+   }
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////
 // The Rename Stage has two sub-stages:
 // rename1: Get the next rename bundle from the FQ.
@@ -103,6 +142,7 @@ void pipeline_t::rename2() {
 
    // FIX_ME #2 BEGIN
       if(REN->stall_branch(bundle_branch)==true ||  REN->stall_reg(bundle_dst)==true)return;
+      if(REN->stall_undo(bundle_dst)==true)return;
    // FIX_ME #2 END
 
    //
@@ -146,10 +186,36 @@ void pipeline_t::rename2() {
          if(PAY.buf[index].D_valid ==true) {
             PAY.buf[index].D_phys_reg =REN->rename_rsrc(PAY.buf[index].D_log_reg,dhp_type); //For CMOV type??
          }
+
+         // Early register release: the source registers have one more pending reader (see release_sources()).
+         if (EARLY_RELEASE) {
+            if (PAY.buf[index].A_valid) REN->add_reader(PAY.buf[index].A_phys_reg);
+            if (PAY.buf[index].B_valid) REN->add_reader(PAY.buf[index].B_phys_reg);
+            if (PAY.buf[index].D_valid) REN->add_reader(PAY.buf[index].D_phys_reg);
+            PAY.buf[index].src_pending = true;
+         }
    
          
          if(PAY.buf[index].C_valid ==true) {
-             PAY.buf[index].C_phys_reg =REN->rename_rdst(PAY.buf[index].C_log_reg,dhp_type);
+             uint64_t value;
+             bool elim = ((PAY.buf[index].instruction_type == NORMAL) && (PAY.buf[index].C_log_reg != 0) && !PAY.buf[index].fused);
+
+             if (elim && MOVE_ELIM && is_move(PAY.buf[index])) {
+                // Eliminated move: the destination shares the source's physical register.
+                PAY.buf[index].move_elim = true;
+                PAY.buf[index].C_phys_reg = REN->rename_move(PAY.buf[index].C_log_reg, PAY.buf[index].A_phys_reg);
+                inc_counter(move_elim_count);
+             }
+             else {
+                PAY.buf[index].C_phys_reg =REN->rename_rdst(PAY.buf[index].C_log_reg,dhp_type);
+
+                // Eliminated constant idiom: the Dispatch Stage writes the value (see dispatch()).
+                if (elim && IDIOM_ELIM && is_const_idiom(PAY.buf[index], value)) {
+                   PAY.buf[index].const_elim = true;
+                   PAY.buf[index].C_value.dw = value;
+                   inc_counter(idiom_elim_count);
+                }
+             }
          }
       // FIX_ME #3 END
 
@@ -10,18 +10,18 @@
 // 1. The number of logical registers (e.g., 32).
 // 2. The number of physical registers (e.g., 128).
 // 3. The maximum number of unresolved branches.
-//    Requirement: 1 <= n_branches <= 64.
+//    Requirement: 1 <= n_branches <= BRANCH_MASK_BITS.
 //
 // Tips:
 //
 // Assert the number of physical registers > number logical registers.
-// Assert 1 <= n_branches <= 64.
+// Assert 1 <= n_branches <= BRANCH_MASK_BITS.
 // Then, allocate space for the primary data structures.
 // Then, initialize the data structures based on the knowledge
 // that the pipeline is intially empty (no in-flight instructions yet).
-renamer::renamer(uint64_t n_log_regs,uint64_t n_phys_regs,uint64_t n_branches){
+renamer::renamer(uint64_t n_log_regs,uint64_t n_phys_regs,uint64_t n_branches,bool move_elim,bool early_release){
    assert (n_phys_regs>n_log_regs);
-   assert (n_branches>=1 && n_branches<=64); 
+   assert (n_branches>=1 && n_branches<=BRANCH_MASK_BITS); 
    
    n_max_branches = n_branches; 
    n_logical_regs = n_log_regs;
@@ -42,12 +42,37 @@ renamer::renamer(uint64_t n_log_regs,uint64_t n_phys_regs,uint64_t n_branches){
    AMT_64 = n_log_regs;
    RMT_64 = n_log_regs;
 
-   FL        = new free_list_struct(n_phys_regs-n_log_regs-1);
+   this->move_elim = move_elim;
+   FL        = new free_list_struct(move_elim ? n_phys_regs : n_phys_regs-n_log_regs-1);
    for(uint i=0;i<n_phys_regs-n_log_regs-1;i++){
    FL->FL_Entry[i]=i+n_log_regs+1;
    
    //printf("Fl entry %d is %d \n",i,FL->FL_Entry[i]);
    }
+   if(move_elim){ // Free List has spare room: the free registers are head to tail.
+     FL->tail  = n_phys_regs-n_log_regs-1;
+     FL->empty = 0;
+   }
+
+   PRF_share = new uint[n_phys_regs];
+   for(uint i=0;i<n_phys_regs;i++)
+     PRF_share[i]=0;
+
+   assert(!(move_elim && early_release));
+   this->early_release = early_release;
+   early_release_cnt = 0;
+   PRF_readers   = new uint[n_phys_regs];
+   PRF_redefined = new bool[n_phys_regs];
+   PRF_written   = new bool[n_phys_regs];
+   PRF_released  = new bool[n_phys_regs];
+   PRF_saved     = new uint64_t[n_phys_regs];
+   for(uint i=0;i<n_phys_regs;i++){
+     PRF_readers[i]=0;
+     PRF_redefined[i]=false;
+     PRF_written[i]=true;
+     PRF_released[i]=false;
+     PRF_saved[i]=0;
+   }
    
    AL        = new active_list_struct(n_phys_regs-n_log_regs); 
 
@@ -64,11 +89,90 @@ renamer::renamer(uint64_t n_log_regs,uint64_t n_phys_regs,uint64_t n_branches){
    
     
 
-   GBM       = 0;
+   GBM.reset();
 
    branch_checkpoint = new  branch_checkpoint_struct[n_branches];
-   for(int i=0;i<n_branches;i++)
-      branch_checkpoint[i]=branch_checkpoint_struct(n_log_regs);
+
+   undo_log_size = n_phys_regs-n_log_regs;
+   undo_log  = new undo_log_entry[undo_log_size];
+   undo_tail = 0;
+   undo_head = 0;
+
+   te_list   = new uint[n_log_regs];
+   te_count  = 0;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Log the old mapping of log_reg before it is overwritten.
+// Nothing to log if there is no unresolved branch to recover to.
+/////////////////////////////////////////////////////////////////////
+void renamer::log_rmt_write(uint log_reg, uint old_phy_reg, bool shared){
+  if(!GBM.any()) return;
+  undo_log[undo_tail % undo_log_size].log_reg = log_reg;
+  undo_log[undo_tail % undo_log_size].phy_reg = old_phy_reg;
+  undo_log[undo_tail % undo_log_size].shared = shared;
+  undo_tail++;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Release a physical register: push it onto the Free List, unless
+// other mappings still share it (move elimination).
+/////////////////////////////////////////////////////////////////////
+void renamer::free_reg(uint phys_reg){
+  if(PRF_share[phys_reg]>0){
+    PRF_share[phys_reg]--;
+    return;
+  }
+  if(PRF_released[phys_reg]){ // already freed early (see try_release())
+    PRF_released[phys_reg]=false;
+    return;
+  }
+  PRF_redefined[phys_reg]=false;
+  fl_push(phys_reg);
+}
+
+/////////////////////////////////////////////////////////////////////
+// Push a physical register onto the tail of the Free List.
+/////////////////////////////////////////////////////////////////////
+void renamer::fl_push(uint phys_reg){
+  FL->FL_Entry[FL->tail] = phys_reg;
+  if(FL->full==1) FL->full=0;
+  if(FL->head-FL->tail == 1 || ((FL->tail == FL->size -1)&&(FL->head==0))) FL->empty=1; 
+  if(FL->tail == FL->size-1) FL->tail=0; else FL->tail++; 
+}
+
+/////////////////////////////////////////////////////////////////////
+// Early register release: the logical register mapped to phys_reg
+// was redefined by an instruction that is not speculative.
+/////////////////////////////////////////////////////////////////////
+void renamer::redefine(uint phys_reg){
+  PRF_redefined[phys_reg]=true;
+  try_release(phys_reg);
+}
+
+/////////////////////////////////////////////////////////////////////
+// Early register release: free phys_reg if it is redefined, read by
+// all of its consumers, and written (see Structure 6c).
+/////////////////////////////////////////////////////////////////////
+void renamer::try_release(uint phys_reg){
+  if(PRF_redefined[phys_reg] && (PRF_readers[phys_reg]==0) && PRF_written[phys_reg] && !PRF_released[phys_reg]){
+    PRF_redefined[phys_reg]=false;
+    PRF_released[phys_reg]=true;
+    PRF_saved[phys_reg]=PRF[phys_reg];
+    early_release_cnt++;
+    fl_push(phys_reg);
+  }
+}
+
+/////////////////////////////////////////////////////////////////////
+// Invalidate all THEN/ELSE mappings.
+/////////////////////////////////////////////////////////////////////
+void renamer::clear_te_valid(){
+  for(uint i=0;i<te_count;i++){
+    RMT[te_list[i]].t_valid = false;
+    RMT[te_list[i]].e_valid = false;
+  }
+  te_count = 0;
 }
 //////////////////////////////////////////
 // Functions related to Rename Stage.   //
@@ -106,26 +210,36 @@ bool renamer::stall_reg(uint64_t bundle_dst){
 // for all branches in the current rename bundle.
 /////////////////////////////////////////////////////////////////////
 bool renamer::stall_branch(uint64_t bundle_branch){
-  uint64_t free_entries=0;
-  uint64_t pos=0;
-  uint64_t mask=1;
-
-  while(pos<n_max_branches){
-   if((~GBM & mask) == mask)
-     free_entries++;
-   mask = mask<<1;
-   pos++;
-  }
+  uint64_t free_entries = n_max_branches - GBM.count();
 
   if(free_entries>=bundle_branch) return false;
   else return true; 
   //return false;
 }
 
+/////////////////////////////////////////////////////////////////////
+// The Rename Stage must stall if the undo log doesn't have room for
+// the RMT writes of the current rename bundle.
+//
+// The live part of the log starts at the oldest checkpoint of an
+// unresolved branch (or, with early release, at undo_head if older).
+/////////////////////////////////////////////////////////////////////
+bool renamer::stall_undo(uint64_t bundle_dst){
+  uint64_t pos=undo_tail;
+
+  if(!GBM.any()) return false;  // nothing is logged without an unresolved branch
+  for(uint GBM_pos=GBM.next_one(0);GBM_pos<BRANCH_MASK_BITS;GBM_pos=GBM.next_one(GBM_pos+1))
+    if(branch_checkpoint[GBM_pos].undo_pos<pos) pos=branch_checkpoint[GBM_pos].undo_pos;
+  if(early_release && (undo_head<pos)) pos=undo_head;
+
+  if((undo_tail-pos+bundle_dst)<=undo_log_size) return false;
+  else return true;
+}
+
 /////////////////////////////////////////////////////////////////////
 // This function is used to get the branch mask for an instruction.
 /////////////////////////////////////////////////////////////////////
-uint64_t renamer::get_branch_mask(){
+branch_mask_t renamer::get_branch_mask(){
   return GBM;
 }
 
@@ -188,25 +302,31 @@ uint64_t renamer::rename_rdst(uint64_t log_reg,instruction_dhp_e dhp_type){
  phy_reg = FL->FL_Entry[FL->head];
  if(dhp_type == NORMAL_TYPE || dhp_type == CMOV_TYPE){
    if(log_reg == 64 && dhp_type == NORMAL_TYPE){
+     log_rmt_write(64, RMT_64, false);
      RMT_64 = phy_reg;
       //printf(" rename_dst::New RMT_value is:%d\n",RMT_64);
-      for(uint i=0;i<n_logical_regs;i++){
-       RMT[i].e_valid = false;
-       RMT[i].t_valid = false; 
-      }
+      clear_te_valid();
    }  
-   else
+   else {
+     log_rmt_write(log_reg, RMT[log_reg].phy_reg, false);
+     if(early_release && !GBM.any()) redefine(RMT[log_reg].phy_reg);
      RMT[log_reg].phy_reg= phy_reg;
+   }
  }
  else if(dhp_type == THEN_TYPE){
+   if(!RMT[log_reg].t_valid && !RMT[log_reg].e_valid) te_list[te_count++] = log_reg;
    RMT[log_reg].t_phy_reg = phy_reg;
    RMT[log_reg].t_valid = true;
  }
  else if(dhp_type == ELSE_TYPE){
+   if(!RMT[log_reg].t_valid && !RMT[log_reg].e_valid) te_list[te_count++] = log_reg;
    RMT[log_reg].e_phy_reg= phy_reg;
    RMT[log_reg].e_valid = true;
  }  
  //PRF_ready[phy_reg]=false;
+ PRF_readers[phy_reg]=0;
+ PRF_redefined[phy_reg]=false;
+ PRF_written[phy_reg]=false;
  //check full condition
  if(FL->empty ==1) FL->empty=0; 
  if(FL->tail-FL->head == 1 || ((FL->head == FL->size -1)&&(FL->tail==0)) ) FL->full=1; else FL->full=0; 
@@ -216,6 +336,18 @@ uint64_t renamer::rename_rdst(uint64_t log_reg,instruction_dhp_e dhp_type){
  return phy_reg;
 }
 
+/////////////////////////////////////////////////////////////////////
+// Move elimination: map log_reg to the move's source register,
+// phys_reg, which gains a sharer. No Free List entry is allocated.
+/////////////////////////////////////////////////////////////////////
+uint64_t renamer::rename_move(uint64_t log_reg,uint64_t phys_reg){
+ assert(move_elim && (log_reg < n_logical_regs));
+ log_rmt_write(log_reg, RMT[log_reg].phy_reg, true);
+ RMT[log_reg].phy_reg = phys_reg;
+ PRF_share[phys_reg]++;
+ return phys_reg;
+}
+
 /////////////////////////////////////////////////////////////////////
 // This function creates a new branch checkpoint.
 //
@@ -236,30 +368,16 @@ uint64_t renamer::rename_rdst(uint64_t log_reg,instruction_dhp_e dhp_type){
 // * Use the branch checkpoint that corresponds to this bit.
 // 
 // The branch checkpoint should contain the following:
-// 1. Shadow Map Table (checkpointed Rename Map Table)
+// 1. undo log position (see Structure 8 in renamer.h)
 // 2. checkpointed Free List head index
 // 3. checkpointed GBM
 /////////////////////////////////////////////////////////////////////
 uint64_t renamer::checkpoint(){
-  uint64_t pos=0;
-  uint64_t mask=1;
-  bool found=false;
-  while(pos<n_max_branches){
-   if((~GBM & mask) == mask){found=true;break;}
-   mask = mask<<1;
-   pos++;
-  }
-  if(found==true) GBM = GBM| 1<<pos;
+  uint64_t pos=GBM.first_zero(n_max_branches);
+  if(pos<n_max_branches) GBM.set(pos);
   else printf("No empty check point found\n"); 
 
-  for(int i=0;i<n_logical_regs;i++){
-    branch_checkpoint[pos].RMT[i].phy_reg=RMT[i].phy_reg;
-    branch_checkpoint[pos].RMT[i].t_valid=false; 
-    branch_checkpoint[pos].RMT[i].t_valid=false;
-    branch_checkpoint[pos].RMT_64=RMT_64;
-
-  }  
-  
+  branch_checkpoint[pos].undo_pos= undo_tail;
   branch_checkpoint[pos].GBM= GBM;
   branch_checkpoint[pos].freelist_head= FL->head;
   //printf("check point is %d\n",pos);
@@ -327,7 +445,8 @@ uint64_t renamer::dispatch_inst(bool dest_valid,
                        bool csr,
                        uint64_t PC,
                        instruction_dhp_e instruction_type,
-                       bool is_hammock   
+                       bool is_hammock,
+                       bool shared_dest
                        ){
      uint64_t instr_idx;
      //printf("AL tail value is: %d\n",AL->tail);
@@ -362,7 +481,7 @@ uint64_t renamer::dispatch_inst(bool dest_valid,
      //}
      
       
-     if(dest_valid==1) PRF_ready[phys_reg]=false;
+     if(dest_valid==1 && !shared_dest) PRF_ready[phys_reg]=false;
      instr_idx =AL->tail;
 
      //check full condition
@@ -423,6 +542,28 @@ uint64_t renamer::read(uint64_t phys_reg){
 /////////////////////////////////////////////////////////////////////
 void renamer::write(uint64_t phys_reg, uint64_t value){
   PRF[phys_reg]= value;
+  PRF_written[phys_reg]=true;
+  if(early_release) try_release(phys_reg);
+}
+
+void renamer::write_prediction(uint64_t phys_reg, uint64_t value){
+  PRF[phys_reg]= value;
+}
+
+/////////////////////////////////////////////////////////////////////
+// Early register release: count the pending reads of a register.
+/////////////////////////////////////////////////////////////////////
+void renamer::add_reader(uint64_t phys_reg){
+  PRF_readers[phys_reg]++;
+}
+
+void renamer::read_done(uint64_t phys_reg){
+  if(PRF_readers[phys_reg]>0) PRF_readers[phys_reg]--;
+  try_release(phys_reg);
+}
+
+uint64_t renamer::get_early_release_count(){
+  return early_release_cnt;
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -505,12 +646,26 @@ void renamer::resolve(uint64_t AL_index,
 	     bool correct){
 
      if(correct==true){
-          for(int GBM_pos=0;GBM_pos<n_max_branches;GBM_pos++)
-            branch_checkpoint[GBM_pos].GBM = branch_checkpoint[GBM_pos].GBM & ~(1<<branch_ID);
-          GBM = GBM & ~(1<<branch_ID);
+          // Only the checkpoints of unresolved branches (GBM bits) are live.
+          for(uint GBM_pos=GBM.next_one(0);GBM_pos<BRANCH_MASK_BITS;GBM_pos=GBM.next_one(GBM_pos+1))
+            branch_checkpoint[GBM_pos].GBM.clear(branch_ID);
+          GBM.clear(branch_ID);
+
+          // Early register release: the RMT writes older than all
+          // remaining unresolved branches are no longer speculative.
+          if(early_release){
+            uint64_t pos=undo_tail;
+            for(uint GBM_pos=GBM.next_one(0);GBM_pos<BRANCH_MASK_BITS;GBM_pos=GBM.next_one(GBM_pos+1))
+              if(branch_checkpoint[GBM_pos].undo_pos<pos) pos=branch_checkpoint[GBM_pos].undo_pos;
+            for(;undo_head<pos;undo_head++){
+              undo_log_entry &entry = undo_log[undo_head % undo_log_size];
+              if(entry.log_reg != 64) redefine(entry.phy_reg);
+            }
+          }
      }
      else{
-          GBM = branch_checkpoint[branch_ID].GBM &  ~(1<<branch_ID);
+          GBM = branch_checkpoint[branch_ID].GBM;
+          GBM.clear(branch_ID);
           FL->head = branch_checkpoint[branch_ID].freelist_head;
           //printf("head of free list is %d,tail is %d\n",FL->head,FL->tail);
           //printf("resolve::Fl empty is %d, head is %d,tail is %d,FL->size is %d\n",FL->empty,FL->head,FL->tail,FL->free_space());
@@ -520,10 +675,19 @@ void renamer::resolve(uint64_t AL_index,
           //if(FL->head-FL->tail == 1 || ((FL->tail == FL->size -1)&&(FL->head==0))) FL->empty=1; else FL->empty=0;
           //if(FL->tail-FL->head == 1 || ((FL->head == FL->size -1)&&(FL->tail==0))) FL->full=1;else FL->full=0; 
 
-          for(int i=0;i<n_logical_regs;i++)
-             RMT[i]= branch_checkpoint[branch_ID].RMT[i]; 
-
-           RMT_64 = branch_checkpoint[branch_ID].RMT_64;  
+          // Unwind the RMT writes made after the checkpoint, youngest first.
+          // The THEN/ELSE mappings are invalid in the restored RMT.
+          assert(undo_tail - branch_checkpoint[branch_ID].undo_pos <= undo_log_size);
+          while(undo_tail > branch_checkpoint[branch_ID].undo_pos){
+             undo_tail--;
+             undo_log_entry &entry = undo_log[undo_tail % undo_log_size];
+             if(entry.log_reg == 64) RMT_64 = entry.phy_reg;
+             else {
+               if(entry.shared) PRF_share[RMT[entry.log_reg].phy_reg]--; // squashed eliminated move
+               RMT[entry.log_reg].phy_reg = entry.phy_reg;
+             }
+          }
+          clear_te_valid();
 
           if(AL_index==(AL->size-1)) AL->tail = 0; else AL->tail =AL_index+1;
           if(AL->head == AL->tail && AL->full==1){}
@@ -537,6 +701,46 @@ void renamer::resolve(uint64_t AL_index,
      }  
 }
 
+/////////////////////////////////////////////////////////////////////
+// Selective recovery: see renamer.h.
+/////////////////////////////////////////////////////////////////////
+void renamer::deactivate(uint64_t AL_index){
+   AL->AL_Entry[AL_index].deactivated = true;
+}
+
+uint64_t renamer::get_logged_mapping(uint64_t branch_ID, uint64_t k, uint64_t log_reg){
+   uint64_t pos = branch_checkpoint[branch_ID].undo_pos + k;
+   assert(pos < undo_tail);
+   assert(undo_log[pos % undo_log_size].log_reg == log_reg);
+   return undo_log[pos % undo_log_size].phy_reg;
+}
+
+void renamer::squash_writes(uint64_t branch_ID, uint64_t n){
+   uint64_t start = branch_checkpoint[branch_ID].undo_pos;
+   uint64_t end = start + n;
+   uint64_t i, j;
+
+   assert(end <= undo_tail);
+
+   // Youngest first, so that the oldest squashed write of a register
+   // (the mapping from before all of them) is the one that remains.
+   for(i=end;i>start;i--){
+     undo_log_entry &entry = undo_log[(i-1) % undo_log_size];
+     assert(!entry.shared && (entry.log_reg != 64));
+     for(j=end;j<undo_tail;j++)
+       if(undo_log[j % undo_log_size].log_reg == entry.log_reg) break;
+     if(j<undo_tail) undo_log[j % undo_log_size].phy_reg = entry.phy_reg;
+     else RMT[entry.log_reg].phy_reg = entry.phy_reg;
+   }
+
+   // Close the gap in the log.
+   for(j=end;j<undo_tail;j++)
+     undo_log[(j-n) % undo_log_size] = undo_log[j % undo_log_size];
+   undo_tail -= n;
+   for(uint GBM_pos=GBM.next_one(0);GBM_pos<BRANCH_MASK_BITS;GBM_pos=GBM.next_one(GBM_pos+1))
+     if(branch_checkpoint[GBM_pos].undo_pos>=end) branch_checkpoint[GBM_pos].undo_pos -= n;
+}
+
 //////////////////////////////////////////
 // Functions related to Retire Stage.   //
 //////////////////////////////////////////
@@ -636,20 +840,17 @@ assert(AL->AL_Entry[AL->head].load_violation==false);
         if(dest_logic_reg == 64){
           old_phy_reg = AMT_64;
           AMT_64 = AL->AL_Entry[AL->head].dest_phy_reg;
-          FL->FL_Entry[FL->tail] = old_phy_reg; //commiting the new dest phy reg
+          free_reg(old_phy_reg); //commiting the new dest phy reg
         }
         else{
           old_phy_reg = AMT[dest_logic_reg]; //retrieving old phy dest reg for logical reg
           AMT[dest_logic_reg] = AL->AL_Entry[AL->head].dest_phy_reg; //commiting the new dest phy reg
-          FL->FL_Entry[FL->tail] = old_phy_reg; //adding the old dest phy reg into free_list
+          free_reg(old_phy_reg); //adding the old dest phy reg into free_list
         }
         //printf("new fl_entry at tail %d is :%d\n",FL->tail,FL->FL_Entry[FL->tail]);
       }
-      else FL->FL_Entry[FL->tail] = AL->AL_Entry[AL->head].dest_phy_reg; 
+      else free_reg(AL->AL_Entry[AL->head].dest_phy_reg); 
 
-      if(FL->full==1) FL->full=0;
-      if(FL->head-FL->tail == 1 || ((FL->tail == FL->size -1)&&(FL->head==0))) FL->empty=1; 
-      if(FL->tail == FL->size-1) FL->tail=0; else FL->tail++; 
       //printf("commit::Fl empty is %d, head is %d,tail is %d,FL->size is %d\n",FL->empty,FL->head,FL->tail,FL->free_space());
    } 
    else {//printf("no valid destination at head :%d\n",AL->head);
@@ -678,6 +879,7 @@ void renamer::squash(){
      RMT[i].t_valid=false;
      RMT[i].e_valid=false;
     }
+    te_count = 0;
     AL->tail= AL->head;
     FL->head= FL->tail; 
     
@@ -685,7 +887,41 @@ void renamer::squash(){
     FL->empty=1;
     AL->full=0;
     FL->full=0;
-    GBM =0; 
+    GBM.reset(); 
+
+    undo_head=undo_tail;
+
+    // With move elimination or early release, the Free List is rebuilt
+    // from the AMT: a register is free if no committed mapping refers to it.
+    // A register in the AMT that was released early gets its value back.
+    if(move_elim || early_release){
+      for(uint i=0;i<n_logical_regs;i++){
+        if(PRF_released[AMT[i]]){
+          PRF[AMT[i]]=PRF_saved[AMT[i]];
+          PRF_ready[AMT[i]]=true;
+        }
+      }
+      for(uint i=0;i<n_physical_regs;i++){
+        PRF_readers[i]=0;
+        PRF_redefined[i]=false;
+        PRF_written[i]=true;
+        PRF_released[i]=false;
+      }
+      for(uint i=0;i<n_physical_regs;i++)
+        PRF_share[i]=0;
+      bool *mapped = new bool[n_physical_regs]();
+      for(uint i=0;i<n_logical_regs;i++){
+        if(mapped[AMT[i]]) PRF_share[AMT[i]]++;
+        mapped[AMT[i]]=true;
+      }
+      mapped[AMT_64]=true;
+      FL->head=0;
+      FL->tail=0;
+      for(uint i=0;i<n_physical_regs;i++)
+        if(!mapped[i]) FL->FL_Entry[FL->tail++]=i;
+      if(FL->tail==FL->size) FL->tail=0; else FL->empty=0;
+      delete [] mapped;
+    }
     //printf("squash function called\n");
 
 }
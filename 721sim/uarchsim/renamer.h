@@ -1,5 +1,6 @@
 #include <inttypes.h>
 #include <assert.h>
+#include "branch_mask.h"
 //#include "pipeline.h"
 //#include "fetchunit_types.h"
 typedef unsigned int uint;
@@ -120,17 +121,22 @@ class active_list_struct{
     
 };
 
+// One RMT write: the mapping of log_reg before the write.
+// Logical register 64 (the predicate) refers to RMT_64.
+// If shared, the write was an eliminated move (see rename_move()).
+typedef struct undo_log_entry {
+  uint log_reg;
+  uint phy_reg;
+  bool shared;
+}undo_log_entry;
+
 typedef struct branch_checkpoint_struct{
-  RMT_struct *RMT;
+  uint64_t undo_pos;    // undo log position when the checkpoint was taken
   uint freelist_head;
-  uint64_t GBM; 
-  uint RMT_64;
-  branch_checkpoint_struct(){}
-  branch_checkpoint_struct(uint64_t n_log_regs){
-     RMT = new RMT_struct[n_log_regs];
-     GBM = 0;
+  branch_mask_t GBM; 
+  branch_checkpoint_struct(){
+     undo_pos = 0;
      freelist_head = 0; 
-	 RMT_64 =0;
   }
 }branch_checkpoint_struct;
 
@@ -222,6 +228,56 @@ private:
 	/////////////////////////////////////////////////////////////////////
 	bool *PRF_ready;
 
+	/////////////////////////////////////////////////////////////////////
+	// Structure 6b: Physical Register Sharing Counts (move elimination)
+	// Entry contains: number of additional mappings of the register,
+	// i.e., eliminated moves that map their destination to it.
+	//
+	// A physical register is pushed onto the Free List only when it
+	// is released with a count of 0; otherwise the count is decremented.
+	// Without move elimination, all counts stay 0.
+	//
+	// Since a shared register stands for more than one logical register,
+	// more registers can be free at once than without sharing. With
+	// move elimination, the Free List has room for all physical registers.
+	/////////////////////////////////////////////////////////////////////
+	uint *PRF_share;
+	bool move_elim;
+
+	/////////////////////////////////////////////////////////////////////
+	// Structure 6c: Early Register Release
+	//
+	// Normally, a physical register is freed when the instruction that
+	// redefines its logical register commits. With early release, it is
+	// freed as soon as all of the following are true:
+	// 1. PRF_redefined: its logical register was redefined, and the
+	//    redefining instruction is not speculative w.r.t. any branch
+	//    (there was no unresolved branch older than it).
+	// 2. PRF_readers == 0: all consumers renamed to the register have
+	//    read it (see add_reader() and read_done()).
+	// 3. PRF_written: its producer wrote it.
+	//
+	// PRF_released is set when a register is freed early: the commit
+	// that would have freed it only clears the flag. A register with
+	// a pending PRF_released flag is not released early again.
+	//
+	// An exception may still squash the redefining instruction after
+	// the register was freed. For this, the value of an early-released
+	// register is saved in PRF_saved: squash() restores the registers
+	// in the AMT that were released early.
+	//
+	// Only NORMAL and CMOV writes of the RMT (phy_reg) redefine a
+	// register. Predicate registers (logical register 64) and the
+	// THEN/ELSE mappings are only freed at commit.
+	/////////////////////////////////////////////////////////////////////
+	uint *PRF_readers;
+	bool *PRF_redefined;
+	bool *PRF_written;
+	bool *PRF_released;
+	uint64_t *PRF_saved;
+	bool early_release;
+	uint64_t early_release_cnt;
+
 	/////////////////////////////////////////////////////////////////////
 	// Structure 7: Global Branch Mask (GBM)
 	//
@@ -250,27 +306,51 @@ private:
 	//    the GBM when the instruction is renamed.
 	//
 	// The simulator requires an efficient implementation of bit vectors,
-	// for quick copying and manipulation of bit vectors. Therefore, you
-	// must implement the GBM as type "uint64_t".
-	// (#include <inttypes.h>, already at top of this file)
-	// The "uint64_t" type contains 64 bits, therefore, the simulator
-	// cannot support a processor configuration with more than 64
+	// for quick copying and manipulation of bit vectors. Therefore, the
+	// GBM is a fixed-width branch mask (see branch_mask.h) of
+	// BRANCH_MASK_BITS bits (64 by default), and the simulator cannot
+	// support a processor configuration with more than BRANCH_MASK_BITS
 	// unresolved branches. The maximum number of unresolved branches
 	// is configurable by the user of the simulator, and can range from
-	// 1 to 64.
+	// 1 to BRANCH_MASK_BITS.
 	/////////////////////////////////////////////////////////////////////
-	uint64_t GBM;
+	branch_mask_t GBM;
 
 	/////////////////////////////////////////////////////////////////////
 	// Structure 8: Branch Checkpoints
 	//
 	// Each branch checkpoint contains the following:
-	// 1. Shadow Map Table (checkpointed Rename Map Table)
+	// 1. undo log position (instead of a Shadow Map Table)
 	// 2. checkpointed Free List head index
 	// 3. checkpointed GBM
+	//
+	// The RMT is not copied. Instead, every write to an RMT mapping
+	// (phy_reg, or RMT_64) logs the old mapping in the undo log, and
+	// recovery unwinds the log back to the checkpoint's position.
+	// Only the mappings written after the branch are restored.
+	//
+	// The log is circular and its positions increase monotonically.
+	// The log never needs more entries than the Active List: every
+	// write after an unresolved branch is made by an instruction
+	// (at most one write each) that stays in-flight until the branch
+	// resolves. An eliminated move writes a mapping without allocating
+	// a physical register, so the Free List size is not a bound. Moves
+	// that are renamed but not yet dispatched are not in the Active List
+	// either, so the Rename Stage stalls when the log has no room for
+	// the bundle (see stall_undo()).
+	//
+	// The THEN/ELSE mappings (t_valid/e_valid) are never restored,
+	// only invalidated. The registers that have one of them set are
+	// kept in te_list, so they can be invalidated without a scan of the RMT.
 	/////////////////////////////////////////////////////////////////////
 
         branch_checkpoint_struct *branch_checkpoint;
+        undo_log_entry *undo_log;
+        uint64_t undo_log_size;
+        uint64_t undo_tail;
+        uint64_t undo_head;	// early release: writes before undo_head are not speculative
+        uint *te_list;
+        uint te_count;
         //local_variables
         uint64_t n_max_branches ; 
         uint64_t n_logical_regs ;
@@ -282,6 +362,12 @@ private:
 	// Private functions.
 	// e.g., a generic function to copy state from one map to another.
 	/////////////////////////////////////////////////////////////////////
+        void log_rmt_write(uint log_reg, uint old_phy_reg, bool shared);
+        void clear_te_valid();
+        void free_reg(uint phys_reg);
+        void fl_push(uint phys_reg);
+        void redefine(uint phys_reg);
+        void try_release(uint phys_reg);
 
 public:
 	////////////////////////////////////////
@@ -294,17 +380,20 @@ public:
 	// 1. The number of logical registers (e.g., 32).
 	// 2. The number of physical registers (e.g., 128).
 	// 3. The maximum number of unresolved branches.
-	//    Requirement: 1 <= n_branches <= 64.
+	//    Requirement: 1 <= n_branches <= BRANCH_MASK_BITS.
+	// 4. Whether or not move elimination (rename_move()) is used.
+	// 5. Whether or not physical registers are released early
+	//    (see Structure 6c). Not with move elimination.
 	//
 	// Tips:
 	//
 	// Assert the number of physical registers > number logical registers.
-	// Assert 1 <= n_branches <= 64.
+	// Assert 1 <= n_branches <= BRANCH_MASK_BITS.
 	// Then, allocate space for the primary data structures.
 	// Then, initialize the data structures based on the knowledge
 	// that the pipeline is intially empty (no in-flight instructions yet).
 	/////////////////////////////////////////////////////////////////////
-	renamer(uint64_t n_log_regs,uint64_t n_phys_regs,uint64_t n_branches);
+	renamer(uint64_t n_log_regs,uint64_t n_phys_regs,uint64_t n_branches,bool move_elim=false,bool early_release=false);
 
 	/////////////////////////////////////////////////////////////////////
 	// This is the destructor, used to clean up memory space and
@@ -348,10 +437,24 @@ public:
 	/////////////////////////////////////////////////////////////////////
 	bool stall_branch(uint64_t bundle_branch);
 
+	/////////////////////////////////////////////////////////////////////
+	// The Rename Stage must stall if the undo log doesn't have room for
+	// the RMT writes of the current rename bundle (one per logical
+	// destination register, see Structure 8).
+	//
+	// Inputs:
+	// 1. bundle_dst: number of logical destination registers in
+	//    current rename bundle
+	//
+	// Return value:
+	// Return "true" (stall) if the undo log may overflow.
+	/////////////////////////////////////////////////////////////////////
+	bool stall_undo(uint64_t bundle_dst);
+
 	/////////////////////////////////////////////////////////////////////
 	// This function is used to get the branch mask for an instruction.
 	/////////////////////////////////////////////////////////////////////
-	uint64_t get_branch_mask();
+	branch_mask_t get_branch_mask();
 
 	/////////////////////////////////////////////////////////////////////
 	// This function is used to rename a single source register.
@@ -373,6 +476,19 @@ public:
 	/////////////////////////////////////////////////////////////////////
 	//uint64_t rename_rdst(uint64_t log_reg);
     uint64_t rename_rdst(uint64_t log_reg,instruction_dhp_e dhp_type);
+
+	/////////////////////////////////////////////////////////////////////
+	// Move elimination: rename the destination register of a move
+	// (NORMAL_TYPE only) to the physical register of its source,
+	// instead of allocating a free physical register.
+	//
+	// Inputs:
+	// 1. log_reg: the logical destination register
+	// 2. phys_reg: the physical register of the move's source
+	//
+	// Return value: physical register name (phys_reg)
+	/////////////////////////////////////////////////////////////////////
+    uint64_t rename_move(uint64_t log_reg,uint64_t phys_reg);
 	/////////////////////////////////////////////////////////////////////
 	// This function creates a new branch checkpoint.
 	//
@@ -393,7 +509,7 @@ public:
 	// * Use the branch checkpoint that corresponds to this bit.
 	// 
 	// The branch checkpoint should contain the following:
-	// 1. Shadow Map Table (checkpointed Rename Map Table)
+	// 1. undo log position (see Structure 8)
 	// 2. checkpointed Free List head index
 	// 3. checkpointed GBM
 	/////////////////////////////////////////////////////////////////////
@@ -435,6 +551,8 @@ public:
 	// 7. amo: If 'true', this is an atomic memory operation.
 	// 8. csr: If 'true', this is a system instruction.
 	// 9. PC: Program counter of the instruction.
+	// 10. shared_dest: the destination was renamed by rename_move(),
+	//    so its ready bit belongs to the move's source and is not cleared.
 	//
 	// Return value:
 	// Return the instruction's index in the Active List.
@@ -456,7 +574,8 @@ public:
 	                       bool csr,
 	                       uint64_t PC,
 			       instruction_dhp_e instruction_type,
-                               bool is_dispatch  
+                               bool is_dispatch,
+                               bool shared_dest=false
 						   );
 
 
@@ -490,6 +609,16 @@ public:
 	/////////////////////////////////////////////////////////////////////
 	uint64_t read(uint64_t phys_reg);
 
+	/////////////////////////////////////////////////////////////////////
+	// Early register release (see Structure 6c).
+	// add_reader(): a consumer was renamed to the indicated register.
+	// read_done(): the consumer read it, or no longer needs to
+	// (e.g., it was squashed).
+	/////////////////////////////////////////////////////////////////////
+	void add_reader(uint64_t phys_reg);
+	void read_done(uint64_t phys_reg);
+	uint64_t get_early_release_count();
+
 
 	//////////////////////////////////////////
 	// Functions related to Writeback Stage.//
@@ -500,6 +629,13 @@ public:
 	/////////////////////////////////////////////////////////////////////
 	void write(uint64_t phys_reg, uint64_t value);
 
+	/////////////////////////////////////////////////////////////////////
+	// Write a predicted value into the indicated physical register.
+	// Unlike write(), the register still waits for its producer's write
+	// before it can be released early (see Structure 6c).
+	/////////////////////////////////////////////////////////////////////
+	void write_prediction(uint64_t phys_reg, uint64_t value);
+
 	/////////////////////////////////////////////////////////////////////
 	// Set the completed bit of the indicated entry in the Active List.
 	/////////////////////////////////////////////////////////////////////
@@ -554,6 +690,28 @@ public:
         //This function sets the de-activate bit in active list
         void predicate_done(uint64_t AL_index,uint64_t predication_tag,bool predicate_outcome);
 
+	/////////////////////////////////////////////////////////////////////
+	// Selective recovery of a mispredicted branch, which squashes only
+	// its wrong-path instructions before the reconvergence point (see
+	// pipeline_t::ci_recover()). Each of them made at most one RMT write,
+	// logged right after the branch's checkpoint (see Structure 8).
+	//
+	// deactivate(): the squashed instruction stays in the Active List,
+	// but its commit frees its destination register instead of
+	// updating the AMT (like a deactivated THEN/ELSE instruction).
+	//
+	// get_logged_mapping(): the mapping of log_reg that was overwritten
+	// by the k'th RMT write after the branch's checkpoint.
+	//
+	// squash_writes(): remove the first n RMT writes after the branch's
+	// checkpoint. The next write of the same logical register then
+	// overwrites the mapping from before them; if there is none, the
+	// RMT gets that mapping back.
+	/////////////////////////////////////////////////////////////////////
+	void deactivate(uint64_t AL_index);
+	uint64_t get_logged_mapping(uint64_t branch_ID, uint64_t k, uint64_t log_reg);
+	void squash_writes(uint64_t branch_ID, uint64_t n);
+
 
 	//////////////////////////////////////////
 	// Functions related to Retire Stage.   //
@@ -0,0 +1,285 @@
+#include <cinttypes>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "repl_policy.h"
+
+static const char *repl_policy_names[NUM_REPL_POLICIES] = {"lru", "plru", "srrip", "brrip", "drrip"};
+
+repl_policy_t::repl_policy_t(uint64_t sets, uint64_t assoc) {
+   assert((sets > 0) && (assoc > 0));
+   this->sets = sets;
+   this->assoc = assoc;
+}
+
+repl_policy_t::~repl_policy_t() {
+}
+
+repl_policy_t *repl_policy_t::create(repl_policy_e policy, uint64_t sets, uint64_t assoc) {
+   repl_policy_t *p = NULL;
+
+   switch (policy) {
+      case REPL_LRU:
+         p = new lru_repl_t(sets, assoc);
+         break;
+
+      case REPL_PLRU:
+         if (assoc & (assoc - 1)) {
+            fprintf(stderr, "The plru replacement policy requires a power-of-two associativity (associativity is %lu).\n", assoc);
+            exit(-1);
+         }
+         p = new plru_repl_t(sets, assoc);
+         break;
+
+      case REPL_SRRIP:
+      case REPL_BRRIP:
+      case REPL_DRRIP:
+         p = new rrip_repl_t(policy, sets, assoc);
+         break;
+
+      default:
+         assert(0);
+         break;
+   }
+
+   p->reset();
+   return(p);
+}
+
+const char *repl_policy_t::name(repl_policy_e policy) {
+   assert(policy < NUM_REPL_POLICIES);
+   return(repl_policy_names[policy]);
+}
+
+bool repl_policy_t::parse(const char *s, repl_policy_e &policy) {
+   for (unsigned int i = 0; i < NUM_REPL_POLICIES; i++) {
+      if (!strcmp(s, repl_policy_names[i])) {
+         policy = (repl_policy_e)i;
+         return(true);
+      }
+   }
+   return(false);
+}
+
+
+////////////////////////////////////
+// LRU
+////////////////////////////////////
+
+lru_repl_t::lru_repl_t(uint64_t sets, uint64_t assoc) : repl_policy_t(sets, assoc) {
+   lru = new uint64_t[sets * assoc];
+}
+
+lru_repl_t::~lru_repl_t() {
+   delete [] lru;
+}
+
+void lru_repl_t::reset() {
+   for (uint64_t s = 0; s < sets; s++)
+      for (uint64_t w = 0; w < assoc; w++)
+         lru[s*assoc + w] = w;
+}
+
+void lru_repl_t::hit(uint64_t set, uint64_t way) {
+   // Make "way" most-recently-used.
+   uint64_t *l = &lru[set*assoc];
+   for (uint64_t i = 0; i < assoc; i++) {
+      if (l[i] < l[way])
+         l[i]++;
+   }
+   l[way] = 0;
+}
+
+uint64_t lru_repl_t::victim(uint64_t set) {
+   uint64_t *l = &lru[set*assoc];
+   for (uint64_t i = 0; i < assoc; i++) {
+      if (l[i] == (assoc - 1))
+         return(i);
+   }
+   assert(0);
+   return(0);
+}
+
+void lru_repl_t::fill(uint64_t set, uint64_t way) {
+   hit(set, way);
+}
+
+void lru_repl_t::invalidate(uint64_t set, uint64_t way) {
+   // Make "way" least-recently-used.
+   uint64_t *l = &lru[set*assoc];
+   for (uint64_t i = 0; i < assoc; i++) {
+      if (l[i] > l[way])
+         l[i]--;
+   }
+   l[way] = assoc - 1;
+}
+
+
+////////////////////////////////////
+// Tree pseudo-LRU
+////////////////////////////////////
+
+plru_repl_t::plru_repl_t(uint64_t sets, uint64_t assoc) : repl_policy_t(sets, assoc) {
+   // Node 0 of each set's heap is unused, so each set takes assoc bits.
+   tree = new bool[sets * assoc];
+}
+
+plru_repl_t::~plru_repl_t() {
+   delete [] tree;
+}
+
+void plru_repl_t::reset() {
+   for (uint64_t i = 0; i < (sets * assoc); i++)
+      tree[i] = false;
+}
+
+void plru_repl_t::hit(uint64_t set, uint64_t way) {
+   // Walk from the root to "way", pointing each bit on the path away from it.
+   bool *t = &tree[set*assoc];
+   uint64_t node = 1;
+   for (uint64_t half = (assoc >> 1); half > 0; half >>= 1) {
+      bool right = ((way & half) != 0);
+      t[node] = !right;
+      node = ((node << 1) | (right ? 1 : 0));
+   }
+}
+
+uint64_t plru_repl_t::victim(uint64_t set) {
+   // Follow the bits from the root.
+   bool *t = &tree[set*assoc];
+   uint64_t node = 1;
+   uint64_t way = 0;
+   for (uint64_t half = (assoc >> 1); half > 0; half >>= 1) {
+      if (t[node])
+         way |= half;
+      node = ((node << 1) | (t[node] ? 1 : 0));
+   }
+   return(way);
+}
+
+void plru_repl_t::fill(uint64_t set, uint64_t way) {
+   hit(set, way);
+}
+
+void plru_repl_t::invalidate(uint64_t set, uint64_t way) {
+   // Walk from the root to "way", pointing each bit on the path toward it.
+   bool *t = &tree[set*assoc];
+   uint64_t node = 1;
+   for (uint64_t half = (assoc >> 1); half > 0; half >>= 1) {
+      bool right = ((way & half) != 0);
+      t[node] = right;
+      node = ((node << 1) | (right ? 1 : 0));
+   }
+}
+
+
+////////////////////////////////////
+// SRRIP, BRRIP and DRRIP
+////////////////////////////////////
+
+#define RRPV_MAX	3	// 2-bit RRPVs
+#define BRRIP_LONG	32	// BRRIP: one fill in BRRIP_LONG predicts a long re-reference
+#define PSEL_MAX	1023	// 10-bit PSEL
+
+rrip_repl_t::rrip_repl_t(repl_policy_e policy, uint64_t sets, uint64_t assoc) : repl_policy_t(sets, assoc) {
+   this->policy = policy;
+   rrpv = new uint8_t[sets * assoc];
+
+   // 32 leader sets per policy when there are enough sets; otherwise, one of each per 4 sets.
+   // A structure with fewer than 4 sets has no leaders, so its sets stay with SRRIP.
+   if (sets >= 128)
+      leader_stride = (sets / 32);
+   else if (sets >= 4)
+      leader_stride = 4;
+   else
+      leader_stride = 0;
+}
+
+rrip_repl_t::~rrip_repl_t() {
+   delete [] rrpv;
+}
+
+void rrip_repl_t::reset() {
+   for (uint64_t i = 0; i < (sets * assoc); i++)
+      rrpv[i] = RRPV_MAX;
+   brrip_count = 0;
+   psel = ((PSEL_MAX + 1) >> 1);
+}
+
+bool rrip_repl_t::use_brrip(uint64_t set) {
+   switch (policy) {
+      case REPL_SRRIP:
+         return(false);
+      case REPL_BRRIP:
+         return(true);
+      default:
+         if (leader_stride && ((set % leader_stride) == 0))
+            return(false);
+         else if (leader_stride && ((set % leader_stride) == (leader_stride - 1)))
+            return(true);
+         else
+            return(psel > (PSEL_MAX >> 1));
+   }
+}
+
+void rrip_repl_t::hit(uint64_t set, uint64_t way) {
+   rrpv[set*assoc + way] = 0;
+}
+
+uint64_t rrip_repl_t::victim(uint64_t set) {
+   // The first way with the largest RRPV. This is the way that would be found by aging the set until a way reaches RRPV_MAX.
+   uint8_t *r = &rrpv[set*assoc];
+   uint64_t way = 0;
+   for (uint64_t i = 1; i < assoc; i++) {
+      if (r[i] > r[way])
+         way = i;
+   }
+   return(way);
+}
+
+void rrip_repl_t::fill(uint64_t set, uint64_t way) {
+   uint8_t *r = &rrpv[set*assoc];
+
+   // Age the set until some way has a distant re-reference.
+   uint8_t max = 0;
+   for (uint64_t i = 0; i < assoc; i++) {
+      if (r[i] > max)
+         max = r[i];
+   }
+   if (max < RRPV_MAX) {
+      for (uint64_t i = 0; i < assoc; i++)
+         r[i] += (RRPV_MAX - max);
+   }
+
+   // Set dueling: a fill is a miss in its set.
+   if ((policy == REPL_DRRIP) && leader_stride) {
+      if ((set % leader_stride) == 0) {
+         if (psel < PSEL_MAX)
+            psel++;
+      }
+      else if ((set % leader_stride) == (leader_stride - 1)) {
+         if (psel > 0)
+            psel--;
+      }
+   }
+
+   // Insertion.
+   if (use_brrip(set)) {
+      brrip_count++;
+      if (brrip_count == BRRIP_LONG) {
+         brrip_count = 0;
+         r[way] = (RRPV_MAX - 1);
+      }
+      else {
+         r[way] = RRPV_MAX;
+      }
+   }
+   else {
+      r[way] = (RRPV_MAX - 1);
+   }
+}
+
+void rrip_repl_t::invalidate(uint64_t set, uint64_t way) {
+   rrpv[set*assoc + way] = RRPV_MAX;
+}
@@ -0,0 +1,122 @@
+#ifndef REPL_POLICY_H
+#define REPL_POLICY_H
+
+#include <cinttypes>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Replacement policies for set-associative structures (cache<T> and btb_t).
+//
+// A policy only keeps replacement state. The structure that owns it keeps the
+// tags and tells the policy about every hit, fill and invalidation:
+// * hit(set, way):        "way" was referenced.
+// * victim(set):          the way to replace next (does not change state).
+// * fill(set, way):       "way" was replaced by a new entry after a miss.
+// * invalidate(set, way): "way" no longer holds an entry.
+//
+// Policies:
+// * LRU:   true LRU, via per-way age ranks. This is the original policy.
+// * PLRU:  tree pseudo-LRU, with assoc-1 bits per set. Assoc must be a
+//          power of two.
+// * SRRIP: static re-reference interval prediction [Jaleel et al., ISCA 2010]
+//          with 2-bit RRPVs. A hit predicts a near re-reference (RRPV 0) and
+//          a fill a long one (RRPV 2). The victim is a way with a distant
+//          re-reference (RRPV 3); if there is none, all RRPVs are aged.
+// * BRRIP: bimodal RRIP. Like SRRIP, except that most fills predict a
+//          distant re-reference, so a scan does not displace the working set.
+//          One fill in 32 predicts a long re-reference; this is done with a
+//          counter rather than randomly, so runs are reproducible.
+// * DRRIP: chooses between SRRIP and BRRIP by set dueling. A few leader sets
+//          always use SRRIP and as many always use BRRIP. A 10-bit saturating
+//          counter (PSEL) counts misses in the SRRIP leaders up and misses in
+//          the BRRIP leaders down. The other sets use BRRIP when PSEL is in
+//          its upper half, otherwise SRRIP.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+typedef enum {
+	REPL_LRU,
+	REPL_PLRU,
+	REPL_SRRIP,
+	REPL_BRRIP,
+	REPL_DRRIP,
+	NUM_REPL_POLICIES
+} repl_policy_e;
+
+class repl_policy_t {
+protected:
+	uint64_t sets;
+	uint64_t assoc;
+
+public:
+	repl_policy_t(uint64_t sets, uint64_t assoc);
+	virtual ~repl_policy_t();
+
+	virtual void reset() = 0;
+	virtual void hit(uint64_t set, uint64_t way) = 0;
+	virtual uint64_t victim(uint64_t set) = 0;
+	virtual void fill(uint64_t set, uint64_t way) = 0;
+	virtual void invalidate(uint64_t set, uint64_t way) = 0;
+
+	// Allocate the policy "policy" for a structure with "sets" sets of "assoc" ways.
+	static repl_policy_t *create(repl_policy_e policy, uint64_t sets, uint64_t assoc);
+
+	// Name of a policy, and the policy with a given name (returns false if there is none).
+	static const char *name(repl_policy_e policy);
+	static bool parse(const char *s, repl_policy_e &policy);
+};
+
+class lru_repl_t : public repl_policy_t {
+private:
+	uint64_t *lru;			// sets*assoc ranks: 0 is the most recently used way of its set
+
+public:
+	lru_repl_t(uint64_t sets, uint64_t assoc);
+	~lru_repl_t();
+	void reset();
+	void hit(uint64_t set, uint64_t way);
+	uint64_t victim(uint64_t set);
+	void fill(uint64_t set, uint64_t way);
+	void invalidate(uint64_t set, uint64_t way);
+};
+
+class plru_repl_t : public repl_policy_t {
+private:
+	// Each set is a binary tree of assoc-1 bits, stored as a heap (node n has children 2n and 2n+1; the root is node 1).
+	// A bit points to the half of its subtree that should be replaced next: 0 is the left (lower ways) half.
+	bool *tree;
+
+public:
+	plru_repl_t(uint64_t sets, uint64_t assoc);
+	~plru_repl_t();
+	void reset();
+	void hit(uint64_t set, uint64_t way);
+	uint64_t victim(uint64_t set);
+	void fill(uint64_t set, uint64_t way);
+	void invalidate(uint64_t set, uint64_t way);
+};
+
+class rrip_repl_t : public repl_policy_t {
+private:
+	repl_policy_e policy;		// REPL_SRRIP, REPL_BRRIP or REPL_DRRIP
+	uint8_t *rrpv;			// sets*assoc re-reference prediction values
+
+	uint64_t brrip_count;		// BRRIP: fills since the last long re-reference fill
+
+	// DRRIP set dueling.
+	uint64_t leader_stride;		// one SRRIP and one BRRIP leader set per "leader_stride" sets (0: no leader sets)
+	uint64_t psel;
+
+	bool use_brrip(uint64_t set);
+
+public:
+	rrip_repl_t(repl_policy_e policy, uint64_t sets, uint64_t assoc);
+	~rrip_repl_t();
+	void reset();
+	void hit(uint64_t set, uint64_t way);
+	uint64_t victim(uint64_t set);
+	void fill(uint64_t set, uint64_t way);
+	void invalidate(uint64_t set, uint64_t way);
+};
+
+#endif //REPL_POLICY_H
@@ -57,6 +57,11 @@ void pipeline_t::retire(size_t& instret) {
         // Sanity checks of the 'amo' and 'csr' flags.
         assert(!amo || IS_AMO(PAY.buf[PAY.head].flags));
         assert(!csr || IS_CSR(PAY.buf[PAY.head].flags));
+
+        // Macro-op fusion: the head of the Active List is a fused instruction. Retire the instruction
+        // that it absorbed first, since it precedes it in program order.
+        if (PAY.buf[PAY.head].absorbed)
+           retire_absorbed(instret);
         
         // If no exception (yet):
         // 1. If the instruction is a load or store, signal the LSU to commit the load or store.
@@ -69,6 +74,8 @@ void pipeline_t::retire(size_t& instret) {
            if (load || store) {
               assert(load != store);   // Make sure that the same instruction does not have both flags set/cleared.
               exception = LSU.commit(load, amo, amo_success,deactivated);
+              if (MDP && store)
+                 MDP->store_retire(PAY.buf[PAY.head].pc, PAY.buf[PAY.head].SQ_index);
               if (amo && store)
                  assert(amo_success);  // Assert store-conditionals (SC) are successful.
            }
@@ -91,6 +98,20 @@ void pipeline_t::retire(size_t& instret) {
         }
 
         if (!exception && !load_viol) {
+           // Eliminated instructions did not read their source registers (see rename2()).
+           // Get the values for the checker now, before commit may free a source register.
+           if (PAY.buf[PAY.head].move_elim || PAY.buf[PAY.head].const_elim) {
+              if (PAY.buf[PAY.head].A_valid)
+                 PAY.buf[PAY.head].A_value.dw = REN->read(PAY.buf[PAY.head].A_phys_reg);
+              if (PAY.buf[PAY.head].B_valid)
+                 PAY.buf[PAY.head].B_value.dw = REN->read(PAY.buf[PAY.head].B_phys_reg);
+              if (PAY.buf[PAY.head].move_elim)
+                 PAY.buf[PAY.head].C_value.dw = PAY.buf[PAY.head].A_value.dw;
+           }
+
+           // Early register release: an instruction that never read its source registers is done with them now.
+           release_sources(PAY.head);
+
            //
            // FIX_ME #17b
            // Commit the instruction at the head of the active list.
@@ -113,12 +134,39 @@ void pipeline_t::retire(size_t& instret) {
              }
            }
 
+           // A multipath join commits its fork's branch queue entry (see fetchunit_t::fetch2()).
+           if (PAY.buf[PAY.head].mp_join)
+              FetchUnit->commit(PAY.buf[PAY.head].pred_tag);
+
+           // Per-hammock measurements.
+           // Instructions squashed by selective recovery are deactivated too, outside of hammocks (see ci_recover()).
+           if (PAY.buf[PAY.head].is_hammock || (deactivated && (PAY.buf[PAY.head].instruction_type != NORMAL)))
+              FetchUnit->commit_hammock(PAY.head, deactivated);
+
+           // Train the predicate predictor with the hammock's committed predicate.
+           if (PP && PAY.buf[PAY.head].is_hammock && !PAY.buf[PAY.head].mp_fork)
+              PP->update(PAY.buf[PAY.head].pp_index, (PAY.buf[PAY.head].C_value.dw == 1));
+
+           // Train the reconvergence predictor with the committed path.
+           if (CI && !deactivated && (PAY.buf[PAY.head].instruction_type == NORMAL) && !PAY.buf[PAY.head].is_hammock) {
+              insn_t inst = PAY.buf[PAY.head].inst;
+              bool cond_branch = (inst.opcode() == OP_BRANCH);
+              bool jump = ((inst.opcode() == OP_JAL) && (inst.rd() == 0));
+              CI->train(PAY.buf[PAY.head].pc,
+                        ((cond_branch || jump) ? PAY.buf[PAY.head].c_next_pc : INCREMENT_PC(PAY.buf[PAY.head].pc)),
+                        (cond_branch ? (PAY.buf[PAY.head].pc + inst.sb_imm()) : 0),
+                        cond_branch, jump);
+           }
 
            if (IS_FP_OP(PAY.buf[PAY.head].flags)) {
               // post the FP exception bit to CSR fflags (the Accrued Exception Flags)
               get_state()->fflags |= PAY.buf[PAY.head].fflags;
            }
 
+           // Train the value predictor with the committed value.
+           if (VP && PAY.buf[PAY.head].vp_eligible)
+              VP->update(PAY.buf[PAY.head].pc, PAY.buf[PAY.head].C_value.dw, PAY.buf[PAY.head].vp_counted);
+
            // Check results.
            if(!deactivated && (PAY.buf[PAY.head].instruction_type != CMOV)) {
             //HP--printf("In checker current PC - %llx\n", PAY.buf[PAY.head].pc);
@@ -181,12 +229,10 @@ void pipeline_t::retire(size_t& instret) {
              // Therefore the load is incorrect and not committed.
              assert(load);
 
-             // If the simple sticky-bit memory dependence predictor is enabled,
-             // add the offending load to the predictor.
-             if (MEM_DEP_PRED) {
-                //assert(MDP.find(PAY.buf[PAY.head].pc) == MDP.end());
-                MDP[PAY.buf[PAY.head].pc] = true;
-             }
+             // If the store-set memory dependence predictor is enabled,
+             // put the offending load and the store that it violated in the same store set.
+             if (MDP)
+                MDP->violation(PAY.buf[PAY.head].pc, PAY.buf[PAY.head].viol_store_pc);
 
              // Full squash, including the mispredicted load, and restart fetching from the load.
              squash_complete(offending_PC);
@@ -234,6 +280,30 @@ void pipeline_t::retire(size_t& instret) {
 }
 
 
+// Macro-op fusion: retire the instruction at the head of PAY, which was absorbed by the fused
+// instruction after it (see pipeline_t::fuse()). It has no Active List entry: the fused instruction
+// committed its destination register, if any, and its execution already finished with it.
+void pipeline_t::retire_absorbed(size_t& instret) {
+   assert(PAY.buf[PAY.head].absorbed && !PAY.buf[PAY.head].split);
+
+   // Train the reconvergence predictor with the committed path.
+   if (CI)
+      CI->train(PAY.buf[PAY.head].pc, INCREMENT_PC(PAY.buf[PAY.head].pc), 0, false, false);
+
+   // Check results.
+   checker();
+
+   // Keep track of the number of retired instructions.
+   num_insn++;
+   instret++;
+   inc_counter(commit_count);
+
+   // Pop the instruction from PAY.
+   PAY.pop();
+   PAY.pop();
+}
+
+
 bool pipeline_t::execute_amo() {
    unsigned int index = PAY.head;
    insn_t inst = PAY.buf[index].inst;
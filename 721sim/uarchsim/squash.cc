@@ -70,6 +70,18 @@ void pipeline_t::squash_complete(reg_t jump_PC) {
 	}
 
 	LSU.flush();
+
+	// The squashed instructions are not recorded for reuse.
+	if (CI)
+	   ci_clear();
+
+	// No instances are in flight for the value predictor.
+	if (VP)
+	   VP->flush();
+
+	// No stores are in flight for the store-set predictor.
+	if (MDP)
+	   MDP->flush();
 }
 
 
@@ -82,10 +94,10 @@ void pipeline_t::resolve(unsigned int branch_ID, bool correct) {
 
 		for (i = 0; i < dispatch_width; i++) {
 			// Rename2 Stage:
-			CLEAR_BIT(RENAME2[i].branch_mask, branch_ID);
+			RENAME2[i].branch_mask.clear(branch_ID);
 
 			// Dispatch Stage:
-			CLEAR_BIT(DISPATCH[i].branch_mask, branch_ID);
+			DISPATCH[i].branch_mask.clear(branch_ID);
 		}
 
 		// Schedule Stage:
@@ -93,14 +105,14 @@ void pipeline_t::resolve(unsigned int branch_ID, bool correct) {
 
 		for (i = 0; i < issue_width; i++) {
 			// Register Read Stage:
-			CLEAR_BIT(Execution_Lanes[i].rr.branch_mask, branch_ID);
+			Execution_Lanes[i].rr.branch_mask.clear(branch_ID);
 
 			// Execute Stage:
 			for (j = 0; j < Execution_Lanes[i].ex_depth; j++)
-			   CLEAR_BIT(Execution_Lanes[i].ex[j].branch_mask, branch_ID);
+			   Execution_Lanes[i].ex[j].branch_mask.clear(branch_ID);
 
 			// Writeback Stage:
-			CLEAR_BIT(Execution_Lanes[i].wb.branch_mask, branch_ID);
+			Execution_Lanes[i].wb.branch_mask.clear(branch_ID);
 		}
 	}
 	else {
@@ -131,19 +143,19 @@ void pipeline_t::resolve(unsigned int branch_ID, bool correct) {
 
 		for (i = 0; i < issue_width; i++) {
 			// Register Read Stage:
-			if (Execution_Lanes[i].rr.valid && BIT_IS_ONE(Execution_Lanes[i].rr.branch_mask, branch_ID)) {
+			if (Execution_Lanes[i].rr.valid && Execution_Lanes[i].rr.branch_mask.test(branch_ID)) {
 				Execution_Lanes[i].rr.valid = false;
 			}
 
 			// Execute Stage:
 			for (j = 0; j < Execution_Lanes[i].ex_depth; j++) {
-			   if (Execution_Lanes[i].ex[j].valid && BIT_IS_ONE(Execution_Lanes[i].ex[j].branch_mask, branch_ID)) {
+			   if (Execution_Lanes[i].ex[j].valid && Execution_Lanes[i].ex[j].branch_mask.test(branch_ID)) {
 				Execution_Lanes[i].ex[j].valid = false;
 			   }
 			}
 
 			// Writeback Stage:
-			if (Execution_Lanes[i].wb.valid && BIT_IS_ONE(Execution_Lanes[i].wb.branch_mask, branch_ID)) {
+			if (Execution_Lanes[i].wb.valid && Execution_Lanes[i].wb.branch_mask.test(branch_ID)) {
 				Execution_Lanes[i].wb.valid = false;
 			}
 		}
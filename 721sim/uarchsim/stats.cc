@@ -10,6 +10,37 @@ stats_t::stats_t(pipeline_t* _proc){
   DECLARE_COUNTER(this, cycle_count               ,proc);
   DECLARE_COUNTER(this, commit_count              ,proc);
   DECLARE_COUNTER(this, ld_vio_count              ,proc);
+  DECLARE_COUNTER(this, mispredict_count          ,proc);
+  DECLARE_COUNTER(this, fetched_inst_count        ,proc);
+  DECLARE_COUNTER(this, pp_lookup_count           ,proc);
+  DECLARE_COUNTER(this, pp_predict_count          ,proc);
+  DECLARE_COUNTER(this, pp_mispredict_count       ,proc);
+  DECLARE_COUNTER(this, pp_cmov_fixup_count       ,proc);
+  DECLARE_COUNTER(this, pp_cmov_reexec_count      ,proc);
+  DECLARE_COUNTER(this, pp_recovery_count         ,proc);
+  DECLARE_COUNTER(this, mp_fork_count             ,proc);
+  DECLARE_COUNTER(this, mp_mispredict_count       ,proc);
+  DECLARE_COUNTER(this, ci_capture_count          ,proc);
+  DECLARE_COUNTER(this, ci_reuse_count            ,proc);
+  DECLARE_COUNTER(this, ci_replay_count           ,proc);
+  DECLARE_COUNTER(this, ci_abort_count            ,proc);
+  DECLARE_COUNTER(this, ci_sel_recovery_count     ,proc);
+  DECLARE_COUNTER(this, ci_sel_replay_count       ,proc);
+  DECLARE_COUNTER(this, move_elim_count           ,proc);
+  DECLARE_COUNTER(this, idiom_elim_count          ,proc);
+  DECLARE_COUNTER(this, early_release_count       ,proc);
+  DECLARE_COUNTER(this, vp_predict_count          ,proc);
+  DECLARE_COUNTER(this, vp_mispredict_count       ,proc);
+  DECLARE_COUNTER(this, fused_count               ,proc);
+  DECLARE_COUNTER(this, mdp_wait_count            ,proc);
+  DECLARE_COUNTER(this, dram_read_count           ,proc);
+  DECLARE_COUNTER(this, dram_write_count          ,proc);
+  DECLARE_COUNTER(this, dram_row_hit_count        ,proc);
+  DECLARE_COUNTER(this, dram_row_miss_count       ,proc);
+  DECLARE_COUNTER(this, dram_row_conflict_count   ,proc);
+  DECLARE_COUNTER(this, dram_rq_full_count        ,proc);
+  DECLARE_COUNTER(this, dram_wq_drain_count       ,proc);
+  DECLARE_COUNTER(this, ic_line_buffer_hit_count  ,proc);
 #if 0
   DECLARE_COUNTER(this, load_count                ,proc);
   DECLARE_COUNTER(this, store_count               ,proc);
@@ -81,6 +112,9 @@ stats_t::stats_t(pipeline_t* _proc){
 
   DECLARE_PHASE_COUNTER(this, cycle_count               ,proc);
   DECLARE_PHASE_COUNTER(this, commit_count              ,proc);
+  DECLARE_PHASE_COUNTER(this, mispredict_count          ,proc);
+  DECLARE_PHASE_COUNTER(this, fetched_inst_count        ,proc);
+  DECLARE_PHASE_COUNTER(this, pp_recovery_count         ,proc);
 
 #if 0
   if(verbose_phase_counters){
@@ -0,0 +1,90 @@
+#include <cinttypes>
+#include <cassert>
+#include "store_set.h"
+
+store_set_t::store_set_t(uint64_t log2_ssit_size, uint64_t log2_lfst_size) {
+   ssit_size = ((uint64_t)1 << log2_ssit_size);
+   ssit_valid = new bool[ssit_size];
+   ssit = new uint64_t[ssit_size];
+
+   lfst_size = ((uint64_t)1 << log2_lfst_size);
+   lfst_valid = new bool[lfst_size];
+   lfst = new unsigned int[lfst_size];
+
+   next_ssid = 0;
+   clear();
+}
+
+store_set_t::~store_set_t() {
+}
+
+bool store_set_t::load(uint64_t pc, unsigned int &sq_index) {
+   uint64_t index = ssit_index(pc);
+   if (!ssit_valid[index] || !lfst_valid[ssit[index]])
+      return(false);
+
+   sq_index = lfst[ssit[index]];
+   return(true);
+}
+
+void store_set_t::store(uint64_t pc, unsigned int sq_index) {
+   uint64_t index = ssit_index(pc);
+   if (ssit_valid[index]) {
+      lfst_valid[ssit[index]] = true;
+      lfst[ssit[index]] = sq_index;
+   }
+}
+
+void store_set_t::store_retire(uint64_t pc, unsigned int sq_index) {
+   uint64_t index = ssit_index(pc);
+   // The store's set may have changed since it was dispatched, or a later store may have replaced it.
+   if (ssit_valid[index] && lfst_valid[ssit[index]] && (lfst[ssit[index]] == sq_index))
+      lfst_valid[ssit[index]] = false;
+}
+
+void store_set_t::violation(uint64_t load_pc, uint64_t store_pc) {
+   uint64_t load_index = ssit_index(load_pc);
+   uint64_t store_index = ssit_index(store_pc);
+   uint64_t ssid;
+
+   if (!ssit_valid[load_index] && !ssit_valid[store_index]) {
+      // Neither has a store set: allocate one.
+      ssid = next_ssid;
+      next_ssid = ((next_ssid + 1) & (lfst_size - 1));
+      lfst_valid[ssid] = false;
+   }
+   else if (!ssit_valid[load_index]) {
+      ssid = ssit[store_index];
+   }
+   else if (!ssit_valid[store_index]) {
+      ssid = ssit[load_index];
+   }
+   else {
+      // Merge: both move to the set with the smaller ID.
+      ssid = ((ssit[load_index] < ssit[store_index]) ? ssit[load_index] : ssit[store_index]);
+   }
+
+   ssit_valid[load_index] = true;
+   ssit[load_index] = ssid;
+   ssit_valid[store_index] = true;
+   ssit[store_index] = ssid;
+}
+
+void store_set_t::restore(unsigned int sq_head, unsigned int sq_length, unsigned int sq_size) {
+   // A squashed store's SQ entry may be reused by an unrelated store.
+   for (uint64_t i = 0; i < lfst_size; i++) {
+      if (lfst_valid[i] && (((lfst[i] + sq_size - sq_head) % sq_size) >= sq_length))
+         lfst_valid[i] = false;
+   }
+}
+
+void store_set_t::flush() {
+   for (uint64_t i = 0; i < lfst_size; i++)
+      lfst_valid[i] = false;
+}
+
+void store_set_t::clear() {
+   for (uint64_t i = 0; i < ssit_size; i++)
+      ssit_valid[i] = false;
+   flush();
+}
@@ -0,0 +1,74 @@
+#ifndef STORE_SET_H
+#define STORE_SET_H
+
+#include <cinttypes>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Store-set memory dependence predictor.
+//
+// With speculative memory disambiguation, a load normally issues ahead of
+// prior stores whose addresses are unknown. A load that caused a load
+// violation should instead wait for the store that it depends on. This
+// predictor identifies that store, so the load waits for it alone and not
+// for every prior store with an unknown address.
+//
+// Two tables are used:
+// * The Store Set ID Table (SSIT) is indexed by load or store PC. It holds
+//   the ID of the instruction's store set, if it has one.
+// * The Last Fetched Store Table (LFST) is indexed by store set ID. It holds
+//   the SQ index of the most recently dispatched store in the set that is
+//   still in flight.
+//
+// A load violation puts the load and the store in the same store set. When a
+// store is dispatched, it becomes its set's last fetched store. When a load
+// is dispatched, it waits for its set's last fetched store, if any.
+//
+// Store sets only grow, so both tables are cleared periodically. Clearing
+// removes stale dependences.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class store_set_t {
+private:
+	uint64_t ssit_size;
+	bool *ssit_valid;
+	uint64_t *ssit;			// store set ID
+
+	uint64_t lfst_size;
+	bool *lfst_valid;
+	unsigned int *lfst;		// SQ index of the last fetched store
+
+	uint64_t next_ssid;		// store set IDs are allocated round-robin
+
+	inline uint64_t ssit_index(uint64_t pc) { return((pc >> 2) & (ssit_size - 1)); }
+
+public:
+	store_set_t(uint64_t log2_ssit_size, uint64_t log2_lfst_size);
+	~store_set_t();
+
+	// A load at "pc" is dispatched.
+	// Returns true if it must wait for a prior store, in which case the store's SQ index is returned in "sq_index".
+	bool load(uint64_t pc, unsigned int &sq_index);
+
+	// A store at "pc" is dispatched into SQ entry "sq_index".
+	void store(uint64_t pc, unsigned int sq_index);
+
+	// The store at "pc" in SQ entry "sq_index" retires: it is no longer its set's last fetched store.
+	void store_retire(uint64_t pc, unsigned int sq_index);
+
+	// The load at "load_pc" violated the store at "store_pc": put them in the same store set.
+	void violation(uint64_t load_pc, uint64_t store_pc);
+
+	// Branch misprediction recovery: the in-flight stores are the "sq_length" SQ entries starting at "sq_head"
+	// (SQ of "sq_size" entries). Last fetched stores outside of them were squashed.
+	void restore(unsigned int sq_head, unsigned int sq_length, unsigned int sq_size);
+
+	// A complete squash: no stores are in flight.
+	void flush();
+
+	// Periodic clearing of both tables.
+	void clear();
+};
+
+#endif //STORE_SET_H
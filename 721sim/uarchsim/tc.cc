@@ -60,6 +60,13 @@ bool tc_t::lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_ta
       // Each instruction in the bundle carries with it, its full pc.
       bundle[pos].pc = pc;
 
+      // The trace cache does not predicate hammocks or fork multipath paths (see btb_t::lookup()).
+      bundle[pos].region_type = NORMAL;
+      bundle[pos].is_hammock = false;
+      bundle[pos].hammock_pc = 0;
+      bundle[pos].mp_fork = false;
+      bundle[pos].mp_join = false;
+
       // Try fetching the instruction via the MMU.
       // Generate a "NOP with fetch exception" if the MMU reference generates an exception.
       bundle[pos].exception = false;
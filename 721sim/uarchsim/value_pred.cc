@@ -0,0 +1,78 @@
+#include <cinttypes>
+#include <cassert>
+#include "value_pred.h"
+
+value_predictor_t::value_predictor_t(uint64_t log2_size, uint64_t conf_threshold) {
+   size = ((uint64_t)1 << log2_size);
+
+   tag = new uint64_t[size];
+   last = new uint64_t[size];
+   stride = new int64_t[size];
+   conf = new uint8_t[size];
+   inflight = new uint64_t[size];
+   for (uint64_t i = 0; i < size; i++) {
+      tag[i] = 0;
+      last[i] = 0;
+      stride[i] = 0;
+      conf[i] = 0;	// Initialize counters to not confident.
+      inflight[i] = 0;
+   }
+
+   // Confidence counters are 4 bits.
+   conf_max = 15;
+   assert(conf_threshold <= conf_max);
+   this->conf_threshold = (uint8_t)conf_threshold;
+}
+
+value_predictor_t::~value_predictor_t() {
+}
+
+bool value_predictor_t::predict(uint64_t pc, uint64_t &value, bool &counted) {
+   uint64_t index = ((pc >> 2) & (size - 1));
+   counted = (tag[index] == pc);
+   if (!counted)
+      return(false);
+
+   inflight[index]++;
+   value = last[index] + (uint64_t)(stride[index] * (int64_t)inflight[index]);
+   return(conf[index] >= conf_threshold);
+}
+
+void value_predictor_t::update(uint64_t pc, uint64_t value, bool counted) {
+   uint64_t index = ((pc >> 2) & (size - 1));
+
+   if (counted)
+      squash(pc);
+
+   if (tag[index] != pc) {
+      // Replace the entry.
+      tag[index] = pc;
+      last[index] = value;
+      stride[index] = 0;
+      conf[index] = 0;
+      inflight[index] = 0;
+      return;
+   }
+
+   // Resetting confidence counter: increment if the stride would have predicted correctly, else reset.
+   if ((last[index] + (uint64_t)stride[index]) == value) {
+      if (conf[index] < conf_max)
+         conf[index]++;
+   }
+   else {
+      conf[index] = 0;
+      stride[index] = (int64_t)(value - last[index]);
+   }
+   last[index] = value;
+}
+
+void value_predictor_t::squash(uint64_t pc) {
+   uint64_t index = ((pc >> 2) & (size - 1));
+   if ((tag[index] == pc) && (inflight[index] > 0))
+      inflight[index]--;
+}
+
+void value_predictor_t::flush() {
+   for (uint64_t i = 0; i < size; i++)
+      inflight[i] = 0;
+}
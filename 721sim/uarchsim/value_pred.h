@@ -0,0 +1,64 @@
+#ifndef VALUE_PRED_H
+#define VALUE_PRED_H
+
+#include <cinttypes>
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Stride value predictor.
+//
+// Predicts the destination value of loads and integer ALU instructions, so
+// that their consumers do not wait for them to execute.
+//
+// The predictor is consulted in the Dispatch Stage. If the prediction is
+// confident, the predicted value is written into the destination physical
+// register, which is marked ready. The instruction still executes, and the
+// Writeback Stage compares its actual value against the predicted one. On a
+// mismatch, the instruction is marked as value-mispredicted in the Active
+// List: it commits, and everything after it is squashed (the same recovery
+// as for serializing instructions).
+//
+// Each entry has a PC tag, the last committed value, a stride, and a
+// resetting confidence counter. Last-value prediction is the special case of
+// a zero stride. The predictor is trained at retirement.
+//
+// Instances of the same instruction may be in flight at the same time. Each
+// entry counts its in-flight instances, so the n-th instance is predicted as
+// last + n * stride. An instance leaves the count when it retires or is
+// squashed by a mispredicted branch, and all counts are cleared on a complete
+// squash.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+class value_predictor_t {
+private:
+	uint64_t size;
+	uint64_t *tag;			// instruction PC
+	uint64_t *last;			// last committed value
+	int64_t *stride;
+	uint8_t *conf;			// resetting confidence counters
+	uint64_t *inflight;		// predicted instances not yet retired
+	uint8_t conf_max;
+	uint8_t conf_threshold;
+
+public:
+	value_predictor_t(uint64_t log2_size, uint64_t conf_threshold);
+	~value_predictor_t();
+
+	// Look up the instruction at "pc".
+	// Returns true if there is a confident prediction, in which case it is returned in "value".
+	// "counted" indicates whether the instance was counted as in flight: it must be passed back to
+	// update() or squash().
+	bool predict(uint64_t pc, uint64_t &value, bool &counted);
+
+	// Train the entry of the instruction at "pc" with its committed value.
+	void update(uint64_t pc, uint64_t value, bool counted);
+
+	// A counted instance of the instruction at "pc" was squashed.
+	void squash(uint64_t pc);
+
+	// A complete squash: no instances are in flight.
+	void flush();
+};
+
+#endif //VALUE_PRED_H
@@ -1,4 +1,5 @@
 #include "pipeline.h"
+#include "debug.h"
 
 
 void pipeline_t::writeback(unsigned int lane_number) {
@@ -91,13 +92,35 @@ void pipeline_t::writeback(unsigned int lane_number) {
                resolve(PAY.buf[index].branch_ID,true);
 	    // FIX_ME #15b END
          }
+         else if (CI && RECONV_SELECTIVE && ci_recover(index)) {
+            // Branch was mispredicted: only its wrong-path instructions before the reconvergence point were squashed.
+            inc_counter(mispredict_count);
+         }
          else {
             // Branch was mispredicted.
+            inc_counter(mispredict_count);
+
+            // Record the control-independent instructions after the branch's reconvergence point, before they are squashed.
+            if (CI) {
+               ci_clear();
+               if (!PAY.buf[index].mp_join)
+                  ci_capture(index);
+            }
+
             //printf("MISPREDICTED PC - %llx\n", PAY.buf[index].pc);
             // Roll-back the Fetch Unit.
-            FetchUnit->mispredict(PAY.buf[index].pred_tag,
-	    			  (PAY.buf[index].c_next_pc != INCREMENT_PC(PAY.buf[index].pc)),
-				  PAY.buf[index].c_next_pc);
+            // A multipath join corrects its fork's branch queue entry: the fork's direction is the predicate.
+            if (PAY.buf[index].mp_join) {
+               inc_counter(mp_mispredict_count);
+               FetchUnit->mispredict(PAY.buf[index].pred_tag,
+                                     (PAY.buf[index].D_value.dw == 1),
+                                     PAY.buf[index].c_next_pc);
+            }
+            else {
+               FetchUnit->mispredict(PAY.buf[index].pred_tag,
+                                     (PAY.buf[index].c_next_pc != INCREMENT_PC(PAY.buf[index].pc)),
+                                     PAY.buf[index].c_next_pc);
+            }
  
             // FIX_ME #15c
             // The simulator is running in real branch prediction mode, and the branch was mispredicted.
@@ -122,6 +145,13 @@ void pipeline_t::writeback(unsigned int lane_number) {
             // Restore the LQ/SQ.
             LSU.restore(PAY.buf[index].LQ_index, PAY.buf[index].LQ_phase, PAY.buf[index].SQ_index, PAY.buf[index].SQ_phase);
 
+            // The squashed stores are no longer their sets' last fetched stores.
+            if (MDP) {
+               unsigned int sq_head, sq_length, sq_size;
+               LSU.get_sq(sq_head, sq_length, sq_size);
+               MDP->restore(sq_head, sq_length, sq_size);
+            }
+
             // FIX_ME #15d
             // Squash instructions after the branch in program order, in all pipeline registers and the IQ.
             //
@@ -138,6 +168,16 @@ void pipeline_t::writeback(unsigned int lane_number) {
                resolve(PAY.buf[index].branch_ID,false);
             // FIX_ME #15d END
 
+            // The squashed instructions no longer read their source registers (early register release),
+            // and are no longer in flight for the value predictor.
+            if (EARLY_RELEASE || VP) {
+               for (unsigned int j = MOD((index + 2), PAYLOAD_BUFFER_SIZE); j != PAY.tail; j = MOD((j + 2), PAYLOAD_BUFFER_SIZE)) {
+                  release_sources(j);
+                  if (PAY.buf[j].vp_counted)
+                     VP->squash(PAY.buf[j].pc);
+               }
+            }
+
             // Rollback PAY to the point of the branch.
             PAY.rollback(index);
          }
@@ -154,7 +194,10 @@ void pipeline_t::writeback(unsigned int lane_number) {
 
       // FIX_ME #16 BEGIN
          REN->set_complete(PAY.buf[index].AL_index);
+         PAY.buf[index].wb_done = true;
          if(PAY.buf[index].is_hammock) REN->predicate_done(PAY.buf[index].AL_index, PAY.buf[index].C_phys_reg, PAY.buf[index].C_value.dw);
+         if(PAY.buf[index].is_hammock && PAY.buf[index].pp_valid) predicate_replay(index);
+         vp_verify(index);
       // FIX_ME #16 END
 
       //////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -163,3 +206,374 @@ void pipeline_t::writeback(unsigned int lane_number) {
       Execution_Lanes[lane_number].wb.valid = false;
    }
 }
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Verify the predicted predicate of a hammock that just resolved.
+//
+// If the prediction was wrong, walk the hammock's CMOVs (they follow the hammock in PAY, after its
+// THEN/ELSE instructions) and selectively repair them:
+// * A CMOV that has not executed yet simply picks up the actual predicate.
+// * A CMOV that already executed is re-executed in place: its value is recomputed from the A/B values it
+//   already read, and rewritten to its destination physical register. Consumers that have not read their
+//   source operands yet will read the corrected value.
+// Only if a re-executed CMOV's value changed AND a consumer already read the stale value, is the hammock
+// marked for recovery: when it retires, everything after it is squashed and fetch restarts at the
+// hammock's computed next PC ("approach #1 recovery", see retire.cc).
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+void pipeline_t::predicate_replay(unsigned int index) {
+   bool predicate = (PAY.buf[index].C_value.dw == 1);
+   bool seen_cmov = false;
+   bool recover = false;
+   unsigned int i, j, reg;
+   reg_t value;
+
+   assert(PAY.buf[index].is_hammock && PAY.buf[index].pp_valid);
+
+   if (predicate == PAY.buf[index].pp_predicate)
+      return;
+
+   inc_counter(pp_mispredict_count);
+
+   // Each instruction is allocated two PAY entries.
+   for (i = MOD((index + 2), PAYLOAD_BUFFER_SIZE); i != PAY.tail; i = MOD((i + 2), PAYLOAD_BUFFER_SIZE)) {
+      if (PAY.buf[i].instruction_type != CMOV) {
+         if (seen_cmov)
+            break;	// Past the last CMOV of this hammock.
+         continue;	// THEN/ELSE instruction.
+      }
+      seen_cmov = true;
+
+      // pp_valid is clear if the CMOV found the predicate ready at dispatch, i.e., it did not predict.
+      if (!PAY.buf[i].pp_valid)
+         continue;
+
+      PAY.buf[i].pp_predicate = predicate;
+
+      if (!PAY.buf[i].pp_executed) {
+         inc_counter(pp_cmov_fixup_count);
+         continue;
+      }
+
+      inc_counter(pp_cmov_reexec_count);
+      value = (predicate ? PAY.buf[i].B_value.dw : PAY.buf[i].A_value.dw);
+      if (value == PAY.buf[i].C_value.dw)
+         continue;	// Both sides agree: the stale value is correct.
+
+      PAY.buf[i].C_value.dw = value;
+      REN->write(PAY.buf[i].C_phys_reg, value);
+
+      // Did any consumer already read the stale value?
+      reg = PAY.buf[i].C_phys_reg;
+      for (j = MOD((i + 2), PAYLOAD_BUFFER_SIZE); !recover && (j != PAY.tail); j = MOD((j + 2), PAYLOAD_BUFFER_SIZE)) {
+         if (PAY.buf[j].src_read &&
+             ((PAY.buf[j].A_valid && (PAY.buf[j].A_phys_reg == reg)) ||
+              (PAY.buf[j].B_valid && (PAY.buf[j].B_phys_reg == reg)) ||
+              (PAY.buf[j].D_valid && (PAY.buf[j].D_phys_reg == reg))))
+            recover = true;
+      }
+   }
+
+   if (recover) {
+      REN->set_branch_misprediction(PAY.buf[index].AL_index);
+      inc_counter(pp_recovery_count);
+   }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Control-independent squash reuse: the branch at 'index' mispredicted.
+//
+// If the reconvergence predictor has a confident reconvergence PC (RPC) for the branch, find the first
+// instance of the RPC on the wrong path, and record the instructions from it to the tail of PAY (up to
+// RECONV_WINDOW instructions), before they are squashed. The correct path is expected to fetch the same
+// instructions again once it reaches the RPC (see pipeline_t::ci_reuse()).
+//
+// Only integer ALU instructions that already finished executing are reusable: their result is a function
+// of the instruction, its PC, and its source values. Loads, stores, FP, and system instructions are
+// recorded only to keep the sequence aligned.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+void pipeline_t::ci_capture(unsigned int index) {
+   uint64_t rpc;
+   unsigned int i;
+   ci_entry_t entry;
+
+   assert(CI && ci_buf.empty());
+
+   if ((PAY.buf[index].inst.opcode() != OP_BRANCH) || !CI->predict(PAY.buf[index].pc, rpc))
+      return;
+
+   // Each instruction is allocated two PAY entries.
+   for (i = MOD((index + 2), PAYLOAD_BUFFER_SIZE); i != PAY.tail; i = MOD((i + 2), PAYLOAD_BUFFER_SIZE)) {
+      if (PAY.buf[i].pc == rpc)
+         break;
+   }
+
+   for (; (i != PAY.tail) && (ci_buf.size() < RECONV_WINDOW); i = MOD((i + 2), PAYLOAD_BUFFER_SIZE)) {
+      // Absorbed instructions are not dispatched (see pipeline_t::fuse()).
+      if (PAY.buf[i].absorbed)
+         continue;
+
+      entry.pc = PAY.buf[i].pc;
+      entry.bits = (uint32_t)PAY.buf[i].inst.bits();
+      switch (PAY.buf[i].inst.opcode()) {
+         case OP_OP:
+         case OP_OP_32:
+         case OP_OP_IMM:
+         case OP_OP_IMM_32:
+         case OP_LUI:
+         case OP_AUIPC:
+            entry.reusable = (PAY.buf[i].wb_done && PAY.buf[i].C_valid && (PAY.buf[i].instruction_type == NORMAL) && !PAY.buf[i].fused);
+            break;
+
+         default:
+            entry.reusable = false;
+            break;
+      }
+      entry.A_value = PAY.buf[i].A_value.dw;
+      entry.B_value = PAY.buf[i].B_value.dw;
+      entry.C_value = PAY.buf[i].C_value.dw;
+      ci_buf.push_back(entry);
+   }
+
+   if (!ci_buf.empty())
+      inc_counter(ci_capture_count);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Control-independent selective recovery (RECONV_SELECTIVE): the branch at 'index' mispredicted.
+//
+// It applies when the branch was predicted not-taken, is taken, and its taken target is its confident
+// reconvergence point (RPC): the wrong path is the skipped if-then body, followed by the RPC and the
+// control-independent instructions after it. Only the wrong-path instructions before the RPC are squashed:
+// * They stay in the Active List and LQ, deactivated like the instructions on the not-taken path of a DHP
+//   hammock: they commit without updating the architectural state. Their RMT writes are removed (see
+//   renamer::squash_writes()), so that the RMT maps their logical registers as before them.
+// * Renamed instructions after the RPC that read a register written by a squashed instruction are renamed
+//   again, in PAY and in the IQ, to the register mapped before the squashed instructions. Instructions that
+//   are not renamed yet are renamed with the repaired RMT.
+// * Such an instruction that already read the register (or an eliminated move of it) is replayed: the
+//   instruction before it is marked as mispredicted in the Active List, so that the Retire Stage squashes
+//   everything after it once it retires.
+//
+// Returns false without changing anything if the misprediction does not have this shape, or the wrong-path
+// instructions before the RPC are not straight-line integer code without stores, all in the Active List. The
+// caller then squashes everything after the branch as usual. Instructions cannot be inserted into the
+// Active List, LQ/SQ, and PAY, so the reverse case (predicted taken: the if-then body is missing) always
+// takes a full squash.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Find the register that replaces physical register 'tag' (see pipeline_t::ci_recover()).
+static bool ci_remap(const std::vector<unsigned int> &from, const std::vector<unsigned int> &to, unsigned int tag, unsigned int &new_tag) {
+   for (unsigned int k = 0; k < from.size(); k++) {
+      if (from[k] == tag) {
+         new_tag = to[k];
+         return(true);
+      }
+   }
+   return(false);
+}
+
+bool pipeline_t::ci_recover(unsigned int index) {
+   uint64_t rpc;
+   unsigned int rpc_index;
+   unsigned int frontier;		// oldest instruction that is not renamed yet
+   unsigned int undispatched;		// oldest instruction that is not in the Active List yet
+   unsigned int last;			// last kept instruction before the first replayed one
+   bool last_dispatched;
+   unsigned int prev;
+   bool prev_dispatched;
+   bool replay;
+   bool dispatched;
+   bool read;
+   unsigned int i, j, k, n;
+   unsigned int new_tag;
+   std::vector<unsigned int> log_reg;	// for each squashed RMT write: logical register,
+   std::vector<unsigned int> from;	// the squashed instruction's destination register,
+   std::vector<unsigned int> to;	// and the register mapped before the squashed instructions
+   std::vector<unsigned int> fix;	// kept instructions that are renamed again
+
+   if (ORACLE_DISAMBIG ||
+       (PAY.buf[index].inst.opcode() != OP_BRANCH) ||
+       (PAY.buf[index].instruction_type != NORMAL) || PAY.buf[index].is_hammock || PAY.buf[index].mp_fork || PAY.buf[index].mp_join ||
+       (PAY.buf[index].next_pc != INCREMENT_PC(PAY.buf[index].pc)) ||
+       !CI->predict(PAY.buf[index].pc, rpc) || (rpc != PAY.buf[index].c_next_pc))
+      return(false);
+
+   // Instructions go through the frontend stages in program order.
+   if (RENAME2[0].valid)
+      frontier = RENAME2[0].index;
+   else if (FQ.get_length() > 0)
+      frontier = FQ.peek();
+   else if (DECODE[0].valid)
+      frontier = DECODE[0].index;
+   else if (!FetchUnit->fetch2_index(frontier))
+      frontier = PAY.tail;
+   undispatched = (DISPATCH[0].valid ? DISPATCH[0].index : frontier);
+
+   // The wrong-path instructions before the RPC.
+   // Each one with a destination register made one RMT write, in order after the branch's checkpoint.
+   n = 0;
+   for (i = MOD((index + 2), PAYLOAD_BUFFER_SIZE); ; i = MOD((i + 2), PAYLOAD_BUFFER_SIZE)) {
+      if (i == PAY.tail)
+         return(false);
+      if (PAY.buf[i].pc == rpc)
+         break;
+      if ((i == undispatched) || (n == RECONV_WINDOW))
+         return(false);
+      if ((PAY.buf[i].instruction_type != NORMAL) || PAY.buf[i].is_hammock || PAY.buf[i].mp_fork || PAY.buf[i].mp_join ||
+          PAY.buf[i].fused || PAY.buf[i].absorbed || PAY.buf[i].move_elim || PAY.buf[i].checkpoint ||
+          (PAY.buf[i].iq != SEL_IQ) || PAY.buf[i].trap.valid() ||
+          IS_BRANCH(PAY.buf[i].flags) || IS_STORE(PAY.buf[i].flags) || IS_AMO(PAY.buf[i].flags) ||
+          IS_CSR(PAY.buf[i].flags) || IS_FP_OP(PAY.buf[i].flags))
+         return(false);
+      n++;
+   }
+   rpc_index = i;
+   if (n == 0)
+      return(false);
+
+   for (i = MOD((index + 2), PAYLOAD_BUFFER_SIZE); i != rpc_index; i = MOD((i + 2), PAYLOAD_BUFFER_SIZE)) {
+      if (PAY.buf[i].C_valid) {
+         // The first squashed write of a logical register logged the mapping from before all of them.
+         for (k = 0; (k < log_reg.size()) && (log_reg[k] != PAY.buf[i].C_log_reg); k++);
+         new_tag = ((k < log_reg.size()) ? to[k] :
+                    REN->get_logged_mapping(PAY.buf[index].branch_ID, log_reg.size(), PAY.buf[i].C_log_reg));
+         log_reg.push_back(PAY.buf[i].C_log_reg);
+         from.push_back(PAY.buf[i].C_phys_reg);
+         to.push_back(new_tag);
+      }
+   }
+
+   // The renamed instructions after the RPC that read a squashed instruction's destination register.
+   // The first one that already read it (or is about to, in the Register Read Stage), or shares it (an
+   // eliminated move), is replayed with everything after it. All others are renamed again, even after it:
+   // the squashed instruction's destination register is freed when it commits, and may be reallocated.
+   replay = false;
+   last = index;
+   last_dispatched = false;
+   dispatched = true;
+   prev = index;
+   prev_dispatched = false;
+   for (j = rpc_index; j != frontier; j = MOD((j + 2), PAYLOAD_BUFFER_SIZE)) {
+      if (j == undispatched)
+         dispatched = false;
+
+      // Absorbed instructions are not renamed (see pipeline_t::fuse()).
+      if (PAY.buf[j].absorbed)
+         continue;
+
+      if ((PAY.buf[j].A_valid && ci_remap(from, to, PAY.buf[j].A_phys_reg, new_tag)) ||
+          (PAY.buf[j].B_valid && ci_remap(from, to, PAY.buf[j].B_phys_reg, new_tag)) ||
+          (PAY.buf[j].D_valid && ci_remap(from, to, PAY.buf[j].D_phys_reg, new_tag))) {
+         read = (PAY.buf[j].src_read || PAY.buf[j].move_elim);
+         for (k = 0; k < issue_width; k++)
+            read = (read || (Execution_Lanes[k].rr.valid && (Execution_Lanes[k].rr.index == j)));
+         if (!read) {
+            fix.push_back(j);
+         }
+         else if (!replay) {
+            replay = true;
+            last = prev;
+            last_dispatched = prev_dispatched;
+         }
+      }
+
+      prev = j;
+      prev_dispatched = dispatched;
+   }
+
+   // The replay is triggered by the retirement of the last kept instruction, which must not be deactivated.
+   if (replay &&
+       ((last == index) || !last_dispatched ||
+        (PAY.buf[last].instruction_type != NORMAL) || PAY.buf[last].is_hammock || PAY.buf[last].mp_fork || PAY.buf[last].mp_join))
+      return(false);
+
+   //
+   // Recover.
+   //
+   inc_counter(ci_sel_recovery_count);
+
+   for (i = MOD((index + 2), PAYLOAD_BUFFER_SIZE); i != rpc_index; i = MOD((i + 2), PAYLOAD_BUFFER_SIZE)) {
+      REN->deactivate(PAY.buf[i].AL_index);
+      PAY.buf[i].good_instruction = false;
+      PAY.buf[i].db_index = DEBUG_INDEX_INVALID;
+
+      // It is no longer in flight for the value predictor, and does not train it.
+      if (PAY.buf[i].vp_counted)
+         VP->squash(PAY.buf[i].pc);
+      PAY.buf[i].vp_counted = false;
+      PAY.buf[i].vp_eligible = false;
+      PAY.buf[i].vp_valid = false;
+   }
+   REN->squash_writes(PAY.buf[index].branch_ID, from.size());
+
+   for (k = 0; k < fix.size(); k++) {
+      j = fix[k];
+      if (PAY.buf[j].A_valid && ci_remap(from, to, PAY.buf[j].A_phys_reg, new_tag)) {
+         if (PAY.buf[j].src_pending) {
+            REN->read_done(PAY.buf[j].A_phys_reg);
+            REN->add_reader(new_tag);
+         }
+         IQ.rename_source(j, PAY.buf[j].A_phys_reg, new_tag, REN->is_ready(new_tag));
+         PAY.buf[j].A_phys_reg = new_tag;
+      }
+      if (PAY.buf[j].B_valid && ci_remap(from, to, PAY.buf[j].B_phys_reg, new_tag)) {
+         if (PAY.buf[j].src_pending) {
+            REN->read_done(PAY.buf[j].B_phys_reg);
+            REN->add_reader(new_tag);
+         }
+         IQ.rename_source(j, PAY.buf[j].B_phys_reg, new_tag, REN->is_ready(new_tag));
+         PAY.buf[j].B_phys_reg = new_tag;
+      }
+      if (PAY.buf[j].D_valid && ci_remap(from, to, PAY.buf[j].D_phys_reg, new_tag)) {
+         if (PAY.buf[j].src_pending) {
+            REN->read_done(PAY.buf[j].D_phys_reg);
+            REN->add_reader(new_tag);
+         }
+         IQ.rename_source(j, PAY.buf[j].D_phys_reg, new_tag, REN->is_ready(new_tag));
+         PAY.buf[j].D_phys_reg = new_tag;
+      }
+   }
+
+   if (replay) {
+      inc_counter(ci_sel_replay_count);
+      if (IS_BRANCH(PAY.buf[last].flags))
+         set_branch_misprediction(PAY.buf[last].AL_index);
+      else
+         set_value_misprediction(PAY.buf[last].AL_index);
+   }
+
+   // The instructions from the RPC on now follow the branch (see payload::map_to_actual()).
+   if (PAY.buf[index].good_instruction) {
+      PAY.buf[rpc_index].db_index = get_pipe()->check_next(PAY.buf[index].db_index, rpc);
+      PAY.buf[rpc_index].good_instruction = (PAY.buf[rpc_index].db_index != DEBUG_INDEX_INVALID);
+   }
+   else {
+      PAY.buf[rpc_index].good_instruction = false;
+      PAY.buf[rpc_index].db_index = DEBUG_INDEX_INVALID;
+   }
+   for (j = MOD((rpc_index + 2), PAYLOAD_BUFFER_SIZE); j != PAY.tail; j = MOD((j + 2), PAYLOAD_BUFFER_SIZE))
+      PAY.map_to_actual(this, j);
+
+   // The branch resolved: correct its branch queue entry, and free its checkpoint and branch mask bit.
+   FetchUnit->reconverge(PAY.buf[index].pred_tag, true, PAY.buf[index].c_next_pc);
+   REN->resolve(PAY.buf[index].AL_index, PAY.buf[index].branch_ID, true);
+   resolve(PAY.buf[index].branch_ID, true);
+   return(true);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Value prediction: the instruction at 'index' has its actual value (see value_pred.h).
+//
+// If its consumers were given a different predicted value, mark the instruction as value-mispredicted in
+// the Active List. It commits with its actual value, and the Retire Stage squashes everything after it.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+void pipeline_t::vp_verify(unsigned int index) {
+   if (PAY.buf[index].vp_valid && (PAY.buf[index].C_value.dw != PAY.buf[index].vp_value)) {
+      inc_counter(vp_mispredict_count);
+      set_value_misprediction(PAY.buf[index].AL_index);
+   }
+}